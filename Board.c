@@ -10,19 +10,51 @@
 #include <string.h>
 
 #include "Board.h"
+#include "Evaluation.h"
+#include "Magic.h"
 #include "Utility.h"
 
 #define OFF_BOARD UCHAR_MAX
 
 static const char pieceNames[] = " PNBRQK  pnbrqk ";
 
-// This is expected to give us 0b00001000 and 0b00000111
-static const char COLOR_BIT = BLACK_PAWN - WHITE_PAWN;
-static const char COLOR_MASK = BLACK_PAWN - WHITE_PAWN - 1;
+// Piece values for static exchange evaluation, indexed by ColorlessPiece. Knights and bishops are equal
+// so that trading one for the other comes out even. The king is worth more than anything it could be
+// traded for, although as a king can't be captured that only matters for deciding when to stop
+static const int exchangeValues[ 7 ] = { 0, 100, 300, 300, 500, 900, 20000 };
+
+// The longest possible sequence of captures on one square, with every piece on the board taking part
+#define MAX_EXCHANGES 32
 
 static unsigned long knightDirections[ 64 ][ 8 ];
 static unsigned long kingDirections[ 64 ][ 8 ];
 
+// Attack sets by square. Pawn attacks are indexed by color as well, with 0 for white and 1 for black
+static unsigned long long knightAttacks[ 64 ];
+static unsigned long long kingAttacks[ 64 ];
+static unsigned long long pawnAttacks[ 2 ][ 64 ];
+
+// For two squares on the same rank, file or diagonal, the squares strictly between them and the
+// whole line through them. Empty for squares that don't share a line
+static unsigned long long betweenSquares[ 64 ][ 64 ];
+static unsigned long long lineThrough[ 64 ][ 64 ];
+
+// Random numbers for hashing positions (Zobrist keys). Pieces are indexed by the Piece enum, castling
+// by the CastlingRights bits and en passant by file
+static unsigned long long zobristPieces[ 16 ][ 64 ];
+static unsigned long long zobristCastling[ 16 ];
+static unsigned long long zobristEnPassant[ 8 ];
+static unsigned long long zobristBlackToMove;
+
+// The evaluation terms of each piece on each square, indexed by Piece, from Evaluation
+static int middlegameScores[ 16 ][ 64 ];
+static int endgameScores[ 16 ][ 64 ];
+static int phaseScores[ 16 ];
+
+static bool initialized = false;
+
+static unsigned long long Board_random( unsigned long long* seed );
+
 void Board_create( Board* board, const char* fen )
 {
     Board_initialize( board );
@@ -64,6 +96,11 @@ void Board_create( Board* board, const char* fen )
 
     free( fenCopy );
 
+    board->key = Board_computeKey( board );
+    board->pawnKey = Board_computePawnKey( board );
+    board->materialKey = Board_computeMaterialKey( board );
+    Board_computeEvaluation( board );
+
     //Board_printBoard( board );
     //char x[ 256 ];
     //Board_exportBoard( board, x );
@@ -72,6 +109,14 @@ void Board_create( Board* board, const char* fen )
 
 static void Board_initialize()
 {
+    if ( initialized )
+    {
+        return;
+    }
+
+    Magic_initialize();
+    Evaluation_fillTables( middlegameScores, endgameScores, phaseScores );
+
     // Create an array of knight moves and record which are possible from each starting square
     short knightMoves[8][2] =
     { 
@@ -151,6 +196,113 @@ static void Board_initialize()
             }
         }
     }
+
+    // The same again, as bitboards
+    for ( unsigned long index = 0; index < 64; index++ )
+    {
+        knightAttacks[ index ] = 0;
+        kingAttacks[ index ] = 0;
+
+        for ( short loop = 0; loop < 8; loop++ )
+        {
+            if ( knightDirections[ index ][ loop ] != 0 )
+            {
+                knightAttacks[ index ] |= 1ull << ( index + knightDirections[ index ][ loop ] );
+            }
+            if ( kingDirections[ index ][ loop ] != 0 )
+            {
+                kingAttacks[ index ] |= 1ull << ( index + kingDirections[ index ][ loop ] );
+            }
+        }
+
+        const unsigned long rank = Board_rankFromIndex( index );
+        const unsigned long file = Board_fileFromIndex( index );
+
+        pawnAttacks[ 0 ][ index ] = 0;
+        pawnAttacks[ 1 ][ index ] = 0;
+
+        if ( rank < 7 )
+        {
+            if ( file > 0 )
+            {
+                pawnAttacks[ 0 ][ index ] |= 1ull << ( index + 7 );
+            }
+            if ( file < 7 )
+            {
+                pawnAttacks[ 0 ][ index ] |= 1ull << ( index + 9 );
+            }
+        }
+        if ( rank > 0 )
+        {
+            if ( file > 0 )
+            {
+                pawnAttacks[ 1 ][ index ] |= 1ull << ( index - 9 );
+            }
+            if ( file < 7 )
+            {
+                pawnAttacks[ 1 ][ index ] |= 1ull << ( index - 7 );
+            }
+        }
+    }
+
+    for ( unsigned long from = 0; from < 64; from++ )
+    {
+        for ( unsigned long to = 0; to < 64; to++ )
+        {
+            const unsigned long long fromBit = 1ull << from;
+            const unsigned long long toBit = 1ull << to;
+
+            betweenSquares[ from ][ to ] = 0;
+            lineThrough[ from ][ to ] = 0;
+
+            if ( from == to )
+            {
+                continue;
+            }
+
+            if ( Magic_bishopAttacks( from, 0 ) & toBit )
+            {
+                betweenSquares[ from ][ to ] = Magic_bishopAttacks( from, toBit ) & Magic_bishopAttacks( to, fromBit );
+                lineThrough[ from ][ to ] = ( Magic_bishopAttacks( from, 0 ) & Magic_bishopAttacks( to, 0 ) ) | fromBit | toBit;
+            }
+            else if ( Magic_rookAttacks( from, 0 ) & toBit )
+            {
+                betweenSquares[ from ][ to ] = Magic_rookAttacks( from, toBit ) & Magic_rookAttacks( to, fromBit );
+                lineThrough[ from ][ to ] = ( Magic_rookAttacks( from, 0 ) & Magic_rookAttacks( to, 0 ) ) | fromBit | toBit;
+            }
+        }
+    }
+
+    // Fixed seed so that keys are the same from one run to the next
+    unsigned long long seed = 0x2545f4914f6cdd1dull;
+
+    for ( unsigned short piece = 0; piece < 16; piece++ )
+    {
+        for ( unsigned short index = 0; index < 64; index++ )
+        {
+            zobristPieces[ piece ][ index ] = Board_random( &seed );
+        }
+    }
+    for ( unsigned short loop = 0; loop < 16; loop++ )
+    {
+        zobristCastling[ loop ] = Board_random( &seed );
+    }
+    for ( unsigned short loop = 0; loop < 8; loop++ )
+    {
+        zobristEnPassant[ loop ] = Board_random( &seed );
+    }
+    zobristBlackToMove = Board_random( &seed );
+
+    initialized = true;
+}
+
+static unsigned long long Board_random( unsigned long long* seed )
+{
+    // splitmix64
+    unsigned long long value = ( *seed += 0x9e3779b97f4a7c15ull );
+    value = ( value ^ ( value >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+    value = ( value ^ ( value >> 27 ) ) * 0x94d049bb133111ebull;
+    return value ^ ( value >> 31 );
 }
 
 void Board_clearBoard( Board* self )
@@ -185,6 +337,16 @@ void Board_clearBoard( Board* self )
     self->halfmoveClock = 0;
     self->fullmoveNumber = 0;
 
+    self->key = 0;
+    self->pawnKey = 0;
+    self->materialKey = 0;
+
+    self->middlegameScore = 0;
+    self->endgameScore = 0;
+    self->phase = 0;
+
+    Board_clearPieceChanges( self );
+
     for ( unsigned short index = 0; index < 64; index++ )
     {
         self->squares[ index ] = EMPTY;
@@ -492,303 +654,423 @@ void Board_exportMove( Move move, char* moveString )
     moveString[ index++ ] = (char)('1' + Move_toRank( move ) );
     if ( Move_isPromotion( move ) )
     {
-        moveString[ index++ ] = pieceNames[ Move_promotion( move ) ];
+        moveString[ index++ ] = (char) tolower( pieceNames[ Move_promotion( move ) ] );
     }
     moveString[ index ] = '\0';
 }
 
 MoveList* Board_generateMoves( Board* self, MoveList* moveList )
 {
-    // Generate pseudolegal moves and then copy the legal ones into the provided list
-    MoveList pseudoLegalMoves;
-    pseudoLegalMoves.count = 0;
-
-    Board_generatePawnMoves( self, &pseudoLegalMoves );
-    Board_generateKnightMoves( self, &pseudoLegalMoves );
-    Board_generateBishopMoves( self, &pseudoLegalMoves );
-    Board_generateRookMoves( self, &pseudoLegalMoves );
-    Board_generateQueenMoves( self, &pseudoLegalMoves );
-    Board_generateKingMoves( self, &pseudoLegalMoves );
-
-    Board copy;
-    Board_copy( self, &copy );
-    for ( short loop = 0; loop < pseudoLegalMoves.count; loop++ )
-    {
-        Board_makeMove( self, pseudoLegalMoves.moves[ loop ] );
-
-        if ( !Board_isAttacking( self, self->whiteToMove ? self->blackPieces.king : self->whitePieces.king ) )
-        {
-            MoveList_addMove( moveList, pseudoLegalMoves.moves[ loop ] );
-        }
-
-        Board_apply( self, &copy );
-    }
+    return Board_generateMovesOfType( self, moveList, GENERATE_ALL );
+}
 
-    return moveList;
+MoveList* Board_generateCaptures( Board* self, MoveList* moveList )
+{
+    return Board_generateMovesOfType( self, moveList, GENERATE_CAPTURES );
 }
 
-void Board_generatePawnMoves( Board* self, MoveList* moveList )
+MoveList* Board_generateQuiets( Board* self, MoveList* moveList )
 {
-    static const unsigned long whitePromotionPieces[] = { WHITE_KNIGHT, WHITE_BISHOP, WHITE_ROOK, WHITE_QUEEN };
-    static const unsigned long blackPromotionPieces[] = { BLACK_KNIGHT, BLACK_BISHOP, BLACK_ROOK, BLACK_QUEEN };
+    return Board_generateMovesOfType( self, moveList, GENERATE_QUIETS );
+}
 
+bool Board_isLegalMove( Board* self, Move move )
+{
     const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
+    const PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
 
-    const unsigned long oneStep = self->whiteToMove ? +8 : -8;
-    const unsigned long twoStep = self->whiteToMove ? +16 : -16;
-    const unsigned long captureL = self->whiteToMove ? +7 : -9;
-    const unsigned long captureR = self->whiteToMove ? +9 : -7;
+    const unsigned long from = Move_from( move );
+    const unsigned long to = Move_to( move );
+    const unsigned long long fromBit = 1ull << from;
+    const unsigned long long toBit = 1ull << to;
 
-    // From where can they move two squares forward
-    const unsigned long homeRank = self->whiteToMove ? 1 : 6;
-    const unsigned long promotionRank = self->whiteToMove ? 7 : 0;
-    const unsigned long *promotionPieces = self->whiteToMove ? whitePromotionPieces : blackPromotionPieces;
+    if ( !( friendlyPieces->bbAll & fromBit ) || ( friendlyPieces->bbAll & toBit ) )
+    {
+        return false;
+    }
 
-    unsigned long long pieces = friendlyPieces->bbPawn;
+    const unsigned char piece = self->squares[ from ] & COLOR_MASK;
 
-    unsigned long index;
-    unsigned long destination;
-    while ( _BitScanForward64( &index, pieces ) )
+    // Pawns and kings have too many special cases (promotion, en passant, castling) to be worth treating
+    // separately, so generate that piece's moves and look for this one among them. Cheap enough as
+    // there are few of them
+    if ( piece == PAWN || piece == KING )
     {
-        pieces ^= 1ull << index;
+        MoveList moveList;
+        moveList.count = 0;
 
-        // Single move forward, no capture
-        // Pawns cannot be on 8th/1st rank (depending on color) due to promotion, so no need for edge detection for this
-        destination = index + oneStep;
-        if ( self->squares[ destination ] == EMPTY )
+        if ( piece == KING )
         {
-            if ( Board_rankFromIndex( destination ) == promotionRank )
-            {
-                for ( unsigned short loop = 0; loop < 4; loop++ )
-                {
-                    Board_addMove( self, moveList, Move_createPromotionMove( index, destination, promotionPieces[ loop] ) );
-                }
-            }
-            else
-            {
-                Board_addMove( self, moveList, Move_createMove( index, destination ) );
-
-                // Those elible for a single step forward can maybe also do two steps
-     
-                destination = index + twoStep;
-                if ( Board_rankFromIndex( index ) == homeRank && self->squares[ destination ] == EMPTY )
-                {
-                    Board_addMove( self, moveList, Move_createMove( index, destination ) );
-                }
-            }
+            Board_generateKingMoves( self, &moveList, Board_isInCheck( self ), GENERATE_ALL );
         }
-
-        if ( Board_fileFromIndex( index ) > 0 )
+        else
         {
-            destination = index + captureL;
-            if ( destination == self->enPassantSquare )
+            const unsigned long king = friendlyPieces->king;
+            const unsigned long long occupancy = friendlyPieces->bbAll | attackerPieces->bbAll;
+            const unsigned long long checkers = Board_attackersOf( self, attackerPieces, king, occupancy );
+
+            if ( checkers & ( checkers - 1 ) )
             {
-                Board_addMove( self, moveList, Move_createMove( index, destination ) );
+                return false;
             }
-            else if ( Board_containsAttacker( self, destination ) )
+
+            unsigned long long targets = ~friendlyPieces->bbAll;
+            if ( checkers )
             {
-                if ( Board_rankFromIndex( destination ) == promotionRank )
-                {
-                    for ( unsigned short loop = 0; loop < 4; loop++ )
-                    {
-                        Board_addMove( self, moveList, Move_createPromotionMove( index, destination, promotionPieces[ loop ] ) );
-                    }
-                }
-                else
-                {
-                    Board_addMove( self, moveList, Move_createMove( index, destination ) );
-                }
+                unsigned long checker;
+                _BitScanForward64( &checker, checkers );
+
+                targets &= betweenSquares[ king ][ checker ] | checkers;
             }
+
+            Board_generatePawnMoves( self, &moveList, targets, Board_pinnedPieces( self, king ), GENERATE_ALL );
         }
 
-        if ( Board_fileFromIndex( index ) < 7 )
+        for ( unsigned char loop = 0; loop < moveList.count; loop++ )
         {
-            destination = index + captureR;
-            if ( destination == self->enPassantSquare )
-            {
-                Board_addMove( self, moveList, Move_createMove( index, destination ) );
-            }
-            else if ( Board_containsAttacker( self, destination ) )
+            if ( moveList.moves[ loop ] == move )
             {
-                if ( Board_rankFromIndex( destination ) == promotionRank )
-                {
-                    for ( unsigned short loop = 0; loop < 4; loop++ )
-                    {
-                        Board_addMove( self, moveList, Move_createPromotionMove( index, destination, promotionPieces[ loop ] ) );
-                    }
-                }
-                else
-                {
-                    Board_addMove( self, moveList, Move_createMove( index, destination ) );
-                }
+                return true;
             }
         }
+
+        return false;
     }
-}
 
-void Board_generateKnightMoves( Board* self, MoveList* moveList )
-{
-    const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
+    if ( Move_isPromotion( move ) )
+    {
+        return false;
+    }
 
-    unsigned long long pieces = friendlyPieces->bbKnight;
+    const unsigned long king = friendlyPieces->king;
+    const unsigned long long occupancy = friendlyPieces->bbAll | attackerPieces->bbAll;
 
-    unsigned long index;
-    unsigned long destination;
-    while ( _BitScanForward64( &index, pieces ) )
+    // Can the piece get there at all?
+    unsigned long long attacks;
+    switch ( piece )
     {
-        pieces ^= 1ull << index;
+        case KNIGHT:
+            attacks = knightAttacks[ from ];
+            break;
 
-        unsigned long* directions = knightDirections[ index ];
-        for( short loop = 0; loop < 8; loop++ )
-        {
-            if ( directions[ loop ] != 0 )
-            {
-                destination = index + directions[ loop ];
-                if ( !Board_containsFriendly( self, destination ) )
-                {
-                    Board_addMove( self, moveList, Move_createMove( index, destination ) );
-                }
-            }
-        }
-    }
-}
+        case BISHOP:
+            attacks = Magic_bishopAttacks( from, occupancy );
+            break;
 
-void Board_generateBishopMoves( Board* self, MoveList* moveList ) 
-{
-    const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
-    const PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
+        case ROOK:
+            attacks = Magic_rookAttacks( from, occupancy );
+            break;
 
-    unsigned long long pieces = friendlyPieces->bbBishop;
+        default:
+            attacks = Magic_queenAttacks( from, occupancy );
+            break;
+    }
 
-    unsigned long index;
-    unsigned long destination;
-    while ( _BitScanForward64( &index, pieces ) )
+    if ( !( attacks & toBit ) )
     {
-        pieces ^= 1ull << index;
+        return false;
+    }
 
-        long pieceRank = Board_rankFromIndex( index );
-        long pieceFile = Board_fileFromIndex( index );
+    // Then the same tests as the generator - the move must deal with any check and stay in line with any pin
+    const unsigned long long checkers = Board_attackersOf( self, attackerPieces, king, occupancy );
+
+    if ( checkers )
+    {
+        if ( checkers & ( checkers - 1 ) )
+        {
+            return false;
+        }
 
-        // Normal one-square moves diagonal
-        short vectors[][2] =
-        { 
-            {-1,-1},
-            {-1,+1},
-            {+1,-1},
-            {+1,+1},
-        };
+        unsigned long checker;
+        _BitScanForward64( &checker, checkers );
 
-        for ( unsigned short vectorIndex = 0; vectorIndex < 4; vectorIndex++ )
+        if ( !( ( betweenSquares[ king ][ checker ] | checkers ) & toBit ) )
         {
-            for ( unsigned short distance = 1; distance < 8; distance++ )
-            {
-                long destinationRank = pieceRank + ( distance * vectors[ vectorIndex ][ 0 ] );
-                if ( destinationRank < 0 || destinationRank > 7 )
-                {
-                    // Stop travelling in this direction
-                    break;
-                }
-                long destinationFile = pieceFile + ( distance * vectors[ vectorIndex ][ 1 ] );
-                if ( destinationFile < 0 || destinationFile > 7 )
-                {
-                    // Stop travelling in this direction
-                    break;
-                }
+            return false;
+        }
+    }
 
-                destination = ( destinationRank << 3 ) + destinationFile;
+    if ( ( Board_pinnedPieces( self, king ) & fromBit ) && !( lineThrough[ king ][ from ] & toBit ) )
+    {
+        return false;
+    }
 
-                if ( Board_containsFriendly( self, destination ) )
-                {
-                    // Stop travelling in this direction - friendly piece found
-                    break;
-                }
-                else if ( Board_containsAttacker( self, destination ) )
-                {
-                    Board_addMove( self, moveList, Move_createMove( index, destination ) );
+    return true;
+}
 
-                    // Stop travelling in this direction - capture made
-                    break;
-                }
-                else // Empty square - note the move and keep looking
-                {
-                    Board_addMove( self, moveList, Move_createMove( index, destination ) );
-                }
-            }
-        }
+bool Board_isQuiet( Board* self, Move move )
+{
+    if ( Move_isPromotion( move ) || self->squares[ Move_to( move ) ] != EMPTY )
+    {
+        return false;
     }
+
+    // En passant captures land on an empty square
+    return !( Move_to( move ) == self->enPassantSquare && ( self->squares[ Move_from( move ) ] & COLOR_MASK ) == PAWN );
 }
 
-void Board_generateRookMoves( Board* self, MoveList* moveList ) 
+MoveList* Board_generateMovesOfType( Board* self, MoveList* moveList, enum GenerationMode mode )
 {
+    // Work out once, up front, what the opponent is doing to our king so that every move generated
+    // below is legal without having to be made and tested
     const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
     const PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
 
-    unsigned long long pieces = friendlyPieces->bbRook;
+    const unsigned long king = friendlyPieces->king;
+    const unsigned long long occupancy = friendlyPieces->bbAll | attackerPieces->bbAll;
+    const unsigned long long checkers = Board_attackersOf( self, attackerPieces, king, occupancy );
 
-    unsigned long index;
-    unsigned long destination;
-    while ( _BitScanForward64( &index, pieces ) )
+    // In double check, only the king can move
+    if ( checkers & ( checkers - 1 ) )
     {
-        pieces ^= 1ull << index;
+        Board_generateKingMoves( self, moveList, true, mode );
+        return moveList;
+    }
 
-        long pieceRank = Board_rankFromIndex( index );
-        long pieceFile = Board_fileFromIndex( index );
+    // Anywhere not occupied by our own pieces, unless in check in which case we must capture
+    // the checker or block its line to the king
+    unsigned long long targets = ~friendlyPieces->bbAll;
 
-        // Normal one-square moves horizontal and vertical
-        short vectors[][ 2 ] =
-        {
-            {-1, 0},
-            { 0,-1},
-            { 0,+1},
-            {+1, 0},
-        };
+    if ( checkers )
+    {
+        unsigned long checker;
+        _BitScanForward64( &checker, checkers );
 
-        for ( unsigned short vectorIndex = 0; vectorIndex < 4; vectorIndex++ )
-        {
-            for ( unsigned short distance = 1; distance < 8; distance++ )
-            {
-                long destinationRank = pieceRank + ( distance * vectors[ vectorIndex ][ 0 ] );
-                if ( destinationRank < 0 || destinationRank > 7 )
-                {
-                    // Stop travelling in this direction
-                    break;
-                }
-                long destinationFile = pieceFile + ( distance * vectors[ vectorIndex ][ 1 ] );
-                if ( destinationFile < 0 || destinationFile > 7 )
-                {
-                    // Stop travelling in this direction
-                    break;
-                }
+        targets &= betweenSquares[ king ][ checker ] | checkers;
+    }
 
-                destination = ( destinationRank << 3 ) + destinationFile;
+    const unsigned long long pinned = Board_pinnedPieces( self, king );
 
-                if ( Board_containsFriendly( self, destination ) )
-                {
-                    // Stop travelling in this direction - friendly piece found
-                    break;
-                }
-                else if ( Board_containsAttacker( self, destination ) )
-                {
-                    Board_addMove( self, moveList, Move_createMove( index, destination ) );
+    // Pawns get the full set of targets as their pushes don't capture, even when they promote
+    Board_generatePawnMoves( self, moveList, targets, pinned, mode );
 
-                    // Stop travelling in this direction - capture made
-                    break;
-                }
-                else // Empty square - note the move and keep looking
-                {
-                    Board_addMove( self, moveList, Move_createMove( index, destination ) );
-                }
-            }
-        }
+    if ( mode == GENERATE_CAPTURES )
+    {
+        targets &= attackerPieces->bbAll;
+    }
+    else if ( mode == GENERATE_QUIETS )
+    {
+        targets &= ~attackerPieces->bbAll;
     }
+
+    Board_generateKnightMoves( self, moveList, targets, pinned );
+    Board_generateBishopMoves( self, moveList, targets, pinned );
+    Board_generateRookMoves( self, moveList, targets, pinned );
+    Board_generateQueenMoves( self, moveList, targets, pinned );
+    Board_generateKingMoves( self, moveList, checkers != 0, mode );
+
+    return moveList;
 }
 
-void Board_generateQueenMoves( Board* self, MoveList* moveList ) 
+unsigned long long Board_attackersOf( Board* self, const PieceList* attackerPieces, unsigned long index, unsigned long long occupancy )
 {
-    const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
-    const PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
-
-    unsigned long long pieces = friendlyPieces->bbQueen;
+    // A pawn attacks index if a pawn of the other color standing on index would attack the pawn
+    const unsigned short defenderColor = attackerPieces == &self->whitePieces ? 1 : 0;
+
+    return ( knightAttacks[ index ] & attackerPieces->bbKnight ) |
+           ( kingAttacks[ index ] & attackerPieces->bbKing ) |
+           ( pawnAttacks[ defenderColor ][ index ] & attackerPieces->bbPawn ) |
+           ( Magic_bishopAttacks( index, occupancy ) & ( attackerPieces->bbBishop | attackerPieces->bbQueen ) ) |
+           ( Magic_rookAttacks( index, occupancy ) & ( attackerPieces->bbRook | attackerPieces->bbQueen ) );
+}
+
+unsigned long long Board_attackersTo( Board* self, unsigned long index, unsigned long long occupancy )
+{
+    const PieceList* white = &self->whitePieces;
+    const PieceList* black = &self->blackPieces;
+
+    return ( knightAttacks[ index ] & ( white->bbKnight | black->bbKnight ) ) |
+           ( kingAttacks[ index ] & ( white->bbKing | black->bbKing ) ) |
+           ( pawnAttacks[ 1 ][ index ] & white->bbPawn ) |
+           ( pawnAttacks[ 0 ][ index ] & black->bbPawn ) |
+           ( Magic_bishopAttacks( index, occupancy ) & ( white->bbBishop | white->bbQueen | black->bbBishop | black->bbQueen ) ) |
+           ( Magic_rookAttacks( index, occupancy ) & ( white->bbRook | white->bbQueen | black->bbRook | black->bbQueen ) );
+}
+
+int Board_staticExchange( Board* self, Move move )
+{
+    const unsigned long from = Move_from( move );
+    const unsigned long to = Move_to( move );
+
+    unsigned long long occupancy = self->whitePieces.bbAll | self->blackPieces.bbAll;
+    const unsigned long long diagonalSliders = self->whitePieces.bbBishop | self->whitePieces.bbQueen | self->blackPieces.bbBishop | self->blackPieces.bbQueen;
+    const unsigned long long straightSliders = self->whitePieces.bbRook | self->whitePieces.bbQueen | self->blackPieces.bbRook | self->blackPieces.bbQueen;
+
+    // The piece that will be standing on the square, to be taken by the next capture
+    unsigned char piece = self->squares[ from ] & COLOR_MASK;
+
+    // gains[ n ] is what the side making capture n has won by the end of the sequence, if it stops there
+    int gains[ MAX_EXCHANGES ];
+    gains[ 0 ] = exchangeValues[ self->squares[ to ] & COLOR_MASK ];
+
+    if ( piece == PAWN && to == self->enPassantSquare )
+    {
+        // The captured pawn is beside the destination rather than on it, and may have been blocking a slider
+        gains[ 0 ] = exchangeValues[ PAWN ];
+        occupancy ^= 1ull << ( self->whiteToMove ? to - 8 : to + 8 );
+    }
+    else if ( Move_isPromotion( move ) )
+    {
+        piece = Move_promotion( move ) & COLOR_MASK;
+        gains[ 0 ] += exchangeValues[ piece ] - exchangeValues[ PAWN ];
+    }
+
+    occupancy ^= 1ull << from;
+
+    // Every piece that bears on the square, including those behind the moving piece
+    unsigned long long attackers = Board_attackersTo( self, to, occupancy ) & occupancy;
+
+    PieceList* sidePieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
+    PieceList* otherPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
+
+    int depth = 0;
+    while ( depth < MAX_EXCHANGES - 1 )
+    {
+        // Find the least valuable piece the side to capture has attacking the square
+        unsigned long long lowest = 0;
+        unsigned char attacker = PAWN;
+        for ( ; attacker <= KING; attacker++ )
+        {
+            lowest = *Board_pieceBitboard( sidePieces, attacker ) & attackers;
+            if ( lowest )
+            {
+                break;
+            }
+        }
+
+        if ( !lowest )
+        {
+            break;
+        }
+
+        // A king can't capture onto a square that is still attacked
+        if ( attacker == KING && ( attackers & otherPieces->bbAll ) )
+        {
+            break;
+        }
+
+        depth++;
+        gains[ depth ] = exchangeValues[ piece ] - gains[ depth - 1 ];
+
+        // The side to capture is behind whether or not it does, so the sign of the result, which is what
+        // callers want to know, can no longer change. This capture's gain assumes nothing recaptures, so
+        // leave it out
+        if ( ( -gains[ depth - 1 ] > gains[ depth ] ? -gains[ depth - 1 ] : gains[ depth ] ) < 0 )
+        {
+            depth--;
+            break;
+        }
+
+        // Take the attacker off the board, uncovering any slider lined up behind it
+        occupancy ^= lowest & ( ~lowest + 1 );
+
+        if ( attacker == PAWN || attacker == BISHOP || attacker == QUEEN )
+        {
+            attackers |= Magic_bishopAttacks( to, occupancy ) & diagonalSliders;
+        }
+        if ( attacker == ROOK || attacker == QUEEN )
+        {
+            attackers |= Magic_rookAttacks( to, occupancy ) & straightSliders;
+        }
+        attackers &= occupancy;
+
+        piece = attacker;
+
+        PieceList* swap = sidePieces;
+        sidePieces = otherPieces;
+        otherPieces = swap;
+    }
+
+    // Work back from the end, letting each side decline a capture that would leave it worse off
+    while ( depth > 0 )
+    {
+        gains[ depth - 1 ] = -( -gains[ depth - 1 ] > gains[ depth ] ? -gains[ depth - 1 ] : gains[ depth ] );
+        depth--;
+    }
+
+    return gains[ 0 ];
+}
+
+bool Board_isInCheck( Board* self )
+{
+    const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
+    const PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
+
+    return Board_attackersOf( self, attackerPieces, friendlyPieces->king, friendlyPieces->bbAll | attackerPieces->bbAll ) != 0;
+}
+
+Move Board_parseMove( Board* self, const char* moveString )
+{
+    MoveList moveList;
+    moveList.count = 0;
+    Board_generateMoves( self, &moveList );
+
+    // Simplest to format each legal move and compare the text. UCI promotion pieces are lower case
+    // but be tolerant of those that send them in upper case
+    char legalMove[ 10 ];
+    for ( unsigned char loop = 0; loop < moveList.count; loop++ )
+    {
+        Board_exportMove( moveList.moves[ loop ], legalMove );
+
+        if ( _stricmp( legalMove, moveString ) == 0 )
+        {
+            return moveList.moves[ loop ];
+        }
+    }
+
+    return NO_MOVE;
+}
+
+unsigned long long Board_pinnedPieces( Board* self, unsigned long king )
+{
+    const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
+    const PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
+
+    const unsigned long long occupancy = friendlyPieces->bbAll | attackerPieces->bbAll;
+
+    // Enemy sliders that would attack the king if none of our pieces were in the way
+    unsigned long long snipers = ( Magic_bishopAttacks( king, attackerPieces->bbAll ) & ( attackerPieces->bbBishop | attackerPieces->bbQueen ) ) |
+                                 ( Magic_rookAttacks( king, attackerPieces->bbAll ) & ( attackerPieces->bbRook | attackerPieces->bbQueen ) );
+
+    unsigned long long pinned = 0;
+
+    unsigned long sniper;
+    while ( _BitScanForward64( &sniper, snipers ) )
+    {
+        snipers ^= 1ull << sniper;
+
+        // Pinned if exactly one piece stands in the way, and that piece is ours
+        const unsigned long long blockers = betweenSquares[ king ][ sniper ] & occupancy;
+
+        if ( blockers && !( blockers & ( blockers - 1 ) ) )
+        {
+            pinned |= blockers & friendlyPieces->bbAll;
+        }
+    }
+
+    return pinned;
+}
+
+void Board_generatePawnMoves( Board* self, MoveList* moveList, unsigned long long targets, unsigned long long pinned, enum GenerationMode mode )
+{
+    static const unsigned long whitePromotionPieces[] = { WHITE_KNIGHT, WHITE_BISHOP, WHITE_ROOK, WHITE_QUEEN };
+    static const unsigned long blackPromotionPieces[] = { BLACK_KNIGHT, BLACK_BISHOP, BLACK_ROOK, BLACK_QUEEN };
+
+    const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
+    const PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
+
+    const unsigned long oneStep = self->whiteToMove ? +8 : -8;
+    const unsigned long twoStep = self->whiteToMove ? +16 : -16;
+    const unsigned short color = self->whiteToMove ? 0 : 1;
+
+    // From where can they move two squares forward
+    const unsigned long homeRank = self->whiteToMove ? 1 : 6;
+    const unsigned long promotionRank = self->whiteToMove ? 7 : 0;
+    const unsigned long *promotionPieces = self->whiteToMove ? whitePromotionPieces : blackPromotionPieces;
+
+    const unsigned long king = friendlyPieces->king;
+
+    unsigned long long pieces = friendlyPieces->bbPawn;
 
     unsigned long index;
     unsigned long destination;
@@ -796,100 +1078,263 @@ void Board_generateQueenMoves( Board* self, MoveList* moveList )
     {
         pieces ^= 1ull << index;
 
-        long pieceRank = Board_rankFromIndex( index );
-        long pieceFile = Board_fileFromIndex( index );
-
-        // Normal one-square moves in any direction
-        short vectors[][ 2 ] =
+        // A pinned pawn can only move along the line between its king and the pinning piece
+        unsigned long long allowed = targets;
+        if ( pinned & ( 1ull << index ) )
         {
-            {-1,-1},
-            {-1,+1},
-            {+1,-1},
-            {+1,+1},
-            {-1, 0},
-            { 0,-1},
-            { 0,+1},
-            {+1, 0},
-        };
+            allowed &= lineThrough[ king ][ index ];
+        }
 
-        for ( unsigned short vectorIndex = 0; vectorIndex < 8; vectorIndex++ )
+        // Single move forward, no capture
+        // Pawns cannot be on 8th/1st rank (depending on color) due to promotion, so no need for edge detection for this
+        destination = index + oneStep;
+        if ( self->squares[ destination ] == EMPTY )
         {
-            for ( unsigned short distance = 1; distance < 8; distance++ )
+            const bool promotion = Board_rankFromIndex( destination ) == promotionRank;
+
+            // Pushes that promote count along with the captures, the rest are quiet
+            if ( ( allowed & ( 1ull << destination ) ) && ( promotion ? mode != GENERATE_QUIETS : mode != GENERATE_CAPTURES ) )
             {
-                long destinationRank = pieceRank + ( distance * vectors[ vectorIndex ][ 0 ] );
-                if ( destinationRank < 0 || destinationRank > 7 )
+                if ( promotion )
                 {
-                    // Stop travelling in this direction
-                    break;
+                    for ( unsigned short loop = 0; loop < 4; loop++ )
+                    {
+                        Board_addMove( self, moveList, Move_createPromotionMove( index, destination, promotionPieces[ loop ] ) );
+                    }
                 }
-                long destinationFile = pieceFile + ( distance * vectors[ vectorIndex ][ 1 ] );
-                if ( destinationFile < 0 || destinationFile > 7 )
+                else
                 {
-                    // Stop travelling in this direction
-                    break;
+                    Board_addMove( self, moveList, Move_createMove( index, destination ) );
                 }
+            }
 
-                destination = ( destinationRank << 3 ) + destinationFile;
+            // Those eligible for a single step forward can maybe also do two steps. This is tested
+            // separately as the second square may block a check where the first does not
+            destination = index + twoStep;
+            if ( mode != GENERATE_CAPTURES && Board_rankFromIndex( index ) == homeRank && self->squares[ destination ] == EMPTY && ( allowed & ( 1ull << destination ) ) )
+            {
+                Board_addMove( self, moveList, Move_createMove( index, destination ) );
+            }
+        }
 
-                if ( Board_containsFriendly( self, destination ) )
-                {
-                    // Stop travelling in this direction - friendly piece found
-                    break;
-                }
-                else if ( Board_containsAttacker( self, destination ) )
-                {
-                    Board_addMove( self, moveList, Move_createMove( index, destination ) );
+        if ( mode == GENERATE_QUIETS )
+        {
+            continue;
+        }
 
-                    // Stop travelling in this direction - capture made
-                    break;
-                }
-                else // Empty square - note the move and keep looking
+        unsigned long long captures = pawnAttacks[ color ][ index ] & attackerPieces->bbAll & allowed;
+        while ( _BitScanForward64( &destination, captures ) )
+        {
+            captures ^= 1ull << destination;
+
+            if ( Board_rankFromIndex( destination ) == promotionRank )
+            {
+                for ( unsigned short loop = 0; loop < 4; loop++ )
                 {
-                    Board_addMove( self, moveList, Move_createMove( index, destination ) );
+                    Board_addMove( self, moveList, Move_createPromotionMove( index, destination, promotionPieces[ loop ] ) );
                 }
             }
+            else
+            {
+                Board_addMove( self, moveList, Move_createMove( index, destination ) );
+            }
+        }
+
+        if ( self->enPassantSquare != OFF_BOARD && ( pawnAttacks[ color ][ index ] & ( 1ull << self->enPassantSquare ) ) )
+        {
+            if ( Board_isLegalEnPassant( self, index, targets ) )
+            {
+                Board_addMove( self, moveList, Move_createMove( index, self->enPassantSquare ) );
+            }
         }
     }
 }
 
-void Board_generateKingMoves( Board* self, MoveList* moveList )
+bool Board_isLegalEnPassant( Board* self, unsigned long from, unsigned long long targets )
 {
     const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
     const PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
 
-    unsigned long index = friendlyPieces->king;
+    const unsigned long king = friendlyPieces->king;
+    const unsigned long captured = self->whiteToMove ? self->enPassantSquare - 8 : self->enPassantSquare + 8;
+
+    const unsigned long long destinationBit = 1ull << self->enPassantSquare;
+    const unsigned long long capturedBit = 1ull << captured;
+
+    // If in check, the capture has to either remove the checking pawn or block the check
+    if ( !( ( destinationBit | capturedBit ) & targets ) )
+    {
+        return false;
+    }
+
+    // Two pawns leave the board's rank at once, so pin masks aren't enough. Instead, see whether any 
+    // slider can see the king once the capture has been made - this covers the case where both pawns
+    // were shielding the king along the rank
+    const unsigned long long occupancy = ( ( friendlyPieces->bbAll | attackerPieces->bbAll ) ^ ( 1ull << from ) ^ capturedBit ) | destinationBit;
+
+    return !( Magic_bishopAttacks( king, occupancy ) & ( attackerPieces->bbBishop | attackerPieces->bbQueen ) ) &&
+           !( Magic_rookAttacks( king, occupancy ) & ( attackerPieces->bbRook | attackerPieces->bbQueen ) );
+}
+
+void Board_generateKnightMoves( Board* self, MoveList* moveList, unsigned long long targets, unsigned long long pinned )
+{
+    const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
+
+    // A pinned knight can never move without leaving the line of the pin
+    unsigned long long pieces = friendlyPieces->bbKnight & ~pinned;
+
+    unsigned long index;
     unsigned long destination;
+    while ( _BitScanForward64( &index, pieces ) )
+    {
+        pieces ^= 1ull << index;
 
-    long kingRank = Board_rankFromIndex( index );
-    long kingFile = Board_fileFromIndex( index );
+        unsigned long long destinations = knightAttacks[ index ] & targets;
 
-    // Normal one-square moves
-    for ( short rankOffset = -1; rankOffset <= +1; rankOffset++ )
+        while ( _BitScanForward64( &destination, destinations ) )
+        {
+            destinations ^= 1ull << destination;
+
+            Board_addMove( self, moveList, Move_createMove( index, destination ) );
+        }
+    }
+}
+
+void Board_generateBishopMoves( Board* self, MoveList* moveList, unsigned long long targets, unsigned long long pinned ) 
+{
+    const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
+    const PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
+
+    const unsigned long long occupancy = friendlyPieces->bbAll | attackerPieces->bbAll;
+
+    unsigned long long pieces = friendlyPieces->bbBishop;
+
+    unsigned long index;
+    unsigned long destination;
+    while ( _BitScanForward64( &index, pieces ) )
     {
-        if ( kingRank + rankOffset < 0 || kingRank + rankOffset > 7 )
+        pieces ^= 1ull << index;
+
+        // Everything the bishop can see, other than our own pieces, is either an empty square or a capture
+        unsigned long long destinations = Magic_bishopAttacks( index, occupancy ) & targets;
+
+        if ( pinned & ( 1ull << index ) )
         {
-            continue;
+            destinations &= lineThrough[ friendlyPieces->king ][ index ];
         }
 
-        for ( short fileOffset = -1; fileOffset <= +1; fileOffset++ )
+        while ( _BitScanForward64( &destination, destinations ) )
         {
-            if ( kingFile + fileOffset < 0 || kingFile + fileOffset > 7 )
-            {
-                continue;
-            }
+            destinations ^= 1ull << destination;
 
-            destination = index + ( rankOffset * 8 ) + fileOffset;
+            Board_addMove( self, moveList, Move_createMove( index, destination ) );
+        }
+    }
+}
 
-            if ( !Board_containsFriendly( self, destination ) )
-            {
-                Board_addMove( self, moveList, Move_createMove( index, destination ) );
-            }
+void Board_generateRookMoves( Board* self, MoveList* moveList, unsigned long long targets, unsigned long long pinned ) 
+{
+    const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
+    const PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
+
+    const unsigned long long occupancy = friendlyPieces->bbAll | attackerPieces->bbAll;
+
+    unsigned long long pieces = friendlyPieces->bbRook;
+
+    unsigned long index;
+    unsigned long destination;
+    while ( _BitScanForward64( &index, pieces ) )
+    {
+        pieces ^= 1ull << index;
+
+        unsigned long long destinations = Magic_rookAttacks( index, occupancy ) & targets;
+
+        if ( pinned & ( 1ull << index ) )
+        {
+            destinations &= lineThrough[ friendlyPieces->king ][ index ];
+        }
+
+        while ( _BitScanForward64( &destination, destinations ) )
+        {
+            destinations ^= 1ull << destination;
+
+            Board_addMove( self, moveList, Move_createMove( index, destination ) );
+        }
+    }
+}
+
+void Board_generateQueenMoves( Board* self, MoveList* moveList, unsigned long long targets, unsigned long long pinned ) 
+{
+    const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
+    const PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
+
+    const unsigned long long occupancy = friendlyPieces->bbAll | attackerPieces->bbAll;
+
+    unsigned long long pieces = friendlyPieces->bbQueen;
+
+    unsigned long index;
+    unsigned long destination;
+    while ( _BitScanForward64( &index, pieces ) )
+    {
+        pieces ^= 1ull << index;
+
+        unsigned long long destinations = Magic_queenAttacks( index, occupancy ) & targets;
+
+        if ( pinned & ( 1ull << index ) )
+        {
+            destinations &= lineThrough[ friendlyPieces->king ][ index ];
+        }
+
+        while ( _BitScanForward64( &destination, destinations ) )
+        {
+            destinations ^= 1ull << destination;
+
+            Board_addMove( self, moveList, Move_createMove( index, destination ) );
+        }
+    }
+}
+
+void Board_generateKingMoves( Board* self, MoveList* moveList, bool inCheck, enum GenerationMode mode )
+{
+    const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
+    const PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
+
+    unsigned long index = friendlyPieces->king;
+    unsigned long destination;
+
+    // Take the king off the board when testing its destinations, otherwise a slider checking it would
+    // not appear to attack the square directly behind the king
+    const unsigned long long occupancy = ( friendlyPieces->bbAll | attackerPieces->bbAll ) ^ ( 1ull << index );
+
+    // Normal one-square moves
+    unsigned long long destinations = kingAttacks[ index ] & ~friendlyPieces->bbAll;
+
+    if ( mode == GENERATE_CAPTURES )
+    {
+        destinations &= attackerPieces->bbAll;
+    }
+    else if ( mode == GENERATE_QUIETS )
+    {
+        destinations &= ~attackerPieces->bbAll;
+    }
+
+    while ( _BitScanForward64( &destination, destinations ) )
+    {
+        destinations ^= 1ull << destination;
+
+        if ( !Board_attackersOf( self, attackerPieces, destination, occupancy ) )
+        {
+            Board_addMove( self, moveList, Move_createMove( index, destination ) );
         }
     }
 
     // Castling? 
     // Assume the flags are accurate but still need to make sure there is nothing in the way and we're not moving through check
-    unsigned long long allPieces = friendlyPieces->bbAll & attackerPieces->bbAll;
+    if ( inCheck || mode == GENERATE_CAPTURES )
+    {
+        // We can't castle out of check, and castling never captures
+        return;
+    }
 
     if ( friendlyPieces->kingsideCastling )
     {
@@ -898,8 +1343,8 @@ void Board_generateKingMoves( Board* self, MoveList* moveList )
         {
             if ( Board_isEmptySquare( self, F1 ) && Board_isEmptySquare( self, G1 ) )
             {
-                // We can't castle out of, or through check, so test this
-                if ( !Board_isAttacked( self, E1 ) && !Board_isAttacked( self, F1 ) && !Board_isAttacked( self, G1 ) )
+                // We can't castle through check, so test this
+                if ( !Board_attackersOf( self, attackerPieces, F1, occupancy ) && !Board_attackersOf( self, attackerPieces, G1, occupancy ) )
                 {
                     Board_addMove( self, moveList, Move_createMove( index, G1 ) );
                 }
@@ -909,7 +1354,7 @@ void Board_generateKingMoves( Board* self, MoveList* moveList )
         {
             if ( Board_isEmptySquare( self, F8 ) && Board_isEmptySquare( self, G8 ) )
             {
-                if ( !Board_isAttacked( self, E8 ) && !Board_isAttacked( self, F8 ) && !Board_isAttacked( self, G8 ) )
+                if ( !Board_attackersOf( self, attackerPieces, F8, occupancy ) && !Board_attackersOf( self, attackerPieces, G8, occupancy ) )
                 {
                     Board_addMove( self, moveList, Move_createMove( index, G8 ) );
                 }
@@ -923,7 +1368,7 @@ void Board_generateKingMoves( Board* self, MoveList* moveList )
         {
             if ( Board_isEmptySquare( self, B1 ) && Board_isEmptySquare( self, C1 ) && Board_isEmptySquare( self, D1 ) )
             {
-                if ( !Board_isAttacked( self, E1 ) && !Board_isAttacked( self, D1 ) && !Board_isAttacked( self, C1 ) )
+                if ( !Board_attackersOf( self, attackerPieces, D1, occupancy ) && !Board_attackersOf( self, attackerPieces, C1, occupancy ) )
                 {
                     Board_addMove( self, moveList, Move_createMove( index, C1 ) );
                 }
@@ -933,7 +1378,7 @@ void Board_generateKingMoves( Board* self, MoveList* moveList )
         {
             if ( Board_isEmptySquare( self, B8 ) && Board_isEmptySquare( self, C8 ) && Board_isEmptySquare( self, D8 ) )
             {
-                if ( !Board_isAttacked( self, E8 ) && !Board_isAttacked( self, D8 ) && !Board_isAttacked( self, C8 ) )
+                if ( !Board_attackersOf( self, attackerPieces, D8, occupancy ) && !Board_attackersOf( self, attackerPieces, C8, occupancy ) )
                 {
                     Board_addMove( self, moveList, Move_createMove( index, C8 ) );
                 }
@@ -1030,113 +1475,318 @@ bool Board_isWhitePiece( enum Piece piece )
 
 bool Board_isBlackPiece( enum Piece piece )
 {
-    return piece >= BLACK_PAWN && piece <= BLACK_KING;
+    return piece >= BLACK_PAWN && piece <= BLACK_KING;
+}
+
+unsigned long long* Board_pieceBitboard( PieceList* pieceList, unsigned char piece )
+{
+    switch ( piece & COLOR_MASK )
+    {
+        case PAWN:
+            return &pieceList->bbPawn;
+        case KNIGHT:
+            return &pieceList->bbKnight;
+        case BISHOP:
+            return &pieceList->bbBishop;
+        case ROOK:
+            return &pieceList->bbRook;
+        case QUEEN:
+            return &pieceList->bbQueen;
+        default:
+            return &pieceList->bbKing;
+    }
+}
+
+void Board_clearSquare( Board* self, PieceList* pieceList, unsigned long index )
+{
+    if ( Board_isEmptySquare( self, index ) )
+    {
+        return;
+    }
+
+    if ( pieceList == NULL )
+    {
+        // We already know the square isn't empty, so one of these is right
+        if ( Board_isWhitePiece( self->squares[ index ] ) )
+        {
+            Board_clearSquare( self, &self->whitePieces, index );
+        }
+        else
+        {
+            Board_clearSquare( self, &self->blackPieces, index );
+        }
+    }
+    else
+    {
+        const unsigned long long notmask = ~( 1ull << index );
+        const unsigned char piece = self->squares[ index ];
+
+        unsigned long long* bitboard = Board_pieceBitboard( pieceList, piece );
+
+        self->squares[ index ] = EMPTY;
+
+        *bitboard &= notmask;
+        pieceList->bbAll &= notmask;
+
+        // Special case
+        if ( Board_isKing( piece ) )
+        {
+            pieceList->king = OFF_BOARD;
+        }
+
+        // The material key counts pieces rather than placing them, so uses the number left of this type
+        self->key ^= zobristPieces[ piece ][ index ];
+        self->materialKey ^= zobristPieces[ piece ][ __popcnt64( *bitboard ) ];
+
+        if ( Board_isPawn( piece ) )
+        {
+            self->pawnKey ^= zobristPieces[ piece ][ index ];
+        }
+
+        self->middlegameScore -= middlegameScores[ piece ][ index ];
+        self->endgameScore -= endgameScores[ piece ][ index ];
+        self->phase -= phaseScores[ piece ];
+
+        Board_recordPieceChange( self, piece, index, false );
+    }
+}
+
+void Board_setSquare( Board* self, PieceList* pieceList, enum Piece piece, unsigned long index )
+{
+    // Precaution, hopefully not too costly
+    if ( !Board_isEmptySquare( self, index ) )
+    {
+        Board_clearSquare( self, NULL, index );
+    }
+
+    if ( pieceList == NULL )
+    {
+        if ( Board_isWhitePiece( piece ) )
+        {
+            Board_setSquare( self, &self->whitePieces, piece, index );
+        }
+        else
+        {
+            Board_setSquare( self, &self->blackPieces, piece, index );
+        }
+    }
+    else
+    {
+        const unsigned long long mask = 1ull << index;
+
+        unsigned long long* bitboard = Board_pieceBitboard( pieceList, piece );
+
+        self->squares[ index ] = piece;
+
+        // The material key uses the number of this type already on the board, before this one is added
+        self->key ^= zobristPieces[ piece ][ index ];
+        self->materialKey ^= zobristPieces[ piece ][ __popcnt64( *bitboard ) ];
+
+        if ( Board_isPawn( piece ) )
+        {
+            self->pawnKey ^= zobristPieces[ piece ][ index ];
+        }
+
+        self->middlegameScore += middlegameScores[ piece ][ index ];
+        self->endgameScore += endgameScores[ piece ][ index ];
+        self->phase += phaseScores[ piece ];
+
+        Board_recordPieceChange( self, piece, index, true );
+
+        *bitboard |= mask;
+        pieceList->bbAll |= mask;
+
+        if ( Board_isKing( piece ) )
+        {
+            pieceList->king = index;
+        }
+    }
+}
+
+void Board_movePiece( Board* self, PieceList* pieceList, unsigned long from, unsigned long to )
+{
+    // Both squares change in one go, so toggle them together rather than clearing one and setting the other
+    const unsigned long long mask = ( 1ull << from ) | ( 1ull << to );
+    const unsigned char piece = self->squares[ from ];
+
+    self->squares[ to ] = piece;
+    self->squares[ from ] = EMPTY;
+
+    *Board_pieceBitboard( pieceList, piece ) ^= mask;
+    pieceList->bbAll ^= mask;
+
+    if ( Board_isKing( piece ) )
+    {
+        pieceList->king = to;
+    }
+
+    // No change to the material key, as nothing has been added or taken away
+    const unsigned long long change = zobristPieces[ piece ][ from ] ^ zobristPieces[ piece ][ to ];
+
+    self->key ^= change;
+
+    if ( Board_isPawn( piece ) )
+    {
+        self->pawnKey ^= change;
+    }
+
+    // Nor to the phase
+    self->middlegameScore += middlegameScores[ piece ][ to ] - middlegameScores[ piece ][ from ];
+    self->endgameScore += endgameScores[ piece ][ to ] - endgameScores[ piece ][ from ];
+
+    Board_recordPieceChange( self, piece, from, false );
+    Board_recordPieceChange( self, piece, to, true );
+}
+
+void Board_recordPieceChange( Board* self, unsigned char piece, unsigned long index, bool added )
+{
+    if ( Board_isKing( piece ) )
+    {
+        self->refreshNeeded[ ( piece & COLOR_BIT ) == 0 ? 0 : 1 ] = true;
+        return;
+    }
+
+    // Once both sides are starting again, there is nothing worth keeping
+    if ( self->refreshNeeded[ 0 ] && self->refreshNeeded[ 1 ] )
+    {
+        return;
+    }
+
+    if ( self->pieceChangeCount == MAX_PIECE_CHANGES )
+    {
+        self->refreshNeeded[ 0 ] = true;
+        self->refreshNeeded[ 1 ] = true;
+        return;
+    }
+
+    PieceChange* change = &self->pieceChanges[ self->pieceChangeCount++ ];
+    change->piece = piece;
+    change->square = (unsigned char) index;
+    change->added = added;
+}
+
+void Board_clearPieceChanges( Board* self )
+{
+    self->pieceChangeCount = 0;
+    self->refreshNeeded[ 0 ] = true;
+    self->refreshNeeded[ 1 ] = true;
+}
+
+unsigned char Board_castlingRights( Board* self )
+{
+    return ( self->whitePieces.kingsideCastling ? WHITE_KINGSIDE : 0 ) |
+           ( self->whitePieces.queensideCastling ? WHITE_QUEENSIDE : 0 ) |
+           ( self->blackPieces.kingsideCastling ? BLACK_KINGSIDE : 0 ) |
+           ( self->blackPieces.queensideCastling ? BLACK_QUEENSIDE : 0 );
 }
 
-void Board_clearSquare( Board* self, PieceList* pieceList, unsigned long index )
+unsigned long long Board_enPassantKey( Board* self )
 {
-    if ( Board_isEmptySquare( self, index ) )
+    // Only count the en passant square if the capture is actually possible, otherwise the same position
+    // reached by different move orders would not hash the same
+    if ( self->enPassantSquare != OFF_BOARD )
     {
-        return;
-    }
+        const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
 
-    if ( pieceList == NULL )
-    {
-        // We already know the square isn't empty, so one of these is right
-        if ( Board_isWhitePiece( self->squares[ index ] ) )
-        {
-            Board_clearSquare( self, &self->whitePieces, index );
-        }
-        else
+        if ( pawnAttacks[ self->whiteToMove ? 1 : 0 ][ self->enPassantSquare ] & friendlyPieces->bbPawn )
         {
-            Board_clearSquare( self, &self->blackPieces, index );
+            return zobristEnPassant[ Board_fileFromIndex( self->enPassantSquare ) ];
         }
     }
-    else
-    {
-        const unsigned long long mask = 1ull << index;
-        const unsigned long long notmask = ~mask;
 
-        self->squares[ index ] = EMPTY;
+    return 0;
+}
 
-        // Special case
-        if ( pieceList->bbKing & mask )
-        {
-            pieceList->bbKing &= notmask;
-            pieceList->king = OFF_BOARD;
-        }
-        else
-        {
+unsigned long long Board_computeKey( Board* self )
+{
+    unsigned long long key = 0;
 
-            pieceList->bbPawn &= notmask;
-            pieceList->bbKnight &= notmask;
-            pieceList->bbBishop &= notmask;
-            pieceList->bbRook &= notmask;
-            pieceList->bbQueen &= notmask;
-        }
+    unsigned long long pieces = self->whitePieces.bbAll | self->blackPieces.bbAll;
 
-        pieceList->bbAll &= notmask;
+    unsigned long index;
+    while ( _BitScanForward64( &index, pieces ) )
+    {
+        pieces ^= 1ull << index;
+
+        key ^= zobristPieces[ self->squares[ index ] ][ index ];
+    }
+
+    key ^= zobristCastling[ Board_castlingRights( self ) ];
+    key ^= Board_enPassantKey( self );
+
+    if ( !self->whiteToMove )
+    {
+        key ^= zobristBlackToMove;
     }
+
+    return key;
 }
 
-void Board_setSquare( Board* self, PieceList* pieceList, enum Piece piece, unsigned long index )
+unsigned long long Board_computePawnKey( Board* self )
 {
-    // Precaution, hopefully not too costly
-    if ( !Board_isEmptySquare( self, index ) )
+    unsigned long long key = 0;
+
+    unsigned long long pieces = self->whitePieces.bbPawn | self->blackPieces.bbPawn;
+
+    unsigned long index;
+    while ( _BitScanForward64( &index, pieces ) )
     {
-        Board_clearSquare( self, NULL, index );
+        pieces ^= 1ull << index;
+
+        key ^= zobristPieces[ self->squares[ index ] ][ index ];
     }
 
-    if ( pieceList == NULL )
+    return key;
+}
+
+unsigned long long Board_computeMaterialKey( Board* self )
+{
+    unsigned long long key = 0;
+
+    // One key for each piece of each type, indexed by how many of that type came before it
+    for ( unsigned char piece = WHITE_PAWN; piece <= BLACK_KING; piece++ )
     {
-        if ( Board_isWhitePiece( piece ) )
+        if ( !Board_isWhitePiece( piece ) && !Board_isBlackPiece( piece ) )
         {
-            Board_setSquare( self, &self->whitePieces, piece, index );
+            continue;
         }
-        else
+
+        PieceList* pieceList = Board_isWhitePiece( piece ) ? &self->whitePieces : &self->blackPieces;
+        const unsigned long long count = __popcnt64( *Board_pieceBitboard( pieceList, piece ) );
+
+        for ( unsigned long long loop = 0; loop < count; loop++ )
         {
-            Board_setSquare( self, &self->blackPieces, piece, index );
+            key ^= zobristPieces[ piece ][ loop ];
         }
     }
-    else
-    {
-        const unsigned long long mask = 1ull << index;
 
-        self->squares[ index ] = piece;
+    return key;
+}
 
-        switch ( piece & COLOR_MASK )
-        {
-            case PAWN:
-                pieceList->bbPawn |= mask;
-                break;
-            case KNIGHT:
-                pieceList->bbKnight |= mask;
-                break;
-            case BISHOP:
-                pieceList->bbBishop |= mask;
-                break;
-            case ROOK:
-                pieceList->bbRook |= mask;
-                break;
-            case QUEEN:
-                pieceList->bbQueen |= mask;
-                break;
-            case KING:
-                pieceList->bbKing |= mask;
-                pieceList->king = index;
-                break;
-        }
+void Board_computeEvaluation( Board* self )
+{
+    self->middlegameScore = 0;
+    self->endgameScore = 0;
+    self->phase = 0;
 
-        pieceList->bbAll |= mask;
+    unsigned long long pieces = self->whitePieces.bbAll | self->blackPieces.bbAll;
+
+    unsigned long index;
+    while ( _BitScanForward64( &index, pieces ) )
+    {
+        pieces ^= 1ull << index;
+
+        const unsigned char piece = self->squares[ index ];
+
+        self->middlegameScore += middlegameScores[ piece ][ index ];
+        self->endgameScore += endgameScores[ piece ][ index ];
+        self->phase += phaseScores[ piece ];
     }
 }
 
-bool Board_makeMove( Board* self, Move move )
+bool Board_makeMove( Board* self, Move move, Undo* undo )
 {
     // Return false if it becomes apparent that the move is not legal
-    char moveString[ 10 ];
-    Board_exportMove( move, moveString );
-
     PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
     PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
 
@@ -1146,6 +1796,17 @@ bool Board_makeMove( Board* self, Move move )
     unsigned char fromPiece = self->squares[ from ];
     unsigned char toPiece = self->squares[ to ];
 
+    // Record what we are about to lose so the move can be taken back
+    undo->capturedPiece = toPiece;
+    undo->castlingRights = Board_castlingRights( self );
+    undo->enPassantSquare = (unsigned char) self->enPassantSquare;
+    undo->halfmoveClock = self->halfmoveClock;
+    undo->key = self->key;
+
+    // Take the castling rights and en passant out of the key now, and put back whatever they become
+    // at the end. Pieces are taken care of as they are moved
+    self->key ^= zobristCastling[ undo->castlingRights ] ^ Board_enPassantKey( self );
+
     // Steps:
     // - remove any piece being captured from bb and from squares
     //   - include pawn captured by enPassant (which won't be on "to" square)
@@ -1165,15 +1826,14 @@ bool Board_makeMove( Board* self, Move move )
 
     // - lift piece from "from" and put it on "to" in both bb and squares (and king if appropriate)
     //   - replace "to" piece in the case of promotion
-    Board_clearSquare( self, friendlyPieces, from );
-
     if ( Move_isPromotion( move ) )
     {
+        Board_clearSquare( self, friendlyPieces, from );
         Board_setSquare( self, friendlyPieces, Move_promotion( move ), to);
     }
     else
     {
-        Board_setSquare( self, friendlyPieces, fromPiece, to );
+        Board_movePiece( self, friendlyPieces, from, to );
     }
 
     // - clear enPassant and set to new value if required
@@ -1196,15 +1856,11 @@ bool Board_makeMove( Board* self, Move move )
             // Kingside or Queenside
             if ( from < to )
             {
-                enum Piece rook = self->squares[ from + 3 ];
-                Board_clearSquare( self, friendlyPieces, from + 3 );
-                Board_setSquare( self, friendlyPieces, rook, from + 1 );
+                Board_movePiece( self, friendlyPieces, from + 3, from + 1 );
             }
             else
             {
-                enum Piece rook = self->squares[ from - 4 ];
-                Board_clearSquare( self, friendlyPieces, from - 4 );
-                Board_setSquare( self, friendlyPieces, rook, from - 1 );
+                Board_movePiece( self, friendlyPieces, from - 4, from - 1 );
             }
         }
     }
@@ -1265,6 +1921,8 @@ bool Board_makeMove( Board* self, Move move )
     // - swap active color
     self->whiteToMove = !self->whiteToMove;
 
+    self->key ^= zobristBlackToMove ^ zobristCastling[ Board_castlingRights( self ) ] ^ Board_enPassantKey( self );
+
     // - increment or reset halfmove clock
     if ( Board_isPawn( fromPiece ) || toPiece != EMPTY )
     {
@@ -1285,280 +1943,173 @@ bool Board_makeMove( Board* self, Move move )
     return true;
 }
 
-void Board_copy( Board* self, Board* copy ) 
-{
-    memcpy( copy, self, sizeof( Board ) );
-}
-
-void Board_apply( Board* self, Board* other ) 
-{
-    memcpy( self, other, sizeof( Board ) );
-}
-
-bool Board_compare( Board* self, Board* other ) 
+void Board_unmakeMove( Board* self, Move move, const Undo* undo )
 {
-    return memcmp( self, other, sizeof( Board ) ) == 0;
-}
+    // Swap back to the side that made the move
+    self->whiteToMove = !self->whiteToMove;
 
-bool Board_isAttacked( Board* self, unsigned long index )
-{
-    static const directionArray[ 8 ][ 2 ] =
+    if ( !self->whiteToMove )
     {
-        {-1,-1},
-        {-1, 0},
-        {-1,+1},
-        { 0,-1},
-        { 0,+1},
-        {+1,-1},
-        {+1, 0},
-        {+1,+1},
-    };
+        self->fullmoveNumber--;
+    }
 
-    const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
-    const PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
+    PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
+    PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
 
-    const long pieceRank = Board_rankFromIndex( index );
-    const long pieceFile = Board_fileFromIndex( index );
+    unsigned long from = Move_from( move );
+    unsigned long to = Move_to( move );
 
-    const short directionOfTravel = self->whiteToMove ? +1 : -1;
+    unsigned char movedPiece;
 
-    // Knight attack
-    unsigned long* directions = knightDirections[ index ];
-    for ( short loop = 0; loop < 8; loop++ )
+    // - lift the piece from "to" and put it back on "from", demoting it if it was a promotion
+    if ( Move_isPromotion( move ) )
     {
-        if ( directions[ loop ] != 0 )
-        {
-            unsigned long long target = 1ull << ( index + directions[ loop ] );
+        movedPiece = self->whiteToMove ? WHITE_PAWN : BLACK_PAWN;
 
-            if ( attackerPieces->bbKnight & target )
-            {
-                return true;
-            }
-        }
+        Board_clearSquare( self, friendlyPieces, to );
+        Board_setSquare( self, friendlyPieces, movedPiece, from );
     }
-    
-    // Use one method to check for Pawn, Bishop, Rook, Queen, King attack
-    for ( short directionIndex = 0; directionIndex < 8; directionIndex++ )
+    else
     {
-        short rankOffset = directionArray[ directionIndex ][ 1 ];
-        short fileOffset = directionArray[ directionIndex ][ 0 ];
-
-        long targetRank = pieceRank;
-        long targetFile = pieceFile;
-
-        for ( short distance = 1; distance < 8; distance++ )
-        {
-            targetRank += rankOffset;
-            targetFile += fileOffset;
-
-            if ( targetRank < 0 || targetRank > 7 )
-            {
-                break;
-            }
-
-            if ( targetFile < 0 || targetFile > 7 )
-            {
-                break;
-            }
+        movedPiece = self->squares[ to ];
 
-            const unsigned long targetIndex = ( targetRank << 3 ) | targetFile;
-            const unsigned long long targetBit = 1ull << targetIndex;
-
-            // If we hit a friendly piece, then the search in this direction is over
+        Board_movePiece( self, friendlyPieces, to, from );
+    }
 
-            if ( friendlyPieces->bbAll & targetBit )
-            {
-                break;
-            }
+    // - put back anything that was captured, remembering that en passant captures are not on "to"
+    if ( undo->capturedPiece != EMPTY )
+    {
+        Board_setSquare( self, attackerPieces, undo->capturedPiece, to );
+    }
+    else if ( to == undo->enPassantSquare && Board_isPawn( movedPiece ) )
+    {
+        const unsigned long enPassantAttackerIndex = self->whiteToMove ? to - 8 : to + 8;
 
-            // If we hit an attacker, check for what it is - otherwise, continue the search
+        Board_setSquare( self, attackerPieces, self->whiteToMove ? BLACK_PAWN : WHITE_PAWN, enPassantAttackerIndex );
+    }
 
-            if ( attackerPieces->bbAll & targetBit )
-            {
-                // If we are right next to the original piece, then the opponent king could be involved here
+    // - put the rook back if this was castling
+    if ( Board_isKing( movedPiece ) && abs( from - to ) == 2 )
+    {
+        if ( from < to )
+        {
+            Board_movePiece( self, friendlyPieces, from + 1, from + 3 );
+        }
+        else
+        {
+            Board_movePiece( self, friendlyPieces, from - 1, from - 4 );
+        }
+    }
 
-                if ( distance == 1 )
-                {
-                    // Test king
-                    if ( attackerPieces->bbKing & targetBit )
-                    {
-                        return true;
-                    }
-                }
+    // - restore the state that can't be worked out from the move
+    self->whitePieces.kingsideCastling = ( undo->castlingRights & WHITE_KINGSIDE ) != 0;
+    self->whitePieces.queensideCastling = ( undo->castlingRights & WHITE_QUEENSIDE ) != 0;
+    self->blackPieces.kingsideCastling = ( undo->castlingRights & BLACK_KINGSIDE ) != 0;
+    self->blackPieces.queensideCastling = ( undo->castlingRights & BLACK_QUEENSIDE ) != 0;
 
-                // Check the direction of travel to see if we encounter a piece that could attack is in this direction
+    self->enPassantSquare = undo->enPassantSquare;
+    self->halfmoveClock = undo->halfmoveClock;
 
-                if ( rankOffset == 0 || fileOffset == 0 )
-                {
-                    // Test horizontal/vertical - rook or queen
+    // The pawn and material keys have been put back by moving the pieces, but the main key also
+    // covers the state restored above, so is simplest restored in one go
+    self->key = undo->key;
+}
 
-                    if ( targetBit & ( attackerPieces->bbRook | attackerPieces->bbQueen ) )
-                    {
-                        return true;
-                    }
-                }
-                else
-                {
-                    // Test diagonals - bishop or queen
+void Board_makeNullMove( Board* self, Undo* undo )
+{
+    undo->capturedPiece = EMPTY;
+    undo->castlingRights = Board_castlingRights( self );
+    undo->enPassantSquare = (unsigned char) self->enPassantSquare;
+    undo->halfmoveClock = self->halfmoveClock;
+    undo->key = self->key;
+
+    // An en passant capture is only ever possible on the move straight after the double pawn move
+    self->key ^= Board_enPassantKey( self ) ^ zobristBlackToMove;
+    self->enPassantSquare = OFF_BOARD;
 
-                    if ( targetBit & ( attackerPieces->bbBishop | attackerPieces->bbQueen ) )
-                    {
-                        return true;
-                    }
+    // Nothing before a null move can be repeated by a real move after it, so count it as irreversible,
+    // which stops the search for repetitions there
+    self->whiteToMove = !self->whiteToMove;
+    self->halfmoveClock = 0;
+}
 
-                    // With a bit more logic, we can also test potential pawn captures
-                    // Note the use of directionOfTravel here as we are testing whether we can take the pawn as
-                    // an assessment of whether, if the move was made, the pawn could take us
+void Board_unmakeNullMove( Board* self, const Undo* undo )
+{
+    self->whiteToMove = !self->whiteToMove;
 
-                    if ( rankOffset == directionOfTravel && distance == 1 )
-                    {
-                        if ( targetBit & attackerPieces->bbPawn )
-                        {
-                            return true;
-                        }
-                    }
-                }
+    self->enPassantSquare = undo->enPassantSquare;
+    self->halfmoveClock = undo->halfmoveClock;
+    self->key = undo->key;
+}
 
-                // If we get here, there was an enemy piece detected, just not one that can attack us from here.
-                // Regardless, it stops the search in this direction
-                break;
-            }
+bool Board_isRepetition( Board* self, const KeyHistory* history )
+{
+    // A capture, pawn move or null move can't be undone, so nothing before the last one can come round
+    // again. Of what is left, only every other position has the same side to move, and the nearest of
+    // those that could be the same is four plies back
+    const int oldest = history->count > self->halfmoveClock ? history->count - self->halfmoveClock : 0;
 
-            // Neither friend or attacker here - move on to the next square in this direction
+    for ( int index = history->count - 4; index >= oldest; index -= 2 )
+    {
+        if ( history->keys[ index ] == self->key )
+        {
+            return true;
         }
     }
 
     return false;
 }
 
-bool Board_isAttacking( Board* self, unsigned long index )
+void KeyHistory_clear( KeyHistory* self )
 {
-    static const directionArray[ 8 ][ 2 ] = 
-    {
-        {-1,-1},
-        {-1, 0},
-        {-1,+1},
-        { 0,-1},
-        { 0,+1},
-        {+1,-1},
-        {+1, 0},
-        {+1,+1},
-    };
-
-    const PieceList* friendlyPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
-    const PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
-
-    const long pieceRank = Board_rankFromIndex( index );
-    const long pieceFile = Board_fileFromIndex( index );
-
-    const short directionOfTravel = self->whiteToMove ? +1 : -1;
+    self->count = 0;
+}
 
-    // Knight attack
-    unsigned long* directions = knightDirections[ index ];
-    for ( short loop = 0; loop < 8; loop++ )
+void KeyHistory_push( KeyHistory* self, unsigned long long key )
+{
+    // Only a game with hundreds of moves since the last capture or pawn move can get here, and then the
+    // oldest half of the keys are too far back to matter
+    if ( self->count == KEY_HISTORY_SIZE )
     {
-        if ( directions[ loop ] != 0 )
-        {
-            unsigned long long target = 1ull << ( index + directions[ loop ] );
-
-            if ( friendlyPieces->bbKnight & target )
-            {
-                return true;
-            }
-        }
+        memmove( self->keys, self->keys + KEY_HISTORY_SIZE / 2, ( KEY_HISTORY_SIZE / 2 ) * sizeof( unsigned long long ) );
+        self->count = KEY_HISTORY_SIZE / 2;
     }
 
-    // Use one method to check for Pawn, Bishop, Rook, Queen, King attack
-    for ( short directionIndex = 0; directionIndex < 8; directionIndex++ )
-    {
-        short rankOffset = directionArray[ directionIndex ][ 1 ];
-        short fileOffset = directionArray[ directionIndex ][ 0 ];
-
-        long targetRank = pieceRank;
-        long targetFile = pieceFile;
-
-        for ( short distance = 1; distance < 8; distance++ )
-        {
-            targetRank += rankOffset;
-            targetFile += fileOffset;
-
-            if ( targetRank < 0 || targetRank > 7 )
-            {
-                break;
-            }
-
-            if ( targetFile < 0 || targetFile > 7 )
-            {
-                break;
-            }
-
-            const unsigned long targetIndex = ( targetRank << 3 ) | targetFile;
-            const unsigned long long targetBit = 1ull << targetIndex;
-
-            // If we hit an attacker piece, then the search in this direction is over
-
-            if ( attackerPieces->bbAll & targetBit )
-            {
-                break;
-            }
-
-            // If we hit an friendly piece, see what it is and then terminate the search in this direction
-
-            if ( friendlyPieces->bbAll & targetBit )
-            {
-                // If we are right next to the original piece, then even our king counts as an attacker
-
-                if ( distance == 1 )
-                {
-                    // Test king
-                    if ( friendlyPieces->bbKing & targetBit )
-                    {
-                        return true;
-                    }
-                }
-
-                // Check the direction of travel to see if we encounter a piece that could attack is in this direction
+    self->keys[ self->count++ ] = key;
+}
 
-                if ( rankOffset == 0 || fileOffset == 0 )
-                {
-                    // Test horizontal/vertical - rook or queen
+void KeyHistory_pop( KeyHistory* self )
+{
+    self->count--;
+}
 
-                    if ( targetBit & ( friendlyPieces->bbRook | friendlyPieces->bbQueen ) )
-                    {
-                        return true;
-                    }
-                }
-                else
-                {
-                    // Test diagonals - bishop or queen
+void Board_copy( Board* self, Board* copy ) 
+{
+    memcpy( copy, self, sizeof( Board ) );
+}
 
-                    if ( targetBit & ( friendlyPieces->bbBishop | friendlyPieces->bbQueen ) )
-                    {
-                        return true;
-                    }
+void Board_apply( Board* self, Board* other ) 
+{
+    memcpy( self, other, sizeof( Board ) );
+}
 
-                    // With a bit more logic, we can also test pawn
-                    // Note the use of directionOfTravel here as we are testing whether we can take the pawn as
-                    // an assessment of whether, if the move was made, the pawn could take us
+bool Board_compare( Board* self, Board* other ) 
+{
+    return memcmp( self, other, sizeof( Board ) ) == 0;
+}
 
-                    if ( rankOffset == -directionOfTravel && distance == 1 )
-                    {
-                        if ( targetBit & friendlyPieces->bbPawn )
-                        {
-                            return true;
-                        }
-                    }
-                }
+bool Board_isAttacked( Board* self, unsigned long index )
+{
+    const PieceList* attackerPieces = self->whiteToMove ? &self->blackPieces : &self->whitePieces;
 
-                // Got here because we found a friendly piece that is not an attacker in this direction
-                break;
-            }
+    return Board_attackersOf( self, attackerPieces, index, self->whitePieces.bbAll | self->blackPieces.bbAll ) != 0;
+}
 
-            // If we are here, that was an empty square - keep looking in this direction
-        }
-    }
+bool Board_isAttacking( Board* self, unsigned long index )
+{
+    const PieceList* attackerPieces = self->whiteToMove ? &self->whitePieces : &self->blackPieces;
 
-    return false;
+    return Board_attackersOf( self, attackerPieces, index, self->whitePieces.bbAll | self->blackPieces.bbAll ) != 0;
 }
 
 void Board_addMove( Board* self, MoveList* moveList, Move move )
@@ -37,6 +37,11 @@ enum Piece
     UNUSED_3,
 };
 
+// To separate a Piece into its color and its ColorlessPiece.
+// This is expected to give us 0b00001000 and 0b00000111
+static const char COLOR_BIT = BLACK_PAWN - WHITE_PAWN;
+static const char COLOR_MASK = BLACK_PAWN - WHITE_PAWN - 1;
+
 // To correspond with the Piece enum
 enum ColorlessPiece
 {
@@ -62,6 +67,19 @@ typedef struct
     bool queensideCastling;
 } PieceList;
 
+// How many piece changes are recorded for the network before it is simpler for it to start again
+#define MAX_PIECE_CHANGES 32
+
+/// <summary>
+/// A piece put on or taken off a square, as recorded for the network to catch up with
+/// </summary>
+typedef struct
+{
+    unsigned char piece;
+    unsigned char square;
+    bool added;
+} PieceChange;
+
 typedef struct 
 {
     unsigned char squares[ 64 ];
@@ -71,8 +89,63 @@ typedef struct
     unsigned long enPassantSquare;
     unsigned short halfmoveClock;
     unsigned short fullmoveNumber;
+
+    // Zobrist keys, kept up to date as pieces are placed, removed and moved. The pawn key covers only
+    // the pawns, and the material key only how many of each piece there are, not where they are
+    unsigned long long key;
+    unsigned long long pawnKey;
+    unsigned long long materialKey;
+
+    // Evaluation terms, kept up to date in the same way. The material and piece-square scores are from
+    // white's point of view, for the middlegame and the endgame, and the phase says how far between the
+    // two the position is
+    int middlegameScore;
+    int endgameScore;
+    int phase;
+
+    // Pieces other than kings put on and taken off the board since the network's accumulators were last brought up
+    // to date, which is left until they are needed. Either side's accumulator is worked out again from scratch instead
+    // once its king has moved, as every feature depends on where the king is, or once there are too many changes
+    PieceChange pieceChanges[ MAX_PIECE_CHANGES ];
+    unsigned char pieceChangeCount;
+    bool refreshNeeded[ 2 ];
 } Board;
 
+// Bits for Undo.castlingRights
+enum CastlingRights
+{
+    WHITE_KINGSIDE = 0b0001,
+    WHITE_QUEENSIDE = 0b0010,
+    BLACK_KINGSIDE = 0b0100,
+    BLACK_QUEENSIDE = 0b1000,
+};
+
+/// <summary>
+/// The state that Board_makeMove cannot recover from the move alone, recorded so that 
+/// Board_unmakeMove can put it back. The caller keeps one of these per ply
+/// </summary>
+typedef struct
+{
+    unsigned char capturedPiece;
+    unsigned char castlingRights;
+    unsigned char enPassantSquare;
+    unsigned short halfmoveClock;
+    unsigned long long key;
+} Undo;
+
+// Enough for the longest run of moves without a capture or pawn move that a game is likely to have, plus a search
+#define KEY_HISTORY_SIZE 1024
+
+/// <summary>
+/// The keys of the positions that led to the current one, most recent last, for spotting repetitions. The caller
+/// pushes the key before making each move and pops it after taking the move back
+/// </summary>
+typedef struct
+{
+    unsigned long long keys[ KEY_HISTORY_SIZE ];
+    int count;
+} KeyHistory;
+
 void Board_create( Board* self, const char* fen );
 
 // Internal methods
@@ -166,24 +239,234 @@ void Board_clearSquare( Board* self, PieceList* pieceList, unsigned long index )
 void Board_setSquare( Board* self, PieceList* pieceList, enum Piece piece, unsigned long index );
 
 /// <summary>
-/// Generate the pseudolegal moves for the current position
+/// Move a piece to an empty square, updating only the two squares involved
+/// </summary>
+/// <param name="self">the board</param>
+/// <param name="pieceList">the piece list of the piece being moved</param>
+/// <param name="from">the current location</param>
+/// <param name="to">the new location, which must be empty</param>
+void Board_movePiece( Board* self, PieceList* pieceList, unsigned long from, unsigned long to );
+
+/// <summary>
+/// Generate the legal moves for the current position. Checks and pins are worked out once, up front,
+/// so that only legal moves are ever generated
 /// </summary>
 /// <param name="self">the board</param>
 MoveList* Board_generateMoves( Board* self, MoveList* moveList );
 
+/// <summary>
+/// Generate only the legal captures (including en passant) and promotions for the current position,
+/// without building any quiet moves along the way
+/// </summary>
+/// <param name="self">the board</param>
+MoveList* Board_generateCaptures( Board* self, MoveList* moveList );
+
+/// <summary>
+/// Generate only the legal moves that neither capture nor promote. Together with Board_generateCaptures,
+/// this gives the same moves as Board_generateMoves
+/// </summary>
+/// <param name="self">the board</param>
+MoveList* Board_generateQuiets( Board* self, MoveList* moveList );
+
+/// <summary>
+/// Is this move legal in the current position? Much cheaper than generating every move to look for it,
+/// so suits moves that came from elsewhere, such as the hash table
+/// </summary>
+/// <param name="self">the board</param>
+/// <param name="move">any move, which need not even be pseudolegal</param>
+bool Board_isLegalMove( Board* self, Move move );
+
+/// <summary>
+/// Does this move neither capture nor promote?
+/// </summary>
+/// <param name="self">the board, with the move not yet made</param>
+/// <param name="move">a legal move</param>
+bool Board_isQuiet( Board* self, Move move );
+
+/// <summary>
+/// Returns the castling rights of both sides as CastlingRights bits
+/// </summary>
+/// <param name="self">the board</param>
+unsigned char Board_castlingRights( Board* self );
+
+/// <summary>
+/// Calculate a hash (Zobrist key) of the position from scratch, covering the pieces, side to move,
+/// castling rights and any en passant capture that is available. Board.key holds the same value,
+/// kept up to date incrementally, so this is only needed to set it up
+/// </summary>
+/// <param name="self">the board</param>
+unsigned long long Board_computeKey( Board* self );
+
+/// <summary>
+/// Calculate the hash of just the pawns from scratch, as held in Board.pawnKey
+/// </summary>
+/// <param name="self">the board</param>
+unsigned long long Board_computePawnKey( Board* self );
+
+/// <summary>
+/// Calculate the hash of the number of each type of piece from scratch, as held in Board.materialKey
+/// </summary>
+/// <param name="self">the board</param>
+unsigned long long Board_computeMaterialKey( Board* self );
+
+/// <summary>
+/// Calculate the evaluation terms of the board from scratch, as held in Board.middlegameScore, Board.endgameScore
+/// and Board.phase
+/// </summary>
+/// <param name="self">the board</param>
+void Board_computeEvaluation( Board* self );
+
+/// <summary>
+/// Record a piece being put on or taken off a square, for the network
+/// </summary>
+/// <param name="self">the board</param>
+/// <param name="piece">the piece</param>
+/// <param name="index">the location</param>
+/// <param name="added">true if the piece was put on the square, false if it was taken off</param>
+void Board_recordPieceChange( Board* self, unsigned char piece, unsigned long index, bool added );
+
+/// <summary>
+/// Forget the recorded piece changes, and have the network start again from scratch for both sides
+/// </summary>
+/// <param name="self">the board</param>
+void Board_clearPieceChanges( Board* self );
+
+/// <summary>
+/// The contribution of the en passant square to the key, which is zero unless the capture is possible
+/// </summary>
+/// <param name="self">the board</param>
+unsigned long long Board_enPassantKey( Board* self );
+
+/// <summary>
+/// The bitboard in pieceList that holds pieces of the same type as piece
+/// </summary>
+unsigned long long* Board_pieceBitboard( PieceList* pieceList, unsigned char piece );
+
 /// <summary>
 /// Makes a move but returns false if the move is illegal
 /// </summary>
 /// <param name="self">the board</param>
 /// <param name="move">the pseudolegal move</param>
-bool Board_makeMove( Board* self, Move move );
+/// <param name="undo">receives what is needed to take the move back</param>
+bool Board_makeMove( Board* self, Move move, Undo* undo );
+
+/// <summary>
+/// Takes back a move made with Board_makeMove, touching only the squares involved
+/// </summary>
+/// <param name="self">the board</param>
+/// <param name="move">the move most recently made</param>
+/// <param name="undo">the record filled in when the move was made</param>
+void Board_unmakeMove( Board* self, Move move, const Undo* undo );
+
+/// <summary>
+/// Passes the move to the other side without moving anything, for the search to see how good a position is
+/// when the opponent gets two moves in a row. Must not be used when in check. Resets the halfmove clock, as
+/// no repetition can be found through a null move
+/// </summary>
+/// <param name="self">the board</param>
+/// <param name="undo">receives what is needed to take the null move back</param>
+void Board_makeNullMove( Board* self, Undo* undo );
+
+/// <summary>
+/// Takes back a null move made with Board_makeNullMove
+/// </summary>
+/// <param name="self">the board</param>
+/// <param name="undo">the record filled in when the null move was made</param>
+void Board_unmakeNullMove( Board* self, const Undo* undo );
+
+/// <summary>
+/// Has the current position occurred before, since the last irreversible move?
+/// </summary>
+/// <param name="self">the board</param>
+/// <param name="history">the keys of the positions before this one</param>
+bool Board_isRepetition( Board* self, const KeyHistory* history );
+
+// KeyHistory methods
+
+void KeyHistory_clear( KeyHistory* self );
+void KeyHistory_push( KeyHistory* self, unsigned long long key );
+void KeyHistory_pop( KeyHistory* self );
+
+/// <summary>
+/// Which moves a generator should produce
+/// </summary>
+enum GenerationMode
+{
+    GENERATE_ALL,
+    GENERATE_CAPTURES,
+    GENERATE_QUIETS,
+};
+
+MoveList* Board_generateMovesOfType( Board* self, MoveList* moveList, enum GenerationMode mode );
+
+// The generators for each piece type take the squares a move may end on (which excludes our own pieces
+// and, when in check, anything that doesn't deal with the check) and the set of pinned pieces. The
+// pawn and king generators also need the mode as not all of their moves are limited by the targets
+
+void Board_generatePawnMoves( Board* self, MoveList* moveList, unsigned long long targets, unsigned long long pinned, enum GenerationMode mode );
+void Board_generateKnightMoves( Board* self, MoveList* moveList, unsigned long long targets, unsigned long long pinned );
+void Board_generateBishopMoves( Board* self, MoveList* moveList, unsigned long long targets, unsigned long long pinned );
+void Board_generateRookMoves( Board* self, MoveList* moveList, unsigned long long targets, unsigned long long pinned );
+void Board_generateQueenMoves( Board* self, MoveList* moveList, unsigned long long targets, unsigned long long pinned );
+void Board_generateKingMoves( Board* self, MoveList* moveList, bool inCheck, enum GenerationMode mode );
+
+/// <summary>
+/// Returns the pieces in attackerPieces that attack the square at index, given the occupancy of the board
+/// </summary>
+/// <param name="self">the board</param>
+/// <param name="attackerPieces">the pieces to consider as attackers</param>
+/// <param name="index">the location</param>
+/// <param name="occupancy">all pieces on the board, which may differ from the actual board</param>
+unsigned long long Board_attackersOf( Board* self, const PieceList* attackerPieces, unsigned long index, unsigned long long occupancy );
+
+/// <summary>
+/// Returns the pieces of both colors that attack the square at index, given the occupancy of the board.
+/// Removing a piece from the occupancy uncovers any slider behind it, for following a sequence of captures
+/// </summary>
+/// <param name="self">the board</param>
+/// <param name="index">the location</param>
+/// <param name="occupancy">all pieces on the board, which may differ from the actual board</param>
+unsigned long long Board_attackersTo( Board* self, unsigned long index, unsigned long long occupancy );
+
+/// <summary>
+/// Static exchange evaluation. Works out the material won or lost by a capture once every piece bearing on the
+/// destination has had the chance to recapture, least valuable first, without making any moves. Pins are not
+/// taken into account
+/// </summary>
+/// <param name="self">the board</param>
+/// <param name="move">a legal capture or promotion for the side to move</param>
+/// <returns>the material gained in centipawns, negative if the capture loses material. The sign is exact
+/// but the size may not be once the outcome is clear</returns>
+int Board_staticExchange( Board* self, Move move );
 
-void Board_generatePawnMoves( Board* self, MoveList* moveList );
-void Board_generateKnightMoves( Board* self, MoveList* moveList );
-void Board_generateBishopMoves( Board* self, MoveList* moveList );
-void Board_generateRookMoves( Board* self, MoveList* moveList );
-void Board_generateQueenMoves( Board* self, MoveList* moveList );
-void Board_generateKingMoves( Board* self, MoveList* moveList );
+/// <summary>
+/// Is the side to move in check?
+/// </summary>
+/// <param name="self">the board</param>
+bool Board_isInCheck( Board* self );
+
+/// <summary>
+/// Find the legal move that matches a move in UCI long algebraic notation (e.g. e2e4, e7e8q)
+/// </summary>
+/// <param name="self">the board</param>
+/// <param name="moveString">the move as text</param>
+/// <returns>the move, or NO_MOVE if it is not legal in this position</returns>
+Move Board_parseMove( Board* self, const char* moveString );
+
+/// <summary>
+/// Returns the pieces of the side to move that are pinned against their king
+/// </summary>
+/// <param name="self">the board</param>
+/// <param name="king">the location of the king of the side to move</param>
+unsigned long long Board_pinnedPieces( Board* self, unsigned long king );
+
+/// <summary>
+/// En passant can uncover a check along a rank by removing two pieces at once, so it gets a test of its own
+/// </summary>
+/// <param name="self">the board</param>
+/// <param name="from">the location of the capturing pawn</param>
+/// <param name="targets">the squares that deal with any check</param>
+bool Board_isLegalEnPassant( Board* self, unsigned long from, unsigned long long targets );
 
 /// <summary>
 /// Returns whether the provided square is under attack by the oppponent
@@ -196,6 +479,6 @@ bool Board_isAttacked( Board* self, unsigned long index );
 bool Board_isAttacking( Board* self, unsigned long index );
 
 /// <summary>
-/// Calls MoveList_addMove iff the move is legal (doesn't leave the king in check)
+/// Calls MoveList_addMove. The generators only ever produce legal moves, so no test is needed here
 /// </summary>
 void Board_addMove( Board* self, MoveList* moveList, Move move );
\ No newline at end of file
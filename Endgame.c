@@ -0,0 +1,95 @@
+#include <io.h>
+#include <ctype.h>
+#include <errno.h>
+#include <intrin.h>
+#include <memory.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "Endgame.h"
+
+// Rough piece values, indexed by ColorlessPiece, so that more material still scores higher
+static const int endgameValues[ 7 ] = { 0, 100, 300, 300, 500, 900, 0 };
+
+// Mate needs the losing king on the edge, and the winning king close by to take away its last squares
+#define EDGE_BONUS 20
+#define CLOSENESS_BONUS 10
+
+// In KBNK, only two of the corners will do
+#define CORNER_BONUS 30
+
+// Indexed by EndgameType
+static const EndgameEvaluator evaluators[] = { NULL, Endgame_kxk, Endgame_kbnk };
+
+EndgameEvaluator Endgame_evaluator( enum EndgameType type )
+{
+    return evaluators[ type ];
+}
+
+int Endgame_kxk( Board* board, bool strongWhite )
+{
+    const PieceList* strongPieces = strongWhite ? &board->whitePieces : &board->blackPieces;
+    const PieceList* weakPieces = strongWhite ? &board->blackPieces : &board->whitePieces;
+
+    // The search will find the mate in the end. Until then, what matters is herding the lone king towards it
+    const int score = ENDGAME_KNOWN_WIN +
+                      Endgame_material( strongPieces ) +
+                      EDGE_BONUS * Endgame_centreDistance( weakPieces->king ) +
+                      CLOSENESS_BONUS * ( 7 - Endgame_distance( strongPieces->king, weakPieces->king ) );
+
+    return strongWhite ? score : -score;
+}
+
+int Endgame_kbnk( Board* board, bool strongWhite )
+{
+    const PieceList* strongPieces = strongWhite ? &board->whitePieces : &board->blackPieces;
+    const PieceList* weakPieces = strongWhite ? &board->blackPieces : &board->whitePieces;
+
+    unsigned long bishop;
+    _BitScanForward64( &bishop, strongPieces->bbBishop );
+
+    // a1 and h8 are dark, as are all the squares where rank and file add up to an even number
+    const bool darkBishop = ( ( Board_rankFromIndex( bishop ) + Board_fileFromIndex( bishop ) ) & 1 ) == 0;
+
+    const int first = Endgame_distance( weakPieces->king, darkBishop ? A1 : H1 );
+    const int second = Endgame_distance( weakPieces->king, darkBishop ? H8 : A8 );
+    const int cornerDistance = first < second ? first : second;
+
+    // The lone king heads for the wrong corner, so it has to be pushed along the edge from there
+    const int score = ENDGAME_KNOWN_WIN +
+                      Endgame_material( strongPieces ) +
+                      CORNER_BONUS * ( 7 - cornerDistance ) +
+                      CLOSENESS_BONUS * ( 7 - Endgame_distance( strongPieces->king, weakPieces->king ) );
+
+    return strongWhite ? score : -score;
+}
+
+int Endgame_material( const PieceList* pieces )
+{
+    return endgameValues[ PAWN ] * (int) __popcnt64( pieces->bbPawn ) +
+           endgameValues[ KNIGHT ] * (int) __popcnt64( pieces->bbKnight ) +
+           endgameValues[ BISHOP ] * (int) __popcnt64( pieces->bbBishop ) +
+           endgameValues[ ROOK ] * (int) __popcnt64( pieces->bbRook ) +
+           endgameValues[ QUEEN ] * (int) __popcnt64( pieces->bbQueen );
+}
+
+int Endgame_distance( unsigned long from, unsigned long to )
+{
+    // In king moves
+    const int ranks = abs( (int) Board_rankFromIndex( from ) - (int) Board_rankFromIndex( to ) );
+    const int files = abs( (int) Board_fileFromIndex( from ) - (int) Board_fileFromIndex( to ) );
+
+    return ranks > files ? ranks : files;
+}
+
+int Endgame_centreDistance( unsigned long index )
+{
+    // From the four central squares, in rank and file steps combined, so 0 in the centre and 6 in a corner
+    const int rank = (int) Board_rankFromIndex( index );
+    const int file = (int) Board_fileFromIndex( index );
+
+    return ( rank < 4 ? 3 - rank : rank - 4 ) + ( file < 4 ? 3 - file : file - 4 );
+}
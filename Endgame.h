@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Board.h"
+
+// A win that the search need not prove, scored well above anything material could add up to but below any mate
+#define ENDGAME_KNOWN_WIN 10000
+
+/// <summary>
+/// The endgames that have an evaluation of their own, recognised from the material alone. The side with the
+/// pieces is the strong side
+/// </summary>
+enum EndgameType
+{
+    ENDGAME_NONE = 0,
+
+    // King and enough to force mate without pawns, such as a queen, a rook or two bishops, against a lone king
+    ENDGAME_KXK,
+
+    // King, bishop and knight against a lone king, where only the corners of the bishop's color are mates
+    ENDGAME_KBNK,
+};
+
+/// <summary>
+/// Scores a recognised endgame
+/// </summary>
+/// <param name="board">the position</param>
+/// <param name="strongWhite">whether white is the strong side</param>
+/// <returns>the score, from white's point of view</returns>
+typedef int ( *EndgameEvaluator )( Board* board, bool strongWhite );
+
+// Public methods
+
+/// <summary>
+/// Returns the evaluator for an endgame, or NULL for ENDGAME_NONE
+/// </summary>
+EndgameEvaluator Endgame_evaluator( enum EndgameType type );
+
+// Internal methods
+
+int Endgame_kxk( Board* board, bool strongWhite );
+int Endgame_kbnk( Board* board, bool strongWhite );
+int Endgame_material( const PieceList* pieces );
+int Endgame_distance( unsigned long from, unsigned long to );
+int Endgame_centreDistance( unsigned long index );
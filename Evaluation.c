@@ -0,0 +1,261 @@
+#include <io.h>
+#include <ctype.h>
+#include <errno.h>
+#include <intrin.h>
+#include <memory.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "Evaluation.h"
+
+// Dark squares, a1 among them, for telling whether two bishops are on the same color
+#define DARK_SQUARES 0xaa55aa55aa55aa55ull
+
+// Bishops on opposite colors, with nothing else besides pawns, are very drawish. Scale an advantage to this
+#define OPPOSITE_BISHOPS_SCALE 24
+
+// Material values in centipawns, indexed by ColorlessPiece. The king is never captured, so has none
+static const int middlegameValues[ 7 ] = { 0, 82, 337, 365, 477, 1025, 0 };
+static const int endgameValues[ 7 ] = { 0, 94, 281, 297, 512, 936, 0 };
+
+// How much each piece, indexed by ColorlessPiece, adds to the game phase
+static const int phaseValues[ 7 ] = { 0, 0, 1, 1, 2, 4, 0 };
+
+// Piece-square tables for white, laid out as the board is seen from white's side, so rank 8 comes first and
+// the square index has to be flipped vertically to look up a white piece. Black pieces use the same tables
+// without the flip
+
+static const int middlegamePawn[ 64 ] =
+{
+      0,   0,   0,   0,   0,   0,   0,   0,
+     98, 134,  61,  95,  68, 126,  34, -11,
+     -6,   7,  26,  31,  65,  56,  25, -20,
+    -14,  13,   6,  21,  23,  12,  17, -23,
+    -27,  -2,  -5,  12,  17,   6,  10, -25,
+    -26,  -4,  -4, -10,   3,   3,  33, -12,
+    -35,  -1, -20, -23, -15,  24,  38, -22,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+static const int endgamePawn[ 64 ] =
+{
+      0,   0,   0,   0,   0,   0,   0,   0,
+    178, 173, 158, 134, 147, 132, 165, 187,
+     94, 100,  85,  67,  56,  53,  82,  84,
+     32,  24,  13,   5,  -2,   4,  17,  17,
+     13,   9,  -3,  -7,  -7,  -8,   3,  -1,
+      4,   7,  -6,   1,   0,  -5,  -1,  -8,
+     13,   8,   8,  10,  13,   0,   2,  -7,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+static const int middlegameKnight[ 64 ] =
+{
+    -167, -89, -34, -49,  61, -97, -15, -107,
+     -73, -41,  72,  36,  23,  62,   7,  -17,
+     -47,  60,  37,  65,  84, 129,  73,   44,
+      -9,  17,  19,  53,  37,  69,  18,   22,
+     -13,   4,  16,  13,  28,  19,  21,   -8,
+     -23,  -9,  12,  10,  19,  17,  25,  -16,
+     -29, -53, -12,  -3,  -1,  18, -14,  -19,
+    -105, -21, -58, -33, -17, -28, -19,  -23,
+};
+
+static const int endgameKnight[ 64 ] =
+{
+    -58, -38, -13, -28, -31, -27, -63, -99,
+    -25,  -8, -25,  -2,  -9, -25, -24, -52,
+    -24, -20,  10,   9,  -1,  -9, -19, -41,
+    -17,   3,  22,  22,  22,  11,   8, -18,
+    -18,  -6,  16,  25,  16,  17,   4, -18,
+    -23,  -3,  -1,  15,  10,  -3, -20, -22,
+    -42, -20, -10,  -5,  -2, -20, -23, -44,
+    -29, -51, -23, -15, -22, -18, -50, -64,
+};
+
+static const int middlegameBishop[ 64 ] =
+{
+    -29,   4, -82, -37, -25, -42,   7,  -8,
+    -26,  16, -18, -13,  30,  59,  18, -47,
+    -16,  37,  43,  40,  35,  50,  37,  -2,
+     -4,   5,  19,  50,  37,  37,   7,  -2,
+     -6,  13,  13,  26,  34,  12,  10,   4,
+      0,  15,  15,  15,  14,  27,  18,  10,
+      4,  15,  16,   0,   7,  21,  33,   1,
+    -33,  -3, -14, -21, -13, -12, -39, -21,
+};
+
+static const int endgameBishop[ 64 ] =
+{
+    -14, -21, -11,  -8,  -7,  -9, -17, -24,
+     -8,  -4,   7, -12,  -3, -13,  -4, -14,
+      2,  -8,   0,  -1,  -2,   6,   0,   4,
+     -3,   9,  12,   9,  14,  10,   3,   2,
+     -6,   3,  13,  19,   7,  10,  -3,  -9,
+    -12,  -3,   8,  10,  13,   3,  -7, -15,
+    -14, -18,  -7,  -1,   4,  -9, -15, -27,
+    -23,  -9, -23,  -5,  -9, -16,  -5, -17,
+};
+
+static const int middlegameRook[ 64 ] =
+{
+     32,  42,  32,  51,  63,   9,  31,  43,
+     27,  32,  58,  62,  80,  67,  26,  44,
+     -5,  19,  26,  36,  17,  45,  61,  16,
+    -24, -11,   7,  26,  24,  35,  -8, -20,
+    -36, -26, -12,  -1,   9,  -7,   6, -23,
+    -45, -25, -16, -17,   3,   0,  -5, -33,
+    -44, -16, -20,  -9,  -1,  11,  -6, -71,
+    -19, -13,   1,  17,  16,   7, -37, -26,
+};
+
+static const int endgameRook[ 64 ] =
+{
+     13,  10,  18,  15,  12,  12,   8,   5,
+     11,  13,  13,  11,  -3,   3,   8,   3,
+      7,   7,   7,   5,   4,  -3,  -5,  -3,
+      4,   3,  13,   1,   2,   1,  -1,   2,
+      3,   5,   8,   4,  -5,  -6,  -8, -11,
+     -4,   0,  -5,  -1,  -7, -12,  -8, -16,
+     -6,  -6,   0,   2,  -9,  -9, -11,  -3,
+     -9,   2,   3,  -1,  -5, -13,   4, -20,
+};
+
+static const int middlegameQueen[ 64 ] =
+{
+    -28,   0,  29,  12,  59,  44,  43,  45,
+    -24, -39,  -5,   1, -16,  57,  28,  54,
+    -13, -17,   7,   8,  29,  56,  47,  57,
+    -27, -27, -16, -16,  -1,  17,  -2,   1,
+     -9, -26,  -9, -10,  -2,  -4,   3,  -3,
+    -14,   2, -11,  -2,  -5,   2,  14,   5,
+    -35,  -8,  11,   2,   8,  15,  -3,   1,
+     -1, -18,  -9,  10, -15, -25, -31, -50,
+};
+
+static const int endgameQueen[ 64 ] =
+{
+     -9,  22,  22,  27,  27,  19,  10,  20,
+    -17,  20,  32,  41,  58,  25,  30,   0,
+    -20,   6,   9,  49,  47,  35,  19,   9,
+      3,  22,  24,  45,  57,  40,  57,  36,
+    -18,  28,  19,  47,  31,  34,  39,  23,
+    -16, -27,  15,   6,   9,  17,  10,   5,
+    -22, -23, -30, -16, -16, -23, -36, -32,
+    -33, -28, -22, -43,  -5, -32, -20, -41,
+};
+
+static const int middlegameKing[ 64 ] =
+{
+    -65,  23,  16, -15, -56, -34,   2,  13,
+     29,  -1, -20,  -7,  -8,  -4, -38, -29,
+     -9,  24,   2, -16, -20,   6,  22, -22,
+    -17, -20, -12, -27, -30, -25, -14, -36,
+    -49,  -1, -27, -39, -46, -44, -33, -51,
+    -14, -14, -22, -46, -44, -30, -15, -27,
+      1,   7,  -8, -64, -43, -16,   9,   8,
+    -15,  36,  12, -54,   8, -28,  24,  14,
+};
+
+static const int endgameKing[ 64 ] =
+{
+    -74, -35, -18, -18, -11,  15,   4, -17,
+    -12,  17,  14,  17,  17,  38,  23,  11,
+     10,  17,  23,  15,  20,  45,  44,  13,
+     -8,  22,  24,  27,  26,  33,  26,   3,
+    -18,  -4,  21,  24,  27,  23,   9, -11,
+    -19,  -3,  11,  21,  23,  16,   7,  -9,
+    -27, -11,   4,  13,  14,   4,  -5, -17,
+    -53, -34, -21, -11, -28, -14, -24, -43,
+};
+
+// Indexed by ColorlessPiece
+static const int* middlegameTables[ 7 ] = { NULL, middlegamePawn, middlegameKnight, middlegameBishop, middlegameRook, middlegameQueen, middlegameKing };
+static const int* endgameTables[ 7 ] = { NULL, endgamePawn, endgameKnight, endgameBishop, endgameRook, endgameQueen, endgameKing };
+
+void Evaluation_fillTables( int middlegame[ 16 ][ 64 ], int endgame[ 16 ][ 64 ], int phase[ 16 ] )
+{
+    memset( middlegame, 0, 16 * 64 * sizeof( int ) );
+    memset( endgame, 0, 16 * 64 * sizeof( int ) );
+    memset( phase, 0, 16 * sizeof( int ) );
+
+    for ( unsigned char piece = PAWN; piece <= KING; piece++ )
+    {
+        const unsigned char whitePiece = piece;
+        const unsigned char blackPiece = piece | COLOR_BIT;
+
+        for ( unsigned long index = 0; index < 64; index++ )
+        {
+            // The tables start from a8, so a white piece on a1 reads the entry for a8, and a black piece on a8
+            // reads it as it is
+            middlegame[ whitePiece ][ index ] = middlegameValues[ piece ] + middlegameTables[ piece ][ index ^ 56 ];
+            endgame[ whitePiece ][ index ] = endgameValues[ piece ] + endgameTables[ piece ][ index ^ 56 ];
+
+            middlegame[ blackPiece ][ index ] = -( middlegameValues[ piece ] + middlegameTables[ piece ][ index ] );
+            endgame[ blackPiece ][ index ] = -( endgameValues[ piece ] + endgameTables[ piece ][ index ] );
+        }
+
+        phase[ whitePiece ] = phaseValues[ piece ];
+        phase[ blackPiece ] = phaseValues[ piece ];
+    }
+}
+
+int Evaluation_evaluate( Board* board, struct PawnTable* pawnTable, struct MaterialTable* materialTable )
+{
+    MaterialData material;
+    MaterialTable_probe( materialTable, board, &material );
+
+    // A recognised endgame knows better than the general terms, so none of them are needed
+    if ( material.evaluator != NULL )
+    {
+        const int score = material.evaluator( board, material.strongWhite );
+
+        return board->whiteToMove ? score : -score;
+    }
+
+    int middlegame = board->middlegameScore + material.middlegame;
+    int endgame = board->endgameScore + material.endgame;
+
+    PawnData pawns;
+    PawnTable_probe( pawnTable, board, &pawns );
+
+    middlegame += pawns.middlegame;
+    endgame += pawns.endgame;
+
+    // Pawn cover only counts for a king that is still at home. Like everything else in the middlegame score, it
+    // matters less as the pieces that could attack the king come off
+    const unsigned long whiteKing = board->whitePieces.king;
+    const unsigned long blackKing = board->blackPieces.king;
+
+    if ( Board_rankFromIndex( whiteKing ) <= 1 )
+    {
+        middlegame += pawns.shields[ 0 ][ Board_fileFromIndex( whiteKing ) ];
+    }
+
+    if ( Board_rankFromIndex( blackKing ) >= 6 )
+    {
+        middlegame -= pawns.shields[ 1 ][ Board_fileFromIndex( blackKing ) ];
+    }
+
+    const int phase = board->phase < EVALUATION_MAXIMUM_PHASE ? board->phase : EVALUATION_MAXIMUM_PHASE;
+
+    // Slide from the middlegame score with everything on the board to the endgame score with nothing left
+    int score = ( middlegame * phase + endgame * ( EVALUATION_MAXIMUM_PHASE - phase ) ) / EVALUATION_MAXIMUM_PHASE;
+
+    // Some material is much harder to win with than it looks, depending on which side has it
+    int scale = material.scale[ score > 0 ? 0 : 1 ];
+
+    if ( material.oppositeBishops &&
+         scale > OPPOSITE_BISHOPS_SCALE &&
+         ( ( board->whitePieces.bbBishop & DARK_SQUARES ) != 0 ) != ( ( board->blackPieces.bbBishop & DARK_SQUARES ) != 0 ) )
+    {
+        scale = OPPOSITE_BISHOPS_SCALE;
+    }
+
+    score = score * scale / SCALE_NORMAL;
+
+    return board->whiteToMove ? score : -score;
+}
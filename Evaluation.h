@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Board.h"
+#include "MaterialTable.h"
+#include "PawnTable.h"
+
+// The game phase, worked out from the pieces other than pawns and kings, is this with all of them on the
+// board and 0 with none. Promotions can take it higher, in which case it counts as this
+#define EVALUATION_MAXIMUM_PHASE 24
+
+// Public methods
+
+/// <summary>
+/// Fill in the tables that Board uses to keep its running evaluation terms up to date as pieces are placed,
+/// removed and moved. Indexed by Piece and square, from white's point of view, so black pieces score negatively
+/// </summary>
+/// <param name="middlegame">receives the material plus piece-square value of each piece on each square in the middlegame</param>
+/// <param name="endgame">receives the same for the endgame</param>
+/// <param name="phase">receives how much each piece adds to the game phase</param>
+void Evaluation_fillTables( int middlegame[ 16 ][ 64 ], int endgame[ 16 ][ 64 ], int phase[ 16 ] );
+
+/// <summary>
+/// Returns the static evaluation of the position, in centipawns from the point of view of the side to move.
+/// The middlegame and endgame scores kept by the board, and those of the material balance and pawn structure,
+/// are blended by the game phase, so this is cheap. Recognised endgames are handed to their own evaluators
+/// </summary>
+/// <param name="board">the position</param>
+/// <param name="pawnTable">where the pawn structure is looked up</param>
+/// <param name="materialTable">where the material balance is looked up</param>
+int Evaluation_evaluate( Board* board, struct PawnTable* pawnTable, struct MaterialTable* materialTable );
@@ -0,0 +1,202 @@
+#include <io.h>
+#include <ctype.h>
+#include <errno.h>
+#include <intrin.h>
+#include <memory.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "Magic.h"
+
+// Sizes of the attack tables when every square's subsets are packed one after the other
+#define BISHOP_TABLE_SIZE 5248
+#define ROOK_TABLE_SIZE 102400
+
+// The largest number of occupancy subsets for any one square (a rook in a corner)
+#define MAX_SUBSETS 4096
+
+static const short bishopVectors[ 4 ][ 2 ] =
+{
+    {-1,-1},
+    {-1,+1},
+    {+1,-1},
+    {+1,+1},
+};
+
+static const short rookVectors[ 4 ][ 2 ] =
+{
+    {-1, 0},
+    { 0,-1},
+    { 0,+1},
+    {+1, 0},
+};
+
+static Magic bishopMagics[ 64 ];
+static Magic rookMagics[ 64 ];
+
+static unsigned long long bishopTable[ BISHOP_TABLE_SIZE ];
+static unsigned long long rookTable[ ROOK_TABLE_SIZE ];
+
+static bool initialized = false;
+
+// Fixed seeds, one per rank, that are known to find magics quickly. The same magics are therefore
+// found on every run
+static const unsigned long long randomSeeds[ 8 ] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+static unsigned long long randomState;
+
+static unsigned long long Magic_random()
+{
+    // xorshift64*
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+    return randomState * 2685821657736338717ull;
+}
+
+void Magic_initialize()
+{
+    if ( initialized )
+    {
+        return;
+    }
+
+    Magic_initializePiece( bishopMagics, bishopTable, bishopVectors );
+    Magic_initializePiece( rookMagics, rookTable, rookVectors );
+
+    initialized = true;
+}
+
+unsigned long long Magic_bishopAttacks( unsigned long index, unsigned long long occupancy )
+{
+    const Magic* magic = &bishopMagics[ index ];
+    return magic->attacks[ ( ( occupancy & magic->mask ) * magic->magic ) >> magic->shift ];
+}
+
+unsigned long long Magic_rookAttacks( unsigned long index, unsigned long long occupancy )
+{
+    const Magic* magic = &rookMagics[ index ];
+    return magic->attacks[ ( ( occupancy & magic->mask ) * magic->magic ) >> magic->shift ];
+}
+
+unsigned long long Magic_queenAttacks( unsigned long index, unsigned long long occupancy )
+{
+    return Magic_bishopAttacks( index, occupancy ) | Magic_rookAttacks( index, occupancy );
+}
+
+unsigned long long Magic_slidingAttacks( const short vectors[ 4 ][ 2 ], unsigned long index, unsigned long long occupancy )
+{
+    // The slow way, walking each ray until we run off the board or hit something. Only used to
+    // build the tables
+    unsigned long long attacks = 0;
+
+    const long pieceRank = index >> 3;
+    const long pieceFile = index & 0b00000111;
+
+    for ( unsigned short vectorIndex = 0; vectorIndex < 4; vectorIndex++ )
+    {
+        long rank = pieceRank + vectors[ vectorIndex ][ 0 ];
+        long file = pieceFile + vectors[ vectorIndex ][ 1 ];
+
+        while ( rank >= 0 && rank <= 7 && file >= 0 && file <= 7 )
+        {
+            const unsigned long long targetBit = 1ull << ( ( rank << 3 ) + file );
+
+            attacks |= targetBit;
+
+            if ( occupancy & targetBit )
+            {
+                // Blocked - the blocker itself is attacked but nothing beyond it
+                break;
+            }
+
+            rank += vectors[ vectorIndex ][ 0 ];
+            file += vectors[ vectorIndex ][ 1 ];
+        }
+    }
+
+    return attacks;
+}
+
+void Magic_initializePiece( Magic* magics, unsigned long long* table, const short vectors[ 4 ][ 2 ] )
+{
+    static unsigned long long occupancies[ MAX_SUBSETS ];
+    static unsigned long long references[ MAX_SUBSETS ];
+    static unsigned int epochs[ MAX_SUBSETS ];
+
+    // The edge squares never affect what is attacked (there is nothing beyond them), so are left out
+    // of the masks - other than when the piece is on that edge itself
+    const unsigned long long rank1 = 0x00000000000000ffull;
+    const unsigned long long rank8 = 0xff00000000000000ull;
+    const unsigned long long fileA = 0x0101010101010101ull;
+    const unsigned long long fileH = 0x8080808080808080ull;
+
+    unsigned long long* attacks = table;
+    unsigned int epoch = 0;
+
+    memset( epochs, 0, sizeof( epochs ) );
+
+    for ( unsigned long index = 0; index < 64; index++ )
+    {
+        Magic* magic = &magics[ index ];
+
+        const unsigned long long edges = ( ( rank1 | rank8 ) & ~( rank1 << ( ( index >> 3 ) << 3 ) ) ) |
+                                         ( ( fileA | fileH ) & ~( fileA << ( index & 0b00000111 ) ) );
+
+        magic->mask = Magic_slidingAttacks( vectors, index, 0 ) & ~edges;
+        magic->shift = 64 - (unsigned int) __popcnt64( magic->mask );
+        magic->attacks = attacks;
+
+        randomState = randomSeeds[ index >> 3 ];
+
+        // Enumerate every subset of the mask (Carry-Rippler) along with the attacks it produces
+        unsigned int size = 0;
+        unsigned long long subset = 0;
+        do
+        {
+            occupancies[ size ] = subset;
+            references[ size ] = Magic_slidingAttacks( vectors, index, subset );
+            size++;
+
+            subset = ( subset - magic->mask ) & magic->mask;
+        }
+        while ( subset != 0 );
+
+        // Try sparse random numbers until one maps every subset to a slot without a destructive collision
+        bool found = false;
+        while ( !found )
+        {
+            magic->magic = Magic_random() & Magic_random() & Magic_random();
+
+            // Quickly reject numbers that don't spread the mask into the top bits
+            if ( __popcnt64( ( magic->mask * magic->magic ) & 0xff00000000000000ull ) < 6 )
+            {
+                continue;
+            }
+
+            // A new epoch marks every slot as unused without having to clear them
+            epoch++;
+            found = true;
+
+            for ( unsigned int loop = 0; loop < size; loop++ )
+            {
+                const unsigned long long slot = ( occupancies[ loop ] * magic->magic ) >> magic->shift;
+
+                if ( epochs[ slot ] < epoch )
+                {
+                    epochs[ slot ] = epoch;
+                    attacks[ slot ] = references[ loop ];
+                }
+                else if ( attacks[ slot ] != references[ loop ] )
+                {
+                    found = false;
+                    break;
+                }
+            }
+        }
+
+        attacks += size;
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+/// <summary>
+/// Sliding piece attack tables using "fancy" magic bitboards. Each square has a mask of the squares
+/// whose occupancy can affect a slider on it, and a magic multiplier that maps every possible
+/// occupancy of that mask to a unique slot in a precomputed table of attack sets
+/// </summary>
+typedef struct
+{
+    unsigned long long mask;
+    unsigned long long magic;
+    unsigned long long* attacks;
+    unsigned int shift;
+} Magic;
+
+/// <summary>
+/// Build the magic numbers and attack tables. Need only be called once but copes with multiple calls
+/// </summary>
+void Magic_initialize();
+
+/// <summary>
+/// Returns the squares attacked by a bishop on index, given the occupancy of the whole board.
+/// The attack set includes the first blocker in each direction, whatever its color
+/// </summary>
+/// <param name="index">the location of the bishop</param>
+/// <param name="occupancy">all pieces on the board</param>
+unsigned long long Magic_bishopAttacks( unsigned long index, unsigned long long occupancy );
+
+/// <summary>
+/// Returns the squares attacked by a rook on index, given the occupancy of the whole board.
+/// The attack set includes the first blocker in each direction, whatever its color
+/// </summary>
+/// <param name="index">the location of the rook</param>
+/// <param name="occupancy">all pieces on the board</param>
+unsigned long long Magic_rookAttacks( unsigned long index, unsigned long long occupancy );
+
+/// <summary>
+/// Returns the squares attacked by a queen on index, given the occupancy of the whole board
+/// </summary>
+/// <param name="index">the location of the queen</param>
+/// <param name="occupancy">all pieces on the board</param>
+unsigned long long Magic_queenAttacks( unsigned long index, unsigned long long occupancy );
+
+// Internal methods
+
+unsigned long long Magic_slidingAttacks( const short vectors[ 4 ][ 2 ], unsigned long index, unsigned long long occupancy );
+void Magic_initializePiece( Magic* magics, unsigned long long* table, const short vectors[ 4 ][ 2 ] );
@@ -0,0 +1,211 @@
+#include <io.h>
+#include <ctype.h>
+#include <errno.h>
+#include <intrin.h>
+#include <memory.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "MaterialTable.h"
+
+// Piece values for weighing up what is left, indexed by ColorlessPiece
+static const int materialValues[ 7 ] = { 0, 100, 300, 300, 500, 900, 0 };
+
+// A pair of bishops covers both colors, which is worth more than two bishops separately
+#define BISHOP_PAIR_MIDDLEGAME 30
+#define BISHOP_PAIR_ENDGAME 50
+
+// Knights gain and rooks lose a little for each of their own side's pawns above five, as knights like closed
+// positions and rooks open ones
+#define KNIGHT_PAWN_ADJUSTMENT 4
+#define ROOK_PAWN_ADJUSTMENT 8
+#define BALANCED_PAWNS 5
+
+// Without pawns, a small material advantage rarely wins. Scaled to this when the weaker side has at most a minor
+// piece, and this otherwise
+#define NO_PAWNS_SCALE_MINOR 4
+#define NO_PAWNS_SCALE 14
+
+#define SCALE_BITS 0x7f
+#define VALID_BIT ( 1ull << 63 )
+
+void MaterialTable_clear( struct MaterialTable* self )
+{
+    // Zero never matches, as a written entry always has the valid bit set
+    memset( self->entries, 0, sizeof( self->entries ) );
+}
+
+void MaterialTable_probe( struct MaterialTable* self, Board* board, MaterialData* data )
+{
+    const unsigned long long key = board->materialKey;
+    MaterialEntry* entry = &self->entries[ key & ( MATERIAL_TABLE_ENTRIES - 1 ) ];
+
+    // Read each half once - another thread may be writing this entry as we look at it
+    const unsigned long long entryData = entry->data;
+    const unsigned long long entryCheck = entry->check;
+
+    if ( ( entryCheck ^ entryData ) == key && entryData != 0 )
+    {
+        MaterialTable_unpack( entryData, data );
+        return;
+    }
+
+    MaterialTable_evaluate( board, data );
+
+    const unsigned long long packed = MaterialTable_pack( data );
+
+    entry->check = key ^ packed;
+    entry->data = packed;
+}
+
+bool MaterialTable_isDeadDraw( struct MaterialTable* self, Board* board )
+{
+    MaterialData data;
+    MaterialTable_probe( self, board, &data );
+
+    return data.deadDraw;
+}
+
+void MaterialTable_evaluate( Board* board, MaterialData* data )
+{
+    const PieceList* whitePieces = &board->whitePieces;
+    const PieceList* blackPieces = &board->blackPieces;
+
+    int whiteMiddlegame = 0;
+    int whiteEndgame = 0;
+    int blackMiddlegame = 0;
+    int blackEndgame = 0;
+
+    MaterialTable_evaluateSide( whitePieces, blackPieces, &whiteMiddlegame, &whiteEndgame, &data->scale[ 0 ] );
+    MaterialTable_evaluateSide( blackPieces, whitePieces, &blackMiddlegame, &blackEndgame, &data->scale[ 1 ] );
+
+    data->middlegame = whiteMiddlegame - blackMiddlegame;
+    data->endgame = whiteEndgame - blackEndgame;
+
+    // Only one side can have something to win with against a bare king
+    data->endgameType = MaterialTable_endgameType( whitePieces, blackPieces );
+    data->strongWhite = data->endgameType != ENDGAME_NONE;
+
+    if ( data->endgameType == ENDGAME_NONE )
+    {
+        data->endgameType = MaterialTable_endgameType( blackPieces, whitePieces );
+    }
+
+    data->evaluator = Endgame_evaluator( data->endgameType );
+
+    const bool noPawns = ( whitePieces->bbPawn | blackPieces->bbPawn ) == 0;
+    const unsigned long long whiteOthers = whitePieces->bbKnight | whitePieces->bbRook | whitePieces->bbQueen;
+    const unsigned long long blackOthers = blackPieces->bbKnight | blackPieces->bbRook | blackPieces->bbQueen;
+
+    data->oppositeBishops = __popcnt64( whitePieces->bbBishop ) == 1 &&
+                            __popcnt64( blackPieces->bbBishop ) == 1 &&
+                            ( whiteOthers | blackOthers ) == 0;
+
+    // Bare kings, or a single minor piece between them. Anything more, even a knight each, could be helped to mate
+    const unsigned long long pieces = ( whitePieces->bbAll | blackPieces->bbAll ) & ~( whitePieces->bbKing | blackPieces->bbKing );
+    const unsigned long long minors = whitePieces->bbKnight | whitePieces->bbBishop | blackPieces->bbKnight | blackPieces->bbBishop;
+
+    data->deadDraw = noPawns && ( pieces == 0 || ( __popcnt64( pieces ) == 1 && ( pieces & minors ) != 0 ) );
+}
+
+void MaterialTable_evaluateSide( const PieceList* pieces, const PieceList* enemyPieces, int* middlegame, int* endgame, int* scale )
+{
+    const int pawns = (int) __popcnt64( pieces->bbPawn );
+    const int knights = (int) __popcnt64( pieces->bbKnight );
+    const int bishops = (int) __popcnt64( pieces->bbBishop );
+    const int rooks = (int) __popcnt64( pieces->bbRook );
+
+    if ( bishops >= 2 )
+    {
+        *middlegame += BISHOP_PAIR_MIDDLEGAME;
+        *endgame += BISHOP_PAIR_ENDGAME;
+    }
+
+    const int adjustment = ( pawns - BALANCED_PAWNS ) * ( knights * KNIGHT_PAWN_ADJUSTMENT - rooks * ROOK_PAWN_ADJUSTMENT );
+
+    *middlegame += adjustment;
+    *endgame += adjustment;
+
+    *scale = SCALE_NORMAL;
+
+    if ( pawns > 0 )
+    {
+        return;
+    }
+
+    const int material = MaterialTable_nonPawnMaterial( pieces );
+    const int enemyMaterial = MaterialTable_nonPawnMaterial( enemyPieces );
+
+    // With no pawns to make a queen, a side that is not at least a rook up needs more than a minor piece to have
+    // any chance. Two knights can't force mate either
+    if ( material - enemyMaterial <= materialValues[ BISHOP ] )
+    {
+        *scale = material < materialValues[ ROOK ] ? 0 : enemyMaterial <= materialValues[ BISHOP ] ? NO_PAWNS_SCALE_MINOR : NO_PAWNS_SCALE;
+    }
+    else if ( pieces->bbAll == ( pieces->bbKing | pieces->bbKnight ) && knights <= 2 )
+    {
+        *scale = 0;
+    }
+}
+
+enum EndgameType MaterialTable_endgameType( const PieceList* pieces, const PieceList* enemyPieces )
+{
+    // Only against a bare king
+    if ( enemyPieces->bbAll != enemyPieces->bbKing )
+    {
+        return ENDGAME_NONE;
+    }
+
+    const int knights = (int) __popcnt64( pieces->bbKnight );
+    const int bishops = (int) __popcnt64( pieces->bbBishop );
+
+    if ( pieces->bbPawn == 0 && pieces->bbRook == 0 && pieces->bbQueen == 0 && knights == 1 && bishops == 1 )
+    {
+        return ENDGAME_KBNK;
+    }
+
+    // Enough to mate with, leaving out knights alone and a single bishop. Any pawns are not needed
+    if ( pieces->bbRook != 0 || pieces->bbQueen != 0 || bishops >= 2 || ( bishops >= 1 && knights >= 1 ) )
+    {
+        return ENDGAME_KXK;
+    }
+
+    return ENDGAME_NONE;
+}
+
+int MaterialTable_nonPawnMaterial( const PieceList* pieces )
+{
+    return materialValues[ KNIGHT ] * (int) __popcnt64( pieces->bbKnight ) +
+           materialValues[ BISHOP ] * (int) __popcnt64( pieces->bbBishop ) +
+           materialValues[ ROOK ] * (int) __popcnt64( pieces->bbRook ) +
+           materialValues[ QUEEN ] * (int) __popcnt64( pieces->bbQueen );
+}
+
+unsigned long long MaterialTable_pack( const MaterialData* data )
+{
+    return (unsigned long long) (unsigned short) (short) data->middlegame |
+           ( (unsigned long long) (unsigned short) (short) data->endgame << 16 ) |
+           ( (unsigned long long) ( data->endgameType & 0x0f ) << 32 ) |
+           ( (unsigned long long) ( data->strongWhite ? 1 : 0 ) << 36 ) |
+           ( (unsigned long long) ( data->oppositeBishops ? 1 : 0 ) << 37 ) |
+           ( (unsigned long long) ( data->deadDraw ? 1 : 0 ) << 38 ) |
+           ( (unsigned long long) ( data->scale[ 0 ] & SCALE_BITS ) << 40 ) |
+           ( (unsigned long long) ( data->scale[ 1 ] & SCALE_BITS ) << 48 ) |
+           VALID_BIT;
+}
+
+void MaterialTable_unpack( unsigned long long packed, MaterialData* data )
+{
+    data->middlegame = (short) ( packed & 0xffff );
+    data->endgame = (short) ( ( packed >> 16 ) & 0xffff );
+    data->endgameType = (enum EndgameType) ( ( packed >> 32 ) & 0x0f );
+    data->evaluator = Endgame_evaluator( data->endgameType );
+    data->strongWhite = ( ( packed >> 36 ) & 1 ) != 0;
+    data->oppositeBishops = ( ( packed >> 37 ) & 1 ) != 0;
+    data->deadDraw = ( ( packed >> 38 ) & 1 ) != 0;
+    data->scale[ 0 ] = (int) ( ( packed >> 40 ) & SCALE_BITS );
+    data->scale[ 1 ] = (int) ( ( packed >> 48 ) & SCALE_BITS );
+}
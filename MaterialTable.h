@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Board.h"
+#include "Endgame.h"
+
+// There are few enough material balances in a game, or even a search, that the table need not be configurable
+#define MATERIAL_TABLE_ENTRIES 8192
+
+// Scale factors are out of this, which leaves the evaluation as it is
+#define SCALE_NORMAL 64
+
+/// <summary>
+/// One material table entry. The data packs the middlegame imbalance (bits 0-15), the endgame imbalance (16-31),
+/// the EndgameType (32-35), whether white is the strong side in it (36), whether opposite colored bishops are
+/// possible (37), whether the position is a dead draw (38), and the scale factors for white (40-46) and black
+/// (48-54). Bit 63 is always set so that no entry that has been written is zero. As with the transposition table,
+/// entries are shared between threads without locks, so the key is stored XORed with the data
+/// </summary>
+typedef struct
+{
+    unsigned long long check;
+    unsigned long long data;
+} MaterialEntry;
+
+/// <summary>
+/// The unpacked contents of an entry, worked out from the number of each piece alone. Scores are from white's
+/// point of view
+/// </summary>
+typedef struct
+{
+    // Corrections to the sum of the piece values, such as for the bishop pair
+    int middlegame;
+    int endgame;
+
+    // Set for a recognised endgame, which is evaluated by this rather than in the usual way
+    EndgameEvaluator evaluator;
+    enum EndgameType endgameType;
+    bool strongWhite;
+
+    // How much of an advantage counts for, indexed by color with 0 for white, out of SCALE_NORMAL. The side that
+    // is ahead decides which applies. Lower where the material makes a win hard or impossible
+    int scale[ 2 ];
+
+    // Each side has one bishop and nothing else but pawns, so the evaluation should look at the bishops' colors
+    bool oppositeBishops;
+
+    // Neither side can ever mate, whatever is played
+    bool deadDraw;
+} MaterialData;
+
+/// <summary>
+/// Caches what the balance of material says about a position, keyed by Board.materialKey
+/// </summary>
+struct MaterialTable
+{
+    MaterialEntry entries[ MATERIAL_TABLE_ENTRIES ];
+};
+
+// Public methods
+
+void MaterialTable_clear( struct MaterialTable* self );
+
+/// <summary>
+/// Look up the material balance on the board, working it out and storing it if it isn't there
+/// </summary>
+/// <param name="self">the table</param>
+/// <param name="board">the position</param>
+/// <param name="data">set to what the material says</param>
+void MaterialTable_probe( struct MaterialTable* self, Board* board, MaterialData* data );
+
+/// <summary>
+/// Is there too little material left for either side to mate, so that the game is drawn?
+/// </summary>
+/// <param name="self">the table</param>
+/// <param name="board">the position</param>
+bool MaterialTable_isDeadDraw( struct MaterialTable* self, Board* board );
+
+/// <summary>
+/// Work out what the material balance says from scratch, from the number of each piece on the board
+/// </summary>
+/// <param name="board">the position</param>
+/// <param name="data">set to what the material says</param>
+void MaterialTable_evaluate( Board* board, MaterialData* data );
+
+// Internal methods
+
+void MaterialTable_evaluateSide( const PieceList* pieces, const PieceList* enemyPieces, int* middlegame, int* endgame, int* scale );
+enum EndgameType MaterialTable_endgameType( const PieceList* pieces, const PieceList* enemyPieces );
+int MaterialTable_nonPawnMaterial( const PieceList* pieces );
+unsigned long long MaterialTable_pack( const MaterialData* data );
+void MaterialTable_unpack( unsigned long long packed, MaterialData* data );
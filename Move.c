@@ -67,3 +67,32 @@ void MoveList_addMove( MoveList* self, Move move )
 {
     self->moves[ self->count++ ] = move;
 }
+
+// ScoredMoveList
+
+Move ScoredMoveList_selectNext( ScoredMoveList* self, unsigned char index )
+{
+    unsigned char best = index;
+
+    for ( unsigned char loop = index + 1; loop < self->moveList.count; loop++ )
+    {
+        if ( self->scores[ loop ] > self->scores[ best ] )
+        {
+            best = loop;
+        }
+    }
+
+    if ( best != index )
+    {
+        const Move move = self->moveList.moves[ best ];
+        const int score = self->scores[ best ];
+
+        self->moveList.moves[ best ] = self->moveList.moves[ index ];
+        self->scores[ best ] = self->scores[ index ];
+
+        self->moveList.moves[ index ] = move;
+        self->scores[ index ] = score;
+    }
+
+    return self->moveList.moves[ index ];
+}
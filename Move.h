@@ -13,12 +13,26 @@
 /// </summary>
 
 typedef unsigned int Move;
+
+// No legal move can go from a square to itself, so this can never be confused with a real move
+#define NO_MOVE 0
 typedef struct
 {
     Move moves[ 256 ]; 
     unsigned char count;
 } MoveList;
 
+/// <summary>
+/// A move list with a score for each move, kept in a separate array so that the move generators can
+/// fill in the list as they would any other. Moves are handed out best first by selecting the highest
+/// scoring of those remaining each time, which is cheaper than sorting when a cutoff comes early
+/// </summary>
+typedef struct
+{
+    MoveList moveList;
+    int scores[ 256 ];
+} ScoredMoveList;
+
 // Move methods
 
 Move Move_createMove( unsigned long from, unsigned long to );
@@ -37,3 +51,13 @@ bool Move_isPromotion( Move self );
 // MoveList methods
 
 void MoveList_addMove( MoveList* self, Move move );
+
+// ScoredMoveList methods
+
+/// <summary>
+/// Swap the highest scoring move from index onwards into index and return it
+/// </summary>
+/// <param name="self">the list</param>
+/// <param name="index">the first move not yet handed out, which must be less than the count</param>
+/// <returns>the move now at index</returns>
+Move ScoredMoveList_selectNext( ScoredMoveList* self, unsigned char index );
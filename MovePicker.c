@@ -0,0 +1,325 @@
+#include <io.h>
+#include <ctype.h>
+#include <errno.h>
+#include <intrin.h>
+#include <memory.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "MovePicker.h"
+
+// Rough piece values, indexed by ColorlessPiece, for ordering captures. Knights and bishops are
+// treated as equal so that trading one for the other counts as a good capture. A king can only
+// capture something undefended, so whatever it takes is a good capture
+static const int captureValues[ 7 ] = { 0, 100, 300, 300, 500, 900, 0 };
+
+// Evasions that capture are tried before any quiet evasion, whatever its history
+#define EVASION_CAPTURE_BONUS ( HISTORY_MAXIMUM * 2 )
+
+void MovePicker_initialize( MovePicker* self, Board* board, Move hashMove, const Move* killers, Move counterMove, const MoveHistory* history, bool inCheck )
+{
+    self->board = board;
+    self->stage = STAGE_HASH_MOVE;
+    self->inCheck = inCheck;
+    self->hashMove = hashMove;
+    self->killerIndex = 0;
+    self->counterMove = counterMove;
+    self->history = history;
+    self->next = 0;
+    self->badCaptures = 0;
+    self->moveList.moveList.count = 0;
+
+    for ( unsigned short loop = 0; loop < KILLER_MOVES; loop++ )
+    {
+        self->killers[ loop ] = killers[ loop ];
+    }
+}
+
+void MovePicker_initializeQuiescence( MovePicker* self, Board* board, bool inCheck )
+{
+    self->board = board;
+    self->stage = inCheck ? STAGE_GENERATE_EVASIONS : STAGE_GENERATE_QUIESCENCE;
+    self->inCheck = inCheck;
+    self->hashMove = NO_MOVE;
+    self->killerIndex = KILLER_MOVES;
+    self->counterMove = NO_MOVE;
+    self->history = NULL;
+    self->next = 0;
+    self->badCaptures = 0;
+    self->moveList.moveList.count = 0;
+}
+
+Move MovePicker_next( MovePicker* self )
+{
+    Move move;
+
+    while ( true )
+    {
+        switch ( self->stage )
+        {
+            case STAGE_HASH_MOVE:
+                self->stage = self->inCheck ? STAGE_GENERATE_EVASIONS : STAGE_GENERATE_CAPTURES;
+
+                // It may have come from a different position that shares the same hash table entry
+                if ( self->hashMove != NO_MOVE )
+                {
+                    if ( Board_isLegalMove( self->board, self->hashMove ) )
+                    {
+                        return self->hashMove;
+                    }
+
+                    // Forget it, so that later stages don't skip a move that was never handed out
+                    self->hashMove = NO_MOVE;
+                }
+                break;
+
+            case STAGE_GENERATE_CAPTURES:
+                Board_generateCaptures( self->board, &self->moveList.moveList );
+                MovePicker_scoreCaptures( self, 0 );
+                self->stage = STAGE_GOOD_CAPTURES;
+                break;
+
+            case STAGE_GOOD_CAPTURES:
+                while ( self->next < self->moveList.moveList.count )
+                {
+                    move = ScoredMoveList_selectNext( &self->moveList, self->next );
+                    const int score = self->moveList.scores[ self->next++ ];
+
+                    if ( move == self->hashMove )
+                    {
+                        continue;
+                    }
+
+                    // Put aside until after the quiet moves. The slots before next are free to reuse, and
+                    // the bad captures stay in the order they were selected
+                    if ( !MovePicker_isGoodCapture( self, move ) )
+                    {
+                        self->moveList.moveList.moves[ self->badCaptures ] = move;
+                        self->moveList.scores[ self->badCaptures++ ] = score;
+                        continue;
+                    }
+
+                    return move;
+                }
+
+                self->stage = STAGE_KILLERS;
+                break;
+
+            case STAGE_KILLERS:
+                while ( self->killerIndex < KILLER_MOVES )
+                {
+                    move = self->killers[ self->killerIndex++ ];
+
+                    // Killers come from other positions, so need checking. Captures are also left out as
+                    // they will already have been tried
+                    if ( move != NO_MOVE &&
+                         move != self->hashMove &&
+                         Board_isLegalMove( self->board, move ) &&
+                         Board_isQuiet( self->board, move ) )
+                    {
+                        return move;
+                    }
+
+                    // Treat it as not a killer at all, so the quiet stage doesn't skip it
+                    self->killers[ self->killerIndex - 1 ] = NO_MOVE;
+                }
+
+                self->stage = STAGE_COUNTERMOVE;
+                break;
+
+            case STAGE_COUNTERMOVE:
+                self->stage = STAGE_GENERATE_QUIETS;
+
+                // Checked in the same way as the killers, which it may well be one of
+                move = self->counterMove;
+                if ( move != NO_MOVE &&
+                     move != self->hashMove &&
+                     !MovePicker_isKiller( self, move ) &&
+                     Board_isLegalMove( self->board, move ) &&
+                     Board_isQuiet( self->board, move ) )
+                {
+                    return move;
+                }
+
+                self->counterMove = NO_MOVE;
+                break;
+
+            case STAGE_GENERATE_QUIETS:
+                // After the bad captures, which are kept at the front
+                self->moveList.moveList.count = self->badCaptures;
+                self->next = self->badCaptures;
+
+                Board_generateQuiets( self->board, &self->moveList.moveList );
+                MovePicker_scoreQuiets( self, self->badCaptures );
+                self->stage = STAGE_QUIETS;
+                break;
+
+            case STAGE_QUIETS:
+                while ( self->next < self->moveList.moveList.count )
+                {
+                    move = ScoredMoveList_selectNext( &self->moveList, self->next++ );
+
+                    if ( move != self->hashMove && move != self->counterMove && !MovePicker_isKiller( self, move ) )
+                    {
+                        return move;
+                    }
+                }
+
+                self->next = 0;
+                self->stage = STAGE_BAD_CAPTURES;
+                break;
+
+            case STAGE_BAD_CAPTURES:
+                if ( self->next < self->badCaptures )
+                {
+                    return self->moveList.moveList.moves[ self->next++ ];
+                }
+
+                self->stage = STAGE_DONE;
+                break;
+
+            case STAGE_GENERATE_EVASIONS:
+                // Rarely many of these, so all at once with captures of the checker first
+                Board_generateMoves( self->board, &self->moveList.moveList );
+
+                for ( unsigned char loop = 0; loop < self->moveList.moveList.count; loop++ )
+                {
+                    move = self->moveList.moveList.moves[ loop ];
+
+                    if ( Board_isQuiet( self->board, move ) )
+                    {
+                        self->moveList.scores[ loop ] = self->history == NULL ? 0 : self->history->butterfly[ self->board->whiteToMove ? 0 : 1 ][ Move_from( move ) ][ Move_to( move ) ];
+                    }
+                    else
+                    {
+                        self->moveList.scores[ loop ] = EVASION_CAPTURE_BONUS + MovePicker_captureScore( self, move );
+                    }
+                }
+
+                self->stage = STAGE_EVASIONS;
+                break;
+
+            case STAGE_EVASIONS:
+                while ( self->next < self->moveList.moveList.count )
+                {
+                    move = ScoredMoveList_selectNext( &self->moveList, self->next++ );
+
+                    if ( move != self->hashMove )
+                    {
+                        return move;
+                    }
+                }
+
+                self->stage = STAGE_DONE;
+                break;
+
+            case STAGE_GENERATE_QUIESCENCE:
+                Board_generateCaptures( self->board, &self->moveList.moveList );
+                MovePicker_scoreCaptures( self, 0 );
+                self->stage = STAGE_QUIESCENCE;
+                break;
+
+            case STAGE_QUIESCENCE:
+                while ( self->next < self->moveList.moveList.count )
+                {
+                    move = ScoredMoveList_selectNext( &self->moveList, self->next++ );
+
+                    // Captures that lose material are very unlikely to raise the score above standing pat
+                    if ( MovePicker_isGoodCapture( self, move ) )
+                    {
+                        return move;
+                    }
+                }
+
+                self->stage = STAGE_DONE;
+                break;
+
+            case STAGE_DONE:
+            default:
+                return NO_MOVE;
+        }
+    }
+}
+
+void MovePicker_scoreCaptures( MovePicker* self, unsigned char first )
+{
+    for ( unsigned char loop = first; loop < self->moveList.moveList.count; loop++ )
+    {
+        self->moveList.scores[ loop ] = MovePicker_captureScore( self, self->moveList.moveList.moves[ loop ] );
+    }
+}
+
+void MovePicker_scoreQuiets( MovePicker* self, unsigned char first )
+{
+    const int ( *butterfly )[ 64 ] = self->history->butterfly[ self->board->whiteToMove ? 0 : 1 ];
+
+    for ( unsigned char loop = first; loop < self->moveList.moveList.count; loop++ )
+    {
+        const Move move = self->moveList.moveList.moves[ loop ];
+
+        self->moveList.scores[ loop ] = butterfly[ Move_from( move ) ][ Move_to( move ) ];
+    }
+}
+
+int MovePicker_captureScore( MovePicker* self, Move move )
+{
+    // Most valuable victim, least valuable attacker - try taking the biggest pieces first, and with
+    // the smallest pieces where there is a choice. En passant has an empty destination and so sorts
+    // with the promotions, as a pawn capture
+    const unsigned char victim = self->board->squares[ Move_to( move ) ] & COLOR_MASK;
+    const unsigned char attacker = self->board->squares[ Move_from( move ) ] & COLOR_MASK;
+
+    return captureValues[ victim ] * 8 - attacker + ( Move_isPromotion( move ) ? captureValues[ Move_promotion( move ) & COLOR_MASK ] : 0 );
+}
+
+bool MovePicker_isGoodCapture( MovePicker* self, Move move )
+{
+    // Only promotions to a queen are worth trying early
+    if ( Move_isPromotion( move ) && ( Move_promotion( move ) & COLOR_MASK ) != QUEEN )
+    {
+        return false;
+    }
+
+    const unsigned char victim = self->board->squares[ Move_to( move ) ] & COLOR_MASK;
+    const unsigned char attacker = self->board->squares[ Move_from( move ) ] & COLOR_MASK;
+
+    // Taking something at least as valuable can't lose material, whatever happens next. Otherwise play
+    // out the exchange on that square to see. En passant captures land on an empty square but are
+    // pawn for pawn
+    if ( victim == EMPTY || captureValues[ victim ] >= captureValues[ attacker ] )
+    {
+        return true;
+    }
+
+    return Board_staticExchange( self->board, move ) >= 0;
+}
+
+bool MovePicker_isKiller( MovePicker* self, Move move )
+{
+    for ( unsigned short loop = 0; loop < KILLER_MOVES; loop++ )
+    {
+        if ( self->killers[ loop ] == move )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// MoveHistory
+
+void MoveHistory_clear( MoveHistory* self )
+{
+    memset( self, 0, sizeof( MoveHistory ) );
+}
+
+void MoveHistory_update( MoveHistory* self, bool whiteToMove, Move move, int bonus )
+{
+    int* entry = &self->butterfly[ whiteToMove ? 0 : 1 ][ Move_from( move ) ][ Move_to( move ) ];
+
+    *entry += bonus - *entry * abs( bonus ) / HISTORY_MAXIMUM;
+}
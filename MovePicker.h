@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Board.h"
+
+/// <summary>
+/// The order in which a move picker hands out moves. Each generating stage is followed by the stage
+/// that hands out what it generated
+/// </summary>
+enum PickerStage
+{
+    STAGE_HASH_MOVE,
+    STAGE_GENERATE_CAPTURES,
+    STAGE_GOOD_CAPTURES,
+    STAGE_KILLERS,
+    STAGE_COUNTERMOVE,
+    STAGE_GENERATE_QUIETS,
+    STAGE_QUIETS,
+    STAGE_BAD_CAPTURES,
+
+    // When in check, all evasions are generated together after the hash move
+    STAGE_GENERATE_EVASIONS,
+    STAGE_EVASIONS,
+
+    // Quiescence search only wants the captures, and only those that do not lose material
+    STAGE_GENERATE_QUIESCENCE,
+    STAGE_QUIESCENCE,
+
+    STAGE_DONE,
+};
+
+#define KILLER_MOVES 2
+
+// History scores are kept within plus or minus this
+#define HISTORY_MAXIMUM 16384
+
+/// <summary>
+/// What the search has learned about quiet moves in general, as opposed to at one ply, for ordering
+/// the quiet moves that are not hash moves or killers
+/// </summary>
+typedef struct
+{
+    // Butterfly table, indexed [color][from][to], of how often a quiet move has caused a cutoff, less
+    // how often it was tried first only for another move to cut off instead
+    int butterfly[ 2 ][ 64 ][ 64 ];
+
+    // The quiet move that last refuted each move, indexed by the piece moved and the square it moved to
+    Move counterMoves[ 16 ][ 64 ];
+} MoveHistory;
+
+/// <summary>
+/// Hands out the legal moves of a position one at a time, best first by a cheap guess, generating
+/// each group only once those before it have been used up. A node that cuts off on the hash move
+/// never generates anything at all
+/// </summary>
+typedef struct
+{
+    Board* board;
+    enum PickerStage stage;
+    bool inCheck;
+
+    Move hashMove;
+    Move killers[ KILLER_MOVES ];
+    unsigned short killerIndex;
+    Move counterMove;
+
+    // Scores quiet moves. NULL in the quiescence search, which has none
+    const MoveHistory* history;
+
+    // Captures that look like they lose material are moved to the front of the list as they are
+    // passed over, then quiets are generated after them. Once the quiets are used up, the bad
+    // captures are handed out from the front
+    ScoredMoveList moveList;
+    unsigned char next;
+    unsigned char badCaptures;
+} MovePicker;
+
+// Public methods
+
+/// <summary>
+/// Set up a picker for the main search
+/// </summary>
+/// <param name="self">the picker</param>
+/// <param name="board">the position, which must not change while the picker is in use other than to
+/// make and unmake each move it hands out</param>
+/// <param name="hashMove">the move to try first, or NO_MOVE. Need not be legal</param>
+/// <param name="killers">quiet moves that caused cutoffs at this ply elsewhere in the tree. Need not be legal</param>
+/// <param name="counterMove">the quiet move that last refuted the move just played, or NO_MOVE. Need not be legal</param>
+/// <param name="history">for ordering the remaining quiet moves</param>
+/// <param name="inCheck">whether the side to move is in check</param>
+void MovePicker_initialize( MovePicker* self, Board* board, Move hashMove, const Move* killers, Move counterMove, const MoveHistory* history, bool inCheck );
+
+/// <summary>
+/// Set up a picker for the quiescence search, giving captures and queen promotions that do not lose material,
+/// or every evasion when in check
+/// </summary>
+void MovePicker_initializeQuiescence( MovePicker* self, Board* board, bool inCheck );
+
+/// <summary>
+/// Returns the next move, or NO_MOVE when there are no more
+/// </summary>
+Move MovePicker_next( MovePicker* self );
+
+// MoveHistory methods
+
+void MoveHistory_clear( MoveHistory* self );
+
+/// <summary>
+/// Adjust the history score of a quiet move, by less the closer the score already is to the limit in
+/// that direction, so that old results fade as new ones are added
+/// </summary>
+/// <param name="self">the history</param>
+/// <param name="whiteToMove">the side that played the move</param>
+/// <param name="move">the move</param>
+/// <param name="bonus">positive when the move caused a cutoff, negative when it did not</param>
+void MoveHistory_update( MoveHistory* self, bool whiteToMove, Move move, int bonus );
+
+// Internal methods
+
+void MovePicker_scoreCaptures( MovePicker* self, unsigned char first );
+void MovePicker_scoreQuiets( MovePicker* self, unsigned char first );
+int MovePicker_captureScore( MovePicker* self, Move move );
+bool MovePicker_isGoodCapture( MovePicker* self, Move move );
+bool MovePicker_isKiller( MovePicker* self, Move move );
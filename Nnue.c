@@ -0,0 +1,469 @@
+#include <io.h>
+#include <ctype.h>
+#include <errno.h>
+#include <immintrin.h>
+#include <intrin.h>
+#include <memory.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+// Only the file mapping functions are needed
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define NOGDI
+#include <windows.h>
+
+#include "Nnue.h"
+
+// Outputs of each layer are clipped to this before they go into the next, which lets them be held in a byte
+#define CLIPPED_MAXIMUM 127
+
+// The hidden layers' weights are scaled up by this many bits, and the output by this much
+#define WEIGHT_SCALE_BITS 6
+#define OUTPUT_SCALE 16
+
+// The network's output is in units where a pawn in the endgame is worth this much
+#define NETWORK_PAWN_VALUE 208
+#define CENTIPAWNS 100
+
+void Nnue_initialize( struct Nnue* self )
+{
+    self->loaded = false;
+    self->instructions = Nnue_detectInstructions();
+
+    self->file = NULL;
+    self->mapping = NULL;
+    self->view = NULL;
+
+    self->featureBiases = NULL;
+    self->featureWeights = NULL;
+}
+
+void Nnue_destroy( struct Nnue* self )
+{
+    if ( self->view != NULL )
+    {
+        UnmapViewOfFile( self->view );
+    }
+
+    if ( self->mapping != NULL )
+    {
+        CloseHandle( self->mapping );
+    }
+
+    if ( self->file != NULL )
+    {
+        CloseHandle( self->file );
+    }
+
+    self->loaded = false;
+
+    self->file = NULL;
+    self->mapping = NULL;
+    self->view = NULL;
+
+    self->featureBiases = NULL;
+    self->featureWeights = NULL;
+}
+
+bool Nnue_load( struct Nnue* self, const char* path )
+{
+    Nnue_destroy( self );
+
+    HANDLE file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if ( file == INVALID_HANDLE_VALUE )
+    {
+        return false;
+    }
+
+    self->file = file;
+
+    LARGE_INTEGER size;
+    if ( !GetFileSizeEx( file, &size ) || size.QuadPart == 0 )
+    {
+        Nnue_destroy( self );
+        return false;
+    }
+
+    // The pages are only read in from the file as they are first touched, and are shared with any other
+    // process that has the same file open
+    self->mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+    if ( self->mapping == NULL )
+    {
+        Nnue_destroy( self );
+        return false;
+    }
+
+    self->view = MapViewOfFile( self->mapping, FILE_MAP_READ, 0, 0, 0 );
+    if ( self->view == NULL || !Nnue_read( self, size.QuadPart ) )
+    {
+        Nnue_destroy( self );
+        return false;
+    }
+
+    self->loaded = true;
+
+    return true;
+}
+
+int Nnue_evaluate( const struct Nnue* self, Board* board, NnueAccumulator* accumulator )
+{
+    // This is the only place that needs the accumulator, so only moves that lead to an evaluation pay for it
+    for ( int perspective = 0; perspective < 2; perspective++ )
+    {
+        if ( board->refreshNeeded[ perspective ] )
+        {
+            Nnue_refresh( self, board, accumulator, perspective );
+        }
+        else
+        {
+            Nnue_update( self, board, accumulator, perspective );
+        }
+    }
+
+    board->pieceChangeCount = 0;
+    board->refreshNeeded[ 0 ] = false;
+    board->refreshNeeded[ 1 ] = false;
+
+    // The side to move's half comes first
+    const int us = board->whiteToMove ? 0 : 1;
+
+    unsigned char input[ NNUE_HALF_DIMENSIONS * 2 ];
+    Nnue_transform( self, accumulator->values[ us ], input );
+    Nnue_transform( self, accumulator->values[ 1 - us ], input + NNUE_HALF_DIMENSIONS );
+
+    int hidden[ NNUE_HIDDEN_DIMENSIONS ];
+    unsigned char hidden1[ NNUE_HIDDEN_DIMENSIONS ];
+    unsigned char hidden2[ NNUE_HIDDEN_DIMENSIONS ];
+
+    Nnue_affine( self, input, NNUE_HALF_DIMENSIONS * 2, self->hidden1Biases, self->hidden1Weights, NNUE_HIDDEN_DIMENSIONS, hidden );
+    Nnue_clip( hidden, NNUE_HIDDEN_DIMENSIONS, hidden1 );
+
+    Nnue_affine( self, hidden1, NNUE_HIDDEN_DIMENSIONS, self->hidden2Biases, self->hidden2Weights, NNUE_HIDDEN_DIMENSIONS, hidden );
+    Nnue_clip( hidden, NNUE_HIDDEN_DIMENSIONS, hidden2 );
+
+    const int output = self->outputBias + Nnue_dot( self, hidden2, self->outputWeights, NNUE_HIDDEN_DIMENSIONS );
+
+    return output / OUTPUT_SCALE * CENTIPAWNS / NETWORK_PAWN_VALUE;
+}
+
+enum NnueInstructions Nnue_detectInstructions()
+{
+    int info[ 4 ];
+
+    __cpuid( info, 0 );
+    const int highestFunction = info[ 0 ];
+
+    __cpuid( info, 1 );
+    const bool sse41 = ( info[ 2 ] & ( 1 << 19 ) ) != 0;
+    const bool osxsave = ( info[ 2 ] & ( 1 << 27 ) ) != 0;
+    const bool avx = ( info[ 2 ] & ( 1 << 28 ) ) != 0;
+
+    // AVX2 is no use unless the operating system saves the upper halves of the registers on a task switch
+    if ( highestFunction >= 7 && osxsave && avx && ( _xgetbv( 0 ) & 6 ) == 6 )
+    {
+        __cpuidex( info, 7, 0 );
+        if ( ( info[ 1 ] & ( 1 << 5 ) ) != 0 )
+        {
+            return NNUE_AVX2;
+        }
+    }
+
+    return sse41 ? NNUE_SSE41 : NNUE_SCALAR;
+}
+
+bool Nnue_read( struct Nnue* self, unsigned long long size )
+{
+    const unsigned char* position = self->view;
+
+    // Header: version, hash and the length of a description that follows
+    if ( size < 3 * sizeof( unsigned int ) )
+    {
+        return false;
+    }
+
+    const unsigned int version = Nnue_readInt( &position );
+    Nnue_readInt( &position );
+    const unsigned int descriptionLength = Nnue_readInt( &position );
+
+    // Anything but the one shape of network can be turned away by its size alone
+    const unsigned long long expectedSize = 3ull * sizeof( unsigned int ) + descriptionLength +
+                                            sizeof( unsigned int ) +
+                                            NNUE_HALF_DIMENSIONS * sizeof( short ) +
+                                            (unsigned long long) NNUE_FEATURES * NNUE_HALF_DIMENSIONS * sizeof( short ) +
+                                            sizeof( unsigned int ) +
+                                            sizeof( self->hidden1Biases ) + sizeof( self->hidden1Weights ) +
+                                            sizeof( self->hidden2Biases ) + sizeof( self->hidden2Weights ) +
+                                            sizeof( self->outputBias ) + sizeof( self->outputWeights );
+
+    if ( version != NNUE_VERSION || size != expectedSize )
+    {
+        return false;
+    }
+
+    position += descriptionLength;
+
+    // Feature transformer, after its hash
+    Nnue_readInt( &position );
+
+    self->featureBiases = (const short*) position;
+    position += NNUE_HALF_DIMENSIONS * sizeof( short );
+
+    self->featureWeights = (const short*) position;
+    position += (unsigned long long) NNUE_FEATURES * NNUE_HALF_DIMENSIONS * sizeof( short );
+
+    // The rest of the network, after its hash. Each layer's biases come before its weights, which are stored a
+    // row of inputs for each output at a time
+    Nnue_readInt( &position );
+
+    for ( unsigned int loop = 0; loop < NNUE_HIDDEN_DIMENSIONS; loop++ )
+    {
+        self->hidden1Biases[ loop ] = (int) Nnue_readInt( &position );
+    }
+
+    memcpy( self->hidden1Weights, position, sizeof( self->hidden1Weights ) );
+    position += sizeof( self->hidden1Weights );
+
+    for ( unsigned int loop = 0; loop < NNUE_HIDDEN_DIMENSIONS; loop++ )
+    {
+        self->hidden2Biases[ loop ] = (int) Nnue_readInt( &position );
+    }
+
+    memcpy( self->hidden2Weights, position, sizeof( self->hidden2Weights ) );
+    position += sizeof( self->hidden2Weights );
+
+    self->outputBias = (int) Nnue_readInt( &position );
+
+    memcpy( self->outputWeights, position, sizeof( self->outputWeights ) );
+
+    return true;
+}
+
+unsigned int Nnue_readInt( const unsigned char** position )
+{
+    // Little endian, as is everything we run on
+    unsigned int value;
+    memcpy( &value, *position, sizeof( value ) );
+
+    *position += sizeof( value );
+
+    return value;
+}
+
+void Nnue_refresh( const struct Nnue* self, Board* board, NnueAccumulator* accumulator, int perspective )
+{
+    short* values = accumulator->values[ perspective ];
+    const unsigned long king = perspective == 0 ? board->whitePieces.king : board->blackPieces.king;
+
+    memcpy( values, self->featureBiases, NNUE_HALF_DIMENSIONS * sizeof( short ) );
+
+    for ( unsigned long index = 0; index < 64; index++ )
+    {
+        const unsigned char piece = board->squares[ index ];
+
+        if ( piece != EMPTY && !Board_isKing( piece ) )
+        {
+            Nnue_addFeature( self, values, Nnue_featureIndex( perspective, piece, index, king ) );
+        }
+    }
+}
+
+void Nnue_update( const struct Nnue* self, Board* board, NnueAccumulator* accumulator, int perspective )
+{
+    short* values = accumulator->values[ perspective ];
+    const unsigned long king = perspective == 0 ? board->whitePieces.king : board->blackPieces.king;
+
+    // The king is where it was when the accumulator was last brought up to date, or this would be a refresh
+    for ( unsigned char loop = 0; loop < board->pieceChangeCount; loop++ )
+    {
+        const PieceChange* change = &board->pieceChanges[ loop ];
+        const unsigned int feature = Nnue_featureIndex( perspective, change->piece, change->square, king );
+
+        if ( change->added )
+        {
+            Nnue_addFeature( self, values, feature );
+        }
+        else
+        {
+            Nnue_subtractFeature( self, values, feature );
+        }
+    }
+}
+
+unsigned int Nnue_featureIndex( int perspective, unsigned char piece, unsigned long index, unsigned long king )
+{
+    // Black sees the board turned around, so that each side sees its own pieces as white would
+    const unsigned long flip = perspective == 0 ? 0 : 63;
+    const bool friendly = ( ( piece & COLOR_BIT ) == 0 ) == ( perspective == 0 );
+
+    // Feature 0 of each king square is unused, then there are 64 squares for each piece type, friendly first
+    return 1 +
+           ( index ^ flip ) +
+           ( ( piece & COLOR_MASK ) - 1 ) * 128 +
+           ( friendly ? 0 : 64 ) +
+           NNUE_PIECE_SQUARES * ( king ^ flip );
+}
+
+void Nnue_addFeature( const struct Nnue* self, short* values, unsigned int feature )
+{
+    const short* weights = self->featureWeights + (unsigned long long) feature * NNUE_HALF_DIMENSIONS;
+
+    if ( self->instructions == NNUE_AVX2 )
+    {
+        for ( unsigned int loop = 0; loop < NNUE_HALF_DIMENSIONS; loop += 16 )
+        {
+            __m256i* destination = (__m256i*) ( values + loop );
+            _mm256_storeu_si256( destination, _mm256_add_epi16( _mm256_loadu_si256( destination ), _mm256_loadu_si256( (const __m256i*) ( weights + loop ) ) ) );
+        }
+    }
+    else if ( self->instructions == NNUE_SSE41 )
+    {
+        for ( unsigned int loop = 0; loop < NNUE_HALF_DIMENSIONS; loop += 8 )
+        {
+            __m128i* destination = (__m128i*) ( values + loop );
+            _mm_storeu_si128( destination, _mm_add_epi16( _mm_loadu_si128( destination ), _mm_loadu_si128( (const __m128i*) ( weights + loop ) ) ) );
+        }
+    }
+    else
+    {
+        for ( unsigned int loop = 0; loop < NNUE_HALF_DIMENSIONS; loop++ )
+        {
+            values[ loop ] += weights[ loop ];
+        }
+    }
+}
+
+void Nnue_subtractFeature( const struct Nnue* self, short* values, unsigned int feature )
+{
+    const short* weights = self->featureWeights + (unsigned long long) feature * NNUE_HALF_DIMENSIONS;
+
+    if ( self->instructions == NNUE_AVX2 )
+    {
+        for ( unsigned int loop = 0; loop < NNUE_HALF_DIMENSIONS; loop += 16 )
+        {
+            __m256i* destination = (__m256i*) ( values + loop );
+            _mm256_storeu_si256( destination, _mm256_sub_epi16( _mm256_loadu_si256( destination ), _mm256_loadu_si256( (const __m256i*) ( weights + loop ) ) ) );
+        }
+    }
+    else if ( self->instructions == NNUE_SSE41 )
+    {
+        for ( unsigned int loop = 0; loop < NNUE_HALF_DIMENSIONS; loop += 8 )
+        {
+            __m128i* destination = (__m128i*) ( values + loop );
+            _mm_storeu_si128( destination, _mm_sub_epi16( _mm_loadu_si128( destination ), _mm_loadu_si128( (const __m128i*) ( weights + loop ) ) ) );
+        }
+    }
+    else
+    {
+        for ( unsigned int loop = 0; loop < NNUE_HALF_DIMENSIONS; loop++ )
+        {
+            values[ loop ] -= weights[ loop ];
+        }
+    }
+}
+
+void Nnue_transform( const struct Nnue* self, const short* values, unsigned char* output )
+{
+    // Packing saturates at the top of the range, leaving only the negative values to be brought up to zero
+    if ( self->instructions == NNUE_AVX2 )
+    {
+        const __m256i zero = _mm256_setzero_si256();
+
+        for ( unsigned int loop = 0; loop < NNUE_HALF_DIMENSIONS; loop += 32 )
+        {
+            const __m256i first = _mm256_loadu_si256( (const __m256i*) ( values + loop ) );
+            const __m256i second = _mm256_loadu_si256( (const __m256i*) ( values + loop + 16 ) );
+
+            // Packing works within each 128 bit lane, so the 64 bit quarters need putting back in order
+            const __m256i packed = _mm256_max_epi8( _mm256_packs_epi16( first, second ), zero );
+            _mm256_storeu_si256( (__m256i*) ( output + loop ), _mm256_permute4x64_epi64( packed, 0xd8 ) );
+        }
+    }
+    else if ( self->instructions == NNUE_SSE41 )
+    {
+        const __m128i zero = _mm_setzero_si128();
+
+        for ( unsigned int loop = 0; loop < NNUE_HALF_DIMENSIONS; loop += 16 )
+        {
+            const __m128i first = _mm_loadu_si128( (const __m128i*) ( values + loop ) );
+            const __m128i second = _mm_loadu_si128( (const __m128i*) ( values + loop + 8 ) );
+
+            _mm_storeu_si128( (__m128i*) ( output + loop ), _mm_max_epi8( _mm_packs_epi16( first, second ), zero ) );
+        }
+    }
+    else
+    {
+        for ( unsigned int loop = 0; loop < NNUE_HALF_DIMENSIONS; loop++ )
+        {
+            const short value = values[ loop ];
+            output[ loop ] = (unsigned char) ( value < 0 ? 0 : value > CLIPPED_MAXIMUM ? CLIPPED_MAXIMUM : value );
+        }
+    }
+}
+
+void Nnue_affine( const struct Nnue* self, const unsigned char* input, unsigned int inputCount, const int* biases, const signed char* weights, unsigned int outputCount, int* output )
+{
+    for ( unsigned int loop = 0; loop < outputCount; loop++ )
+    {
+        output[ loop ] = biases[ loop ] + Nnue_dot( self, input, weights + loop * inputCount, inputCount );
+    }
+}
+
+int Nnue_dot( const struct Nnue* self, const unsigned char* input, const signed char* weights, unsigned int count )
+{
+    // Inputs are at most CLIPPED_MAXIMUM, so the pairs of products added together to 16 bits can't saturate,
+    // and the kernels give exactly the same answer as the plain loop. Counts are all multiples of 32
+    if ( self->instructions == NNUE_AVX2 )
+    {
+        const __m256i ones = _mm256_set1_epi16( 1 );
+        __m256i sum = _mm256_setzero_si256();
+
+        for ( unsigned int loop = 0; loop < count; loop += 32 )
+        {
+            const __m256i products = _mm256_maddubs_epi16( _mm256_loadu_si256( (const __m256i*) ( input + loop ) ), _mm256_loadu_si256( (const __m256i*) ( weights + loop ) ) );
+            sum = _mm256_add_epi32( sum, _mm256_madd_epi16( products, ones ) );
+        }
+
+        __m128i total = _mm_add_epi32( _mm256_castsi256_si128( sum ), _mm256_extracti128_si256( sum, 1 ) );
+        total = _mm_add_epi32( total, _mm_shuffle_epi32( total, 0x4e ) );
+        total = _mm_add_epi32( total, _mm_shuffle_epi32( total, 0xb1 ) );
+
+        return _mm_cvtsi128_si32( total );
+    }
+    else if ( self->instructions == NNUE_SSE41 )
+    {
+        const __m128i ones = _mm_set1_epi16( 1 );
+        __m128i sum = _mm_setzero_si128();
+
+        for ( unsigned int loop = 0; loop < count; loop += 16 )
+        {
+            const __m128i products = _mm_maddubs_epi16( _mm_loadu_si128( (const __m128i*) ( input + loop ) ), _mm_loadu_si128( (const __m128i*) ( weights + loop ) ) );
+            sum = _mm_add_epi32( sum, _mm_madd_epi16( products, ones ) );
+        }
+
+        sum = _mm_add_epi32( sum, _mm_shuffle_epi32( sum, 0x4e ) );
+        sum = _mm_add_epi32( sum, _mm_shuffle_epi32( sum, 0xb1 ) );
+
+        return _mm_cvtsi128_si32( sum );
+    }
+
+    int sum = 0;
+    for ( unsigned int loop = 0; loop < count; loop++ )
+    {
+        sum += input[ loop ] * weights[ loop ];
+    }
+
+    return sum;
+}
+
+void Nnue_clip( const int* input, unsigned int count, unsigned char* output )
+{
+    for ( unsigned int loop = 0; loop < count; loop++ )
+    {
+        const int value = input[ loop ] >> WEIGHT_SCALE_BITS;
+        output[ loop ] = (unsigned char) ( value < 0 ? 0 : value > CLIPPED_MAXIMUM ? CLIPPED_MAXIMUM : value );
+    }
+}
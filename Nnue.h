@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Board.h"
+
+// The network is the common HalfKP 256x2-32-32-1 shape. Each side's half of the first layer, the feature
+// transformer, has a feature for every piece other than a king on every square, for every square its own king
+// can be on. Its outputs for both sides feed two small layers and then the single output
+#define NNUE_KING_SQUARES 64
+#define NNUE_PIECE_SQUARES 641
+#define NNUE_FEATURES ( NNUE_KING_SQUARES * NNUE_PIECE_SQUARES )
+#define NNUE_HALF_DIMENSIONS 256
+#define NNUE_HIDDEN_DIMENSIONS 32
+
+// Identifies the format of the file, which is followed by the hashes of the network's parts
+#define NNUE_VERSION 0x7AF32F16
+
+/// <summary>
+/// The instruction sets that the network has kernels for, best last
+/// </summary>
+enum NnueInstructions
+{
+    NNUE_SCALAR = 0,
+    NNUE_SSE41,
+    NNUE_AVX2,
+};
+
+/// <summary>
+/// A network loaded from a file. The feature transformer's weights, which are nearly all of the file, are used in
+/// place in a read only view of it, so loading costs little more than opening the file. The other layers are small
+/// enough to copy out
+/// </summary>
+struct Nnue
+{
+    bool loaded;
+    enum NnueInstructions instructions;
+
+    // Handles of the file and its mapping, and the view of it
+    void* file;
+    void* mapping;
+    const unsigned char* view;
+
+    // Point into the view
+    const short* featureBiases;
+    const short* featureWeights;
+
+    int hidden1Biases[ NNUE_HIDDEN_DIMENSIONS ];
+    signed char hidden1Weights[ NNUE_HIDDEN_DIMENSIONS * NNUE_HALF_DIMENSIONS * 2 ];
+    int hidden2Biases[ NNUE_HIDDEN_DIMENSIONS ];
+    signed char hidden2Weights[ NNUE_HIDDEN_DIMENSIONS * NNUE_HIDDEN_DIMENSIONS ];
+    int outputBias;
+    signed char outputWeights[ NNUE_HIDDEN_DIMENSIONS ];
+};
+
+/// <summary>
+/// The feature transformer's output for the board as it was when last evaluated, for each side, indexed with 0
+/// for white. Changes to the board since then are applied from the board's record of them when next needed, so
+/// a search thread keeps one of these alongside its board
+/// </summary>
+typedef struct
+{
+    short values[ 2 ][ NNUE_HALF_DIMENSIONS ];
+} NnueAccumulator;
+
+// Public methods
+
+void Nnue_initialize( struct Nnue* self );
+void Nnue_destroy( struct Nnue* self );
+
+/// <summary>
+/// Load a network from a file, replacing any already loaded
+/// </summary>
+/// <param name="self">the network</param>
+/// <param name="path">the file</param>
+/// <returns>false if the file could not be opened or is not a network of the right shape, in which case no
+/// network is loaded</returns>
+bool Nnue_load( struct Nnue* self, const char* path );
+
+/// <summary>
+/// Returns the network's evaluation of the position, in centipawns from the point of view of the side to move.
+/// Brings the accumulator up to date with the board first, and clears the board's record of changes
+/// </summary>
+/// <param name="self">a loaded network</param>
+/// <param name="board">the position</param>
+/// <param name="accumulator">the accumulator for the board</param>
+int Nnue_evaluate( const struct Nnue* self, Board* board, NnueAccumulator* accumulator );
+
+// Internal methods
+
+enum NnueInstructions Nnue_detectInstructions();
+bool Nnue_read( struct Nnue* self, unsigned long long size );
+unsigned int Nnue_readInt( const unsigned char** position );
+void Nnue_refresh( const struct Nnue* self, Board* board, NnueAccumulator* accumulator, int perspective );
+void Nnue_update( const struct Nnue* self, Board* board, NnueAccumulator* accumulator, int perspective );
+unsigned int Nnue_featureIndex( int perspective, unsigned char piece, unsigned long index, unsigned long king );
+void Nnue_addFeature( const struct Nnue* self, short* values, unsigned int feature );
+void Nnue_subtractFeature( const struct Nnue* self, short* values, unsigned int feature );
+void Nnue_transform( const struct Nnue* self, const short* values, unsigned char* output );
+void Nnue_affine( const struct Nnue* self, const unsigned char* input, unsigned int inputCount, const int* biases, const signed char* weights, unsigned int outputCount, int* output );
+int Nnue_dot( const struct Nnue* self, const unsigned char* input, const signed char* weights, unsigned int count );
+void Nnue_clip( const int* input, unsigned int count, unsigned char* output );
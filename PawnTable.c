@@ -0,0 +1,241 @@
+#include <io.h>
+#include <ctype.h>
+#include <errno.h>
+#include <intrin.h>
+#include <malloc.h>
+#include <memory.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "PawnTable.h"
+
+// Entries are aligned to cache lines so that a probe touches exactly one line
+#define CACHE_LINE_SIZE 64
+
+#define FILE_A 0x0101010101010101ull
+#define FILE_H 0x8080808080808080ull
+
+// Bonuses for a passed pawn, indexed by its rank counted from its own side's first rank
+static const int passedMiddlegame[ 8 ] = { 0, 0, 5, 10, 20, 35, 60, 0 };
+static const int passedEndgame[ 8 ] = { 0, 10, 15, 25, 45, 75, 120, 0 };
+
+// Penalties for each weak pawn
+#define DOUBLED_MIDDLEGAME 10
+#define DOUBLED_ENDGAME 25
+#define ISOLATED_MIDDLEGAME 10
+#define ISOLATED_ENDGAME 15
+#define BACKWARD_MIDDLEGAME 8
+#define BACKWARD_ENDGAME 10
+
+// Bonuses for each pawn in front of the king, one rank ahead of the king's first rank or two
+#define SHIELD_NEAR 15
+#define SHIELD_FAR 8
+
+void PawnTable_initialize( struct PawnTable* self )
+{
+    self->entries = NULL;
+    self->entryMask = 0;
+}
+
+void PawnTable_destroy( struct PawnTable* self )
+{
+    _aligned_free( self->entries );
+
+    self->entries = NULL;
+    self->entryMask = 0;
+}
+
+bool PawnTable_resize( struct PawnTable* self, unsigned long long megabytes )
+{
+    // Largest power of two number of entries that fits, so that a mask can be used in place of modulo
+    unsigned long long entries = 1;
+    while ( entries * 2 * sizeof( PawnEntry ) <= megabytes * 1024 * 1024 )
+    {
+        entries *= 2;
+    }
+
+    // Keep the old table until the new one has been allocated, so evaluation always has one to use
+    PawnEntry* allocated = _aligned_malloc( entries * sizeof( PawnEntry ), CACHE_LINE_SIZE );
+    if ( allocated == NULL )
+    {
+        return false;
+    }
+
+    PawnTable_destroy( self );
+
+    self->entries = allocated;
+    self->entryMask = entries - 1;
+
+    PawnTable_clear( self );
+
+    return true;
+}
+
+void PawnTable_clear( struct PawnTable* self )
+{
+    // A zeroed entry matches only the key of a position with no pawns, for which it is also the right answer
+    if ( self->entries != NULL )
+    {
+        memset( self->entries, 0, ( self->entryMask + 1 ) * sizeof( PawnEntry ) );
+    }
+}
+
+void PawnTable_probe( struct PawnTable* self, Board* board, PawnData* data )
+{
+    const unsigned long long key = board->pawnKey;
+    PawnEntry* entry = &self->entries[ key & self->entryMask ];
+
+    // Read each word once - another thread may be writing this entry as we look at it
+    PawnEntry copy;
+    copy.scores = entry->scores;
+    copy.shields[ 0 ] = entry->shields[ 0 ];
+    copy.shields[ 1 ] = entry->shields[ 1 ];
+    copy.check = entry->check;
+
+    if ( ( copy.check ^ copy.scores ^ copy.shields[ 0 ] ^ copy.shields[ 1 ] ) == key )
+    {
+        PawnTable_unpack( &copy, data );
+        return;
+    }
+
+    PawnTable_evaluate( board, data );
+    PawnTable_pack( data, &copy );
+
+    entry->scores = copy.scores;
+    entry->shields[ 0 ] = copy.shields[ 0 ];
+    entry->shields[ 1 ] = copy.shields[ 1 ];
+    entry->check = key ^ copy.scores ^ copy.shields[ 0 ] ^ copy.shields[ 1 ];
+}
+
+void PawnTable_evaluate( Board* board, PawnData* data )
+{
+    const unsigned long long whitePawns = board->whitePieces.bbPawn;
+    const unsigned long long blackPawns = board->blackPieces.bbPawn;
+
+    int whiteMiddlegame = 0;
+    int whiteEndgame = 0;
+    int blackMiddlegame = 0;
+    int blackEndgame = 0;
+
+    PawnTable_evaluateSide( whitePawns, blackPawns, true, &whiteMiddlegame, &whiteEndgame );
+    PawnTable_evaluateSide( blackPawns, whitePawns, false, &blackMiddlegame, &blackEndgame );
+
+    data->middlegame = whiteMiddlegame - blackMiddlegame;
+    data->endgame = whiteEndgame - blackEndgame;
+
+    // The two ranks in front of a king on its first rank, which also serve a king that has stepped up one
+    const unsigned long long whiteNear = whitePawns & 0x000000000000ff00ull;
+    const unsigned long long whiteFar = whitePawns & 0x0000000000ff0000ull;
+    const unsigned long long blackNear = blackPawns & 0x00ff000000000000ull;
+    const unsigned long long blackFar = blackPawns & 0x0000ff0000000000ull;
+
+    for ( int file = 0; file < 8; file++ )
+    {
+        // The king's file and those either side
+        unsigned long long files = FILE_A << file;
+        files |= ( ( files & ~FILE_A ) >> 1 ) | ( ( files & ~FILE_H ) << 1 );
+
+        data->shields[ 0 ][ file ] = SHIELD_NEAR * (int) __popcnt64( whiteNear & files ) + SHIELD_FAR * (int) __popcnt64( whiteFar & files );
+        data->shields[ 1 ][ file ] = SHIELD_NEAR * (int) __popcnt64( blackNear & files ) + SHIELD_FAR * (int) __popcnt64( blackFar & files );
+    }
+}
+
+void PawnTable_evaluateSide( unsigned long long pawns, unsigned long long enemyPawns, bool white, int* middlegame, int* endgame )
+{
+    // Everything is worked out a whole set of pawns at a time, by shifting and filling bitboards. "Ahead" is
+    // the direction these pawns move in
+    unsigned long long ahead = white ? pawns << 8 : pawns >> 8;
+    ahead |= white ? ahead << 8 : ahead >> 8;
+    ahead |= white ? ahead << 16 : ahead >> 16;
+    ahead |= white ? ahead << 32 : ahead >> 32;
+
+    unsigned long long behind = white ? pawns >> 8 : pawns << 8;
+    behind |= white ? behind >> 8 : behind << 8;
+    behind |= white ? behind >> 16 : behind << 16;
+    behind |= white ? behind >> 32 : behind << 32;
+
+    // The squares in front of the enemy pawns, from their side, and the squares they will be able to attack on the way
+    unsigned long long enemyAhead = white ? enemyPawns >> 8 : enemyPawns << 8;
+    enemyAhead |= white ? enemyAhead >> 8 : enemyAhead << 8;
+    enemyAhead |= white ? enemyAhead >> 16 : enemyAhead << 16;
+    enemyAhead |= white ? enemyAhead >> 32 : enemyAhead << 32;
+
+    const unsigned long long enemyControl = enemyAhead | ( ( enemyAhead & ~FILE_A ) >> 1 ) | ( ( enemyAhead & ~FILE_H ) << 1 );
+
+    // A pawn with another of ours behind it on the same file is doubled. Only the extra pawns count
+    const unsigned long long doubled = pawns & ahead;
+
+    // With no pawn of ours on either neighbouring file, nothing can ever defend a pawn
+    const unsigned long long files = pawns | ahead | behind;
+    const unsigned long long isolated = pawns & ~( ( ( files & ~FILE_A ) >> 1 ) | ( ( files & ~FILE_H ) << 1 ) );
+
+    // Nothing of the enemy's in front of it or able to take it on its way, and not stuck behind one of our own
+    const unsigned long long passed = pawns & ~enemyControl & ~behind;
+
+    // A pawn that can't advance without being taken by an enemy pawn, and that none of ours can come up to support,
+    // as those on the neighbouring files are already further up the board
+    const unsigned long long attacks = white ? ( ( pawns & ~FILE_A ) << 7 ) | ( ( pawns & ~FILE_H ) << 9 )
+                                             : ( ( pawns & ~FILE_A ) >> 9 ) | ( ( pawns & ~FILE_H ) >> 7 );
+    unsigned long long attackSpan = attacks;
+    attackSpan |= white ? attackSpan << 8 : attackSpan >> 8;
+    attackSpan |= white ? attackSpan << 16 : attackSpan >> 16;
+    attackSpan |= white ? attackSpan << 32 : attackSpan >> 32;
+
+    const unsigned long long enemyAttacks = white ? ( ( enemyPawns & ~FILE_A ) >> 9 ) | ( ( enemyPawns & ~FILE_H ) >> 7 )
+                                                  : ( ( enemyPawns & ~FILE_A ) << 7 ) | ( ( enemyPawns & ~FILE_H ) << 9 );
+    const unsigned long long stops = white ? pawns << 8 : pawns >> 8;
+    const unsigned long long weakStops = stops & enemyAttacks & ~attackSpan;
+    const unsigned long long backward = ( white ? weakStops >> 8 : weakStops << 8 ) & ~isolated;
+
+    *middlegame -= DOUBLED_MIDDLEGAME * (int) __popcnt64( doubled ) +
+                   ISOLATED_MIDDLEGAME * (int) __popcnt64( isolated ) +
+                   BACKWARD_MIDDLEGAME * (int) __popcnt64( backward );
+    *endgame -= DOUBLED_ENDGAME * (int) __popcnt64( doubled ) +
+                ISOLATED_ENDGAME * (int) __popcnt64( isolated ) +
+                BACKWARD_ENDGAME * (int) __popcnt64( backward );
+
+    unsigned long long remaining = passed;
+    unsigned long index;
+    while ( _BitScanForward64( &index, remaining ) )
+    {
+        remaining ^= 1ull << index;
+
+        const unsigned long rank = white ? Board_rankFromIndex( index ) : 7 - Board_rankFromIndex( index );
+
+        *middlegame += passedMiddlegame[ rank ];
+        *endgame += passedEndgame[ rank ];
+    }
+}
+
+void PawnTable_pack( const PawnData* data, PawnEntry* entry )
+{
+    entry->scores = (unsigned long long) (unsigned short) (short) data->middlegame |
+                    ( (unsigned long long) (unsigned short) (short) data->endgame << 16 );
+
+    for ( int color = 0; color < 2; color++ )
+    {
+        entry->shields[ color ] = 0;
+
+        for ( int file = 0; file < 8; file++ )
+        {
+            entry->shields[ color ] |= (unsigned long long) ( data->shields[ color ][ file ] & 0xff ) << ( file * 8 );
+        }
+    }
+}
+
+void PawnTable_unpack( const PawnEntry* entry, PawnData* data )
+{
+    data->middlegame = (short) ( entry->scores & 0xffff );
+    data->endgame = (short) ( ( entry->scores >> 16 ) & 0xffff );
+
+    for ( int color = 0; color < 2; color++ )
+    {
+        for ( int file = 0; file < 8; file++ )
+        {
+            data->shields[ color ][ file ] = (int) ( ( entry->shields[ color ] >> ( file * 8 ) ) & 0xff );
+        }
+    }
+}
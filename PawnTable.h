@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Board.h"
+
+// Size limits for the PawnHash option, in megabytes
+#define PAWN_DEFAULT_MEGABYTES 2
+#define PAWN_MINIMUM_MEGABYTES 1
+#define PAWN_MAXIMUM_MEGABYTES 1024
+
+/// <summary>
+/// One pawn table entry, 32 bytes so that two fit a 64 byte cache line. The scores word packs the middlegame
+/// score (bits 0-15) and the endgame score (16-31), and each shields word holds one byte per file for one side.
+/// As with the transposition table, entries are shared between threads without locks, so the key is stored
+/// XORed with everything else. A read that catches another thread part way through a write then fails to match
+/// </summary>
+typedef struct
+{
+    unsigned long long check;
+    unsigned long long scores;
+    unsigned long long shields[ 2 ];
+} PawnEntry;
+
+/// <summary>
+/// The unpacked contents of an entry. Scores are from white's point of view
+/// </summary>
+typedef struct
+{
+    int middlegame;
+    int endgame;
+
+    // The middlegame bonus for the pawns in front of a king on its first or second rank, indexed by color, with
+    // 0 for white, and by the file the king is on
+    int shields[ 2 ][ 8 ];
+} PawnData;
+
+/// <summary>
+/// Caches the evaluation of pawn structures, keyed by Board.pawnKey. The pawns change far less often than the
+/// rest of the position, so almost every lookup finds what it wants
+/// </summary>
+struct PawnTable
+{
+    PawnEntry* entries;
+    unsigned long long entryMask;
+};
+
+// Public methods
+
+void PawnTable_initialize( struct PawnTable* self );
+void PawnTable_destroy( struct PawnTable* self );
+
+/// <summary>
+/// Replace the table with an empty one of about the given size, rounded down to a power of two number of entries.
+/// Only pawn structure scores are lost in a resize, and they are rebuilt as positions are evaluated again
+/// </summary>
+/// <param name="self">the table</param>
+/// <param name="megabytes">the size</param>
+/// <returns>false if the memory could not be allocated, in which case the old entries and size are left as they were</returns>
+bool PawnTable_resize( struct PawnTable* self, unsigned long long megabytes );
+
+void PawnTable_clear( struct PawnTable* self );
+
+/// <summary>
+/// Look up the evaluation of the pawns on the board, working it out and storing it if it isn't there
+/// </summary>
+/// <param name="self">the table</param>
+/// <param name="board">the position</param>
+/// <param name="data">set to the evaluation</param>
+void PawnTable_probe( struct PawnTable* self, Board* board, PawnData* data );
+
+/// <summary>
+/// Work out the evaluation of the pawns from scratch: passed, isolated, doubled and backward pawns, and the
+/// shelter they give each king
+/// </summary>
+/// <param name="board">the position</param>
+/// <param name="data">set to the evaluation</param>
+void PawnTable_evaluate( Board* board, PawnData* data );
+
+// Internal methods
+
+void PawnTable_evaluateSide( unsigned long long pawns, unsigned long long enemyPawns, bool white, int* middlegame, int* endgame );
+void PawnTable_pack( const PawnData* data, PawnEntry* entry );
+void PawnTable_unpack( const PawnEntry* entry, PawnData* data );
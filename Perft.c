@@ -4,10 +4,12 @@
 #include <intrin.h>
 #include <memory.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <threads.h>
 #include <time.h>
 
 #include "Perft.h"
@@ -20,28 +22,83 @@
 #define LOG_WARN( ... ) { RuntimeSetup_log( runtimeSetup, WARN, __VA_ARGS__ ); }
 #define LOG_ERROR( ... ) { RuntimeSetup_log( runtimeSetup, ERROR, __VA_ARGS__ ); }
 
-unsigned long long Perft_depth( struct RuntimeSetup* runtimeSetup, int depth, const char* fen, bool divide )
+void PerftOptions_initialize( struct PerftOptions* options )
+{
+    options->threads = 1;
+    options->splitDepth = 1;
+    options->hashTable = NULL;
+    options->hashMask = 0;
+    options->stop = NULL;
+}
+
+void PerftOptions_destroy( struct PerftOptions* options )
+{
+    free( options->hashTable );
+
+    options->hashTable = NULL;
+    options->hashMask = 0;
+}
+
+bool PerftOptions_setHashSize( struct PerftOptions* options, unsigned long long megabytes )
+{
+    PerftOptions_destroy( options );
+
+    if ( megabytes == 0 )
+    {
+        return true;
+    }
+
+    const unsigned long long bucketSize = PERFT_HASH_BUCKET_SIZE * sizeof( PerftHashEntry );
+
+    // Largest power of two number of buckets that fits, so that a mask can be used in place of modulo
+    unsigned long long buckets = 1;
+    while ( buckets * 2 * bucketSize <= megabytes * 1024 * 1024 )
+    {
+        buckets *= 2;
+    }
+
+    // Zeroed memory reads back as no entry at all, as a zero check and data would need a zero key
+    // that also matched depth 0, which is never stored
+    options->hashTable = calloc( buckets, bucketSize );
+    if ( options->hashTable == NULL )
+    {
+        return false;
+    }
+
+    options->hashMask = buckets - 1;
+
+    return true;
+}
+
+unsigned long long Perft_depth( struct RuntimeSetup* runtimeSetup, struct PerftOptions* options, int depth, const char* fen, bool divide )
 {
     LOG_DEBUG( "perft with depth %d and FEN: %s", depth, fen );
 
     Board board;
     Board_create( &board, fen );
     
-    clock_t start = clock();
+    // Wall clock, not processor time, as this may be spread over several threads
+    unsigned long long start = wallClockMilliseconds();
+
+    unsigned long long count = Perft_run( runtimeSetup, options, &board, depth, divide );
 
-    unsigned long long count = Perft_run( runtimeSetup, &board, depth, divide );
+    unsigned long long end = wallClockMilliseconds();
 
-    clock_t end = clock();
+    if ( Perft_isStopped( options ) )
+    {
+        LOG_INFO( "Perft stopped" );
+        return 0;
+    }
 
-    float totalTime = (float) ( end - start ) / CLOCKS_PER_SEC;
-    float nps = count / totalTime;
+    float totalTime = (float) ( end - start ) / 1000;
+    float nps = totalTime > 0 ? count / totalTime : 0;
 
     LOG_INFO( "Move count: %llu in %0.3fs (%0.0f nps)", count, totalTime, nps );
 
     return count;
 }
 
-void Perft_fen( struct RuntimeSetup* runtimeSetup, char* fenWithResults )
+void Perft_fen( struct RuntimeSetup* runtimeSetup, struct PerftOptions* options, char* fenWithResults )
 {
     LOG_DEBUG( "perft with FEN: %s", fenWithResults );
 
@@ -61,6 +118,12 @@ void Perft_fen( struct RuntimeSetup* runtimeSetup, char* fenWithResults )
 
         while ( separator != NULL && *separator != '\0' )
         {
+            // Allow for "; D1 20" as well as ";D1 20"
+            while ( *separator == ' ' )
+            {
+                separator++;
+            }
+
             if ( *separator++ != 'D' )
             {
                 LOG_ERROR( "Malformed expected result with: %s", fenWithResults );
@@ -78,8 +141,13 @@ void Perft_fen( struct RuntimeSetup* runtimeSetup, char* fenWithResults )
 
             unsigned long long expectedResult = atoll( ++separator );
 
-            if ( Perft_depth( runtimeSetup, depth, fenWithResults, false ) != expectedResult )
+            if ( Perft_depth( runtimeSetup, options, depth, fenWithResults, false ) != expectedResult )
             {
+                if ( Perft_isStopped( options ) )
+                {
+                    return;
+                }
+
                 LOG_ERROR( "Failed: expected result was %llu", expectedResult );
             }
             else
@@ -87,7 +155,12 @@ void Perft_fen( struct RuntimeSetup* runtimeSetup, char* fenWithResults )
                 LOG_INFO( "Success" );
             }
 
-            separator = strchr( fenWithResults, ';' );
+            // Move on to the next expected result, if there is one
+            separator = strchr( separator, ';' );
+            if ( separator != NULL )
+            {
+                separator++;
+            }
         }
 
         // Drop out here as we're done and it simplifies the code below
@@ -107,8 +180,13 @@ void Perft_fen( struct RuntimeSetup* runtimeSetup, char* fenWithResults )
         *separator++ = '\0';
 
         unsigned long long expectedResult = atoll( separator );
-        if ( Perft_depth( runtimeSetup, depth, fenWithResults, false ) != expectedResult )
+        if ( Perft_depth( runtimeSetup, options, depth, fenWithResults, false ) != expectedResult )
         {
+            if ( Perft_isStopped( options ) )
+            {
+                return;
+            }
+
             LOG_ERROR( "Failed: expected result was %llu", expectedResult );
         }
         else
@@ -127,7 +205,7 @@ void Perft_fen( struct RuntimeSetup* runtimeSetup, char* fenWithResults )
     //   else print count
 }
 
-void Perft_file( struct RuntimeSetup* runtimeSetup, const char* filename )
+void Perft_file( struct RuntimeSetup* runtimeSetup, struct PerftOptions* options, const char* filename )
 {
     LOG_DEBUG( "perft with file: %s", filename );
 
@@ -137,7 +215,7 @@ void Perft_file( struct RuntimeSetup* runtimeSetup, const char* filename )
     {
         char buffer[ BUFFER_SIZE ];
         memset( buffer, 0, BUFFER_SIZE );
-        while ( fgets( buffer, BUFFER_SIZE, file ) )
+        while ( !Perft_isStopped( options ) && fgets( buffer, BUFFER_SIZE, file ) )
         {
             sanitize( buffer );
 
@@ -147,7 +225,7 @@ void Perft_file( struct RuntimeSetup* runtimeSetup, const char* filename )
                 continue;
             }
 
-            Perft_fen( runtimeSetup, buffer );
+            Perft_fen( runtimeSetup, options, buffer );
         }
 
         fclose( file );
@@ -158,12 +236,18 @@ void Perft_file( struct RuntimeSetup* runtimeSetup, const char* filename )
     }
 }
 
-unsigned long long Perft_run( struct RuntimeSetup* runtimeSetup, Board* board, int depth, bool divide )
+unsigned long long Perft_run( struct RuntimeSetup* runtimeSetup, struct PerftOptions* options, Board* board, int depth, bool divide )
 {
-    return divide ? Perft_divide( runtimeSetup, board, depth ) : Perft_loop( runtimeSetup, board, depth );
+    // Only worth splitting if there is something left to count below the split
+    if ( options->threads > 1 && depth > (int) options->splitDepth )
+    {
+        return Perft_parallel( runtimeSetup, options, board, depth, divide );
+    }
+
+    return divide ? Perft_divide( runtimeSetup, options, board, depth ) : Perft_loop( runtimeSetup, options, board, depth );
 }
 
-unsigned long long Perft_loop( struct RuntimeSetup* runtimeSetup, Board* board, int depth )
+unsigned long long Perft_loop( struct RuntimeSetup* runtimeSetup, struct PerftOptions* options, Board* board, int depth )
 {
     if ( depth == 0 )
     {
@@ -174,31 +258,55 @@ unsigned long long Perft_loop( struct RuntimeSetup* runtimeSetup, Board* board,
 
     MoveList moveList;
     moveList.count = 0;
-    Board_generateMoves( board, &moveList );
 
     // This is a cheating optimisation
     if ( depth == 1 )
     {
+        Board_generateMoves( board, &moveList );
         return moveList.count;
     }
 
-    Board copy;
-    Board_copy( board, &copy );
+    if ( Perft_isStopped( options ) )
+    {
+        return 0;
+    }
+
+    // Have we counted this position to this depth before, maybe via a different move order?
+    unsigned long long key = 0;
+    if ( options->hashTable != NULL )
+    {
+        key = board->key;
+
+        if ( Perft_probe( options, key, depth, &nodes ) )
+        {
+            return nodes;
+        }
+    }
+
+    Board_generateMoves( board, &moveList );
+
+    Undo undo;
 
     for ( unsigned char loop = 0; loop < moveList.count; loop++ )
     {
-        if ( Board_makeMove( board, moveList.moves[ loop ] ) )
+        if ( Board_makeMove( board, moveList.moves[ loop ], &undo ) )
         {
-            nodes += Perft_loop( runtimeSetup, board, depth - 1 );
+            nodes += Perft_loop( runtimeSetup, options, board, depth - 1 );
         }
 
-        Board_apply( board, &copy );
+        Board_unmakeMove( board, moveList.moves[ loop ], &undo );
+    }
+
+    // A count cut short by a stop is wrong, so mustn't be kept
+    if ( options->hashTable != NULL && !Perft_isStopped( options ) )
+    {
+        Perft_store( options, key, depth, nodes );
     }
 
     return nodes;
 }
 
-unsigned long long Perft_divide( struct RuntimeSetup* runtimeSetup, Board* board, int depth )
+unsigned long long Perft_divide( struct RuntimeSetup* runtimeSetup, struct PerftOptions* options, Board* board, int depth )
 {
     if ( depth == 0 )
     {
@@ -215,14 +323,13 @@ unsigned long long Perft_divide( struct RuntimeSetup* runtimeSetup, Board* board
     moveList.count = 0;
     Board_generateMoves( board, &moveList );
 
-    Board copy;
-    Board_copy( board, &copy );
+    Undo undo;
 
     for ( unsigned char loop = 0; loop < moveList.count; loop++ )
     {
-        if ( Board_makeMove( board, moveList.moves[ loop ] ) )
+        if ( Board_makeMove( board, moveList.moves[ loop ], &undo ) )
         {
-            divideNodes = Perft_loop( runtimeSetup, board, depth - 1 );
+            divideNodes = Perft_loop( runtimeSetup, options, board, depth - 1 );
             nodes += divideNodes;
 
             Board_exportMove( moveList.moves[ loop ], moveString );
@@ -231,8 +338,221 @@ unsigned long long Perft_divide( struct RuntimeSetup* runtimeSetup, Board* board
             LOG_INFO( "  %s : %llu - %s", moveString, divideNodes, fenString );
         }
 
-        Board_apply( board, &copy );
+        Board_unmakeMove( board, moveList.moves[ loop ], &undo );
+    }
+
+    return nodes;
+}
+
+unsigned long long Perft_parallel( struct RuntimeSetup* runtimeSetup, struct PerftOptions* options, Board* board, int depth, bool divide )
+{
+    struct PerftWork work;
+    work.runtimeSetup = runtimeSetup;
+    work.options = options;
+    work.tasks = NULL;
+    work.count = 0;
+    work.capacity = 0;
+    work.next = 0;
+
+    if ( mtx_init( &work.lock, mtx_plain ) != thrd_success )
+    {
+        LOG_ERROR( "Failed to create perft work queue, counting on one thread" );
+        return divide ? Perft_divide( runtimeSetup, options, board, depth ) : Perft_loop( runtimeSetup, options, board, depth );
+    }
+
+    MoveList moveList;
+    moveList.count = 0;
+    Board_generateMoves( board, &moveList );
+
+    // Break the tree into tasks at the split depth, remembering which root move each came from
+    Undo undo;
+    bool split = true;
+
+    for ( unsigned char loop = 0; loop < moveList.count && split; loop++ )
+    {
+        Board_makeMove( board, moveList.moves[ loop ], &undo );
+        split = Perft_split( &work, board, depth - 1, options->splitDepth - 1, loop );
+        Board_unmakeMove( board, moveList.moves[ loop ], &undo );
+    }
+
+    if ( !split )
+    {
+        LOG_ERROR( "Failed to allocate memory for perft tasks, counting on one thread" );
+
+        free( work.tasks );
+        mtx_destroy( &work.lock );
+
+        return divide ? Perft_divide( runtimeSetup, options, board, depth ) : Perft_loop( runtimeSetup, options, board, depth );
+    }
+
+    // This thread works through the queue too, so start one fewer helper than asked for
+    unsigned int helperCount = options->threads - 1;
+    if ( helperCount > work.count )
+    {
+        helperCount = work.count;
+    }
+
+    thrd_t* helpers = malloc( helperCount * sizeof( thrd_t ) );
+    unsigned int started = 0;
+
+    if ( helpers != NULL )
+    {
+        for ( ; started < helperCount; started++ )
+        {
+            if ( thrd_create( &helpers[ started ], Perft_worker, &work ) != thrd_success )
+            {
+                LOG_WARN( "Only able to start %u of %u perft threads", started + 1, options->threads );
+                break;
+            }
+        }
+    }
+
+    Perft_worker( &work );
+
+    for ( unsigned int loop = 0; loop < started; loop++ )
+    {
+        thrd_join( helpers[ loop ], NULL );
+    }
+
+    free( helpers );
+
+    // Gather up the results by root move
+    unsigned long long rootNodes[ 256 ];
+    memset( rootNodes, 0, sizeof( rootNodes ) );
+
+    unsigned long long nodes = 0;
+    for ( unsigned int loop = 0; loop < work.count; loop++ )
+    {
+        rootNodes[ work.tasks[ loop ].root ] += work.tasks[ loop ].nodes;
+        nodes += work.tasks[ loop ].nodes;
+    }
+
+    if ( divide )
+    {
+        char moveString[ 10 ];
+        char fenString[ 256 ];
+
+        for ( unsigned char loop = 0; loop < moveList.count; loop++ )
+        {
+            Board_makeMove( board, moveList.moves[ loop ], &undo );
+
+            Board_exportMove( moveList.moves[ loop ], moveString );
+            Board_exportBoard( board, fenString );
+
+            LOG_INFO( "  %s : %llu - %s", moveString, rootNodes[ loop ], fenString );
+
+            Board_unmakeMove( board, moveList.moves[ loop ], &undo );
+        }
     }
 
+    free( work.tasks );
+    mtx_destroy( &work.lock );
+
     return nodes;
 }
+
+bool Perft_split( struct PerftWork* work, Board* board, int depth, unsigned int splitDepth, unsigned char root )
+{
+    if ( splitDepth == 0 || depth == 0 )
+    {
+        if ( work->count == work->capacity )
+        {
+            unsigned int capacity = work->capacity == 0 ? 256 : work->capacity * 2;
+
+            PerftTask* tasks = realloc( work->tasks, capacity * sizeof( PerftTask ) );
+            if ( tasks == NULL )
+            {
+                return false;
+            }
+
+            work->tasks = tasks;
+            work->capacity = capacity;
+        }
+
+        PerftTask* task = &work->tasks[ work->count++ ];
+        Board_copy( board, &task->board );
+        task->depth = depth;
+        task->root = root;
+        task->nodes = 0;
+
+        return true;
+    }
+
+    MoveList moveList;
+    moveList.count = 0;
+    Board_generateMoves( board, &moveList );
+
+    Undo undo;
+    bool split = true;
+
+    for ( unsigned char loop = 0; loop < moveList.count && split; loop++ )
+    {
+        Board_makeMove( board, moveList.moves[ loop ], &undo );
+        split = Perft_split( work, board, depth - 1, splitDepth - 1, root );
+        Board_unmakeMove( board, moveList.moves[ loop ], &undo );
+    }
+
+    return split;
+}
+
+int Perft_worker( void* argument )
+{
+    struct PerftWork* work = argument;
+
+    while ( true )
+    {
+        mtx_lock( &work->lock );
+        unsigned int next = work->next++;
+        mtx_unlock( &work->lock );
+
+        if ( next >= work->count )
+        {
+            break;
+        }
+
+        // Each task has its own board, so nothing is shared while counting
+        PerftTask* task = &work->tasks[ next ];
+        task->nodes = Perft_loop( work->runtimeSetup, work->options, &task->board, task->depth );
+    }
+
+    return 0;
+}
+
+bool Perft_isStopped( struct PerftOptions* options )
+{
+    return options->stop != NULL && atomic_load_explicit( options->stop, memory_order_relaxed );
+}
+
+bool Perft_probe( struct PerftOptions* options, unsigned long long key, int depth, unsigned long long* nodes )
+{
+    PerftHashEntry* bucket = &options->hashTable[ ( key & options->hashMask ) * PERFT_HASH_BUCKET_SIZE ];
+
+    for ( unsigned short loop = 0; loop < PERFT_HASH_BUCKET_SIZE; loop++ )
+    {
+        // Read each half once - another thread may be writing this entry as we look at it
+        const unsigned long long data = bucket[ loop ].data;
+        const unsigned long long check = bucket[ loop ].check;
+
+        if ( ( check ^ data ) == key && ( data & 0xff ) == (unsigned long long) depth )
+        {
+            *nodes = data >> 8;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Perft_store( struct PerftOptions* options, unsigned long long key, int depth, unsigned long long nodes )
+{
+    PerftHashEntry* bucket = &options->hashTable[ ( key & options->hashMask ) * PERFT_HASH_BUCKET_SIZE ];
+
+    // Node count in the upper 56 bits, depth in the lower 8
+    const unsigned long long data = ( nodes << 8 ) | (unsigned long long) depth;
+
+    // The first entry keeps the largest subtree, the second takes whatever doesn't qualify for the first
+    PerftHashEntry* entry = (int) ( bucket[ 0 ].data & 0xff ) <= depth ? &bucket[ 0 ] : &bucket[ 1 ];
+
+    entry->check = key ^ data;
+    entry->data = data;
+}
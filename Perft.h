@@ -1,16 +1,96 @@
 #pragma once
 
+#include <stdatomic.h>
+#include <threads.h>
+
 #include "Board.h"
 #include "RuntimeSetup.h"
 
-// Public methods 
+/// <summary>
+/// A perft hash table entry, holding the node count below a position at a given depth. Entries are
+/// shared between threads without locks, so the key is stored XORed with the data. A read that
+/// catches another thread part way through a write will then fail to match, rather than return a
+/// count from some other position
+/// </summary>
+typedef struct
+{
+    unsigned long long check;
+    unsigned long long data;
+} PerftHashEntry;
+
+// Entries are grouped in pairs, one kept for the deepest result and one always replaced
+#define PERFT_HASH_BUCKET_SIZE 2
+
+/// <summary>
+/// Settings for a perft run that come from the perft command rather than from the position
+/// </summary>
+struct PerftOptions
+{
+    // How many threads to count with. 1 runs everything on the calling thread
+    unsigned int threads;
+
+    // How many plies below the root to split the work into tasks for the threads. 1 gives one
+    // task per root move, higher values give more, smaller tasks for better balance across many threads
+    unsigned int splitDepth;
+
+    // Optional hash table of subtree counts, shared by all threads. NULL when not in use
+    PerftHashEntry* hashTable;
+    unsigned long long hashMask;
+
+    // Optional flag, set from another thread to abandon the count. NULL when not in use
+    atomic_bool* stop;
+};
+
+/// <summary>
+/// A position handed to one of the perft threads, along with the result of counting it
+/// </summary>
+typedef struct
+{
+    Board board;
+    int depth;
+    unsigned char root;
+    unsigned long long nodes;
+} PerftTask;
+
+/// <summary>
+/// The shared queue of tasks that the perft threads take their work from
+/// </summary>
+struct PerftWork
+{
+    struct RuntimeSetup* runtimeSetup;
+    struct PerftOptions* options;
+    PerftTask* tasks;
+    unsigned int count;
+    unsigned int capacity;
+    unsigned int next;
+    mtx_t lock;
+};
+
+// Public methods
+
+void PerftOptions_initialize( struct PerftOptions* options );
+void PerftOptions_destroy( struct PerftOptions* options );
+
+/// <summary>
+/// Allocate a hash table of about the given size, rounded down to a power of two number of buckets
+/// </summary>
+/// <param name="options">the options to hold the table</param>
+/// <param name="megabytes">the size, or 0 for no hash table</param>
+/// <returns>false if the memory could not be allocated</returns>
+bool PerftOptions_setHashSize( struct PerftOptions* options, unsigned long long megabytes );
 
-unsigned long long Perft_depth( struct RuntimeSetup* runtimeSetup, int depth, const char* fen, bool divide );
-void Perft_fen( struct RuntimeSetup* runtimeSetup, char* fenWithResults );
-void Perft_file( struct RuntimeSetup* runtimeSetup, const char* filename );
+unsigned long long Perft_depth( struct RuntimeSetup* runtimeSetup, struct PerftOptions* options, int depth, const char* fen, bool divide );
+void Perft_fen( struct RuntimeSetup* runtimeSetup, struct PerftOptions* options, char* fenWithResults );
+void Perft_file( struct RuntimeSetup* runtimeSetup, struct PerftOptions* options, const char* filename );
 
 // Internal methods
 
-unsigned long long Perft_run( struct RuntimeSetup* runtimeSetup, Board* board, int depth, bool divide );
-unsigned long long Perft_loop( struct RuntimeSetup* runtimeSetup, Board* board, int depth );
-unsigned long long Perft_divide( struct RuntimeSetup* runtimeSetup, Board* board, int depth );
\ No newline at end of file
+unsigned long long Perft_run( struct RuntimeSetup* runtimeSetup, struct PerftOptions* options, Board* board, int depth, bool divide );
+unsigned long long Perft_loop( struct RuntimeSetup* runtimeSetup, struct PerftOptions* options, Board* board, int depth );
+unsigned long long Perft_divide( struct RuntimeSetup* runtimeSetup, struct PerftOptions* options, Board* board, int depth );
+unsigned long long Perft_parallel( struct RuntimeSetup* runtimeSetup, struct PerftOptions* options, Board* board, int depth, bool divide );
+bool Perft_split( struct PerftWork* work, Board* board, int depth, unsigned int splitDepth, unsigned char root );
+int Perft_worker( void* argument );
+bool Perft_isStopped( struct PerftOptions* options );
+bool Perft_probe( struct PerftOptions* options, unsigned long long key, int depth, unsigned long long* nodes );
+void Perft_store( struct PerftOptions* options, unsigned long long key, int depth, unsigned long long nodes );
@@ -0,0 +1,1211 @@
+#include <io.h>
+#include <ctype.h>
+#include <errno.h>
+#include <intrin.h>
+#include <math.h>
+#include <memory.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <threads.h>
+
+#include "Evaluation.h"
+#include "Search.h"
+#include "UCI.h"
+#include "Utility.h"
+
+#define LOG_DEBUG( ... ) { RuntimeSetup_log( runtimeSetup, DEBUG, __VA_ARGS__ ); }
+#define LOG_INFO( ... ) { RuntimeSetup_log( runtimeSetup, INFO, __VA_ARGS__ ); }
+#define LOG_WARN( ... ) { RuntimeSetup_log( runtimeSetup, WARN, __VA_ARGS__ ); }
+#define LOG_ERROR( ... ) { RuntimeSetup_log( runtimeSetup, ERROR, __VA_ARGS__ ); }
+
+// How many nodes to search between looks at the clock, as reading it costs more than searching a node.
+// Must be a power of two
+#define TIME_CHECK_INTERVAL 1024
+
+// How long to sleep between looks at the stop flag, when the search is done but may not yet answer
+#define PONDER_WAIT_NANOSECONDS 1000000
+
+// The most that one cutoff can change a history score by
+#define HISTORY_BONUS_LIMIT 1200
+
+// Quiet moves that failed to cut off before one that did are remembered up to this many, to be marked down
+#define MAX_QUIETS_TRIED 64
+
+// Null move pruning. The reduction grows with depth. With less than this much material besides pawns, a
+// cutoff from the null move is checked by a reduced search, as zugzwang is then likely enough that passing
+// could be the best move. With no material besides pawns the null move isn't tried at all
+#define NULL_MOVE_MINIMUM_DEPTH 3
+#define NULL_MOVE_REDUCTION 3
+#define NULL_MOVE_VERIFICATION_MATERIAL 820
+
+// Reverse futility pruning: give up on a node where the evaluation is this much per ply above beta
+#define REVERSE_FUTILITY_DEPTH 6
+#define REVERSE_FUTILITY_MARGIN 100
+
+// Futility pruning: skip quiet moves where the evaluation is this much per ply below alpha
+#define FUTILITY_DEPTH 3
+#define FUTILITY_MARGIN 120
+
+// Late move pruning: skip the remaining quiet moves after this many plus the depth squared
+#define LATE_MOVE_PRUNING_DEPTH 4
+#define LATE_MOVE_PRUNING_BASE 3
+
+// Late move reductions start at this depth and after this many moves. History of this much counts
+// for a ply of reduction either way
+#define LATE_MOVE_REDUCTION_DEPTH 3
+#define LATE_MOVE_REDUCTION_MOVES 3
+#define LATE_MOVE_REDUCTION_HISTORY 8192
+
+// Aspiration windows start this far either side of the previous iteration's score, from this depth on,
+// and grow by half as much again each time the score falls outside
+#define ASPIRATION_WINDOW 25
+#define ASPIRATION_DEPTH 4
+
+// A tablebase result is kept in the transposition table as if searched this much deeper than it was, as
+// searching deeper could not change it
+#define TABLEBASE_DEPTH_BONUS 6
+
+// Helpers skip some iterations so that the threads aren't all working on the same one, which makes for more
+// useful sharing through the transposition table. Each helper in turn has its own pattern from these, skipping
+// runs of skipSize iterations in every other run, offset by skipPhase
+#define SKIP_PATTERNS 20
+static const int skipSize[ SKIP_PATTERNS ] = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static const int skipPhase[ SKIP_PATTERNS ] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+// Reductions indexed by depth and by the number of moves already searched, worked out on first use
+#define REDUCTION_MOVES 64
+static int reductions[ MAX_PLY ][ REDUCTION_MOVES ];
+static bool reductionsInitialized = false;
+
+// A game is drawn once this many plies have passed without a capture or pawn move
+#define FIFTY_MOVE_PLIES 100
+
+// Material values in centipawns, indexed by ColorlessPiece
+static const int pieceValues[ 7 ] = { 0, 100, 320, 330, 500, 900, 0 };
+
+void SearchLimits_initialize( struct SearchLimits* limits )
+{
+    memset( limits, 0, sizeof( struct SearchLimits ) );
+}
+
+void SearchOptions_initialize( struct SearchOptions* options )
+{
+    options->threads = SEARCH_DEFAULT_THREADS;
+    options->multiPv = SEARCH_DEFAULT_MULTI_PV;
+    options->moveOverhead = TM_DEFAULT_MOVE_OVERHEAD;
+    options->nullMovePruning = true;
+    options->lateMoveReductions = true;
+    options->reverseFutilityPruning = true;
+    options->futilityPruning = true;
+    options->lateMovePruning = true;
+    options->syzygyProbeDepth = SYZYGY_DEFAULT_PROBE_DEPTH;
+    options->syzygyProbeLimit = SYZYGY_DEFAULT_PROBE_LIMIT;
+}
+
+Move Search_start( struct RuntimeSetup* runtimeSetup, Board* board, const KeyHistory* keyHistory, const struct SearchLimits* limits, const struct SearchOptions* options, struct TranspositionTable* transpositionTable, struct PawnTable* pawnTable, struct MaterialTable* materialTable, const struct Nnue* network, const struct Syzygy* tablebases, atomic_bool* stop )
+{
+    struct SearchShared shared;
+    shared.threadCount = options->threads > 0 ? options->threads : 1;
+    shared.stop = stop;
+
+    // The principal variation tables make these too big for the stack
+    shared.threads = malloc( shared.threadCount * sizeof( Search ) );
+    if ( shared.threads == NULL )
+    {
+        LOG_ERROR( "Failed to allocate memory for search" );
+        UCI_broadcast( runtimeSetup, "bestmove 0000" );
+        return NO_MOVE;
+    }
+
+    const unsigned long long startTime = wallClockMilliseconds();
+
+    struct TimeManager timeManager;
+    TimeManager_initialize( &timeManager,
+                            limits->movetime,
+                            board->whiteToMove ? limits->wtime : limits->btime,
+                            board->whiteToMove ? limits->winc : limits->binc,
+                            limits->movestogo,
+                            options->moveOverhead );
+
+    LOG_DEBUG( "Searching with %u threads, optimum time %llums and maximum time %llums", shared.threadCount, timeManager.optimumTime, timeManager.maximumTime );
+
+    TranspositionTable_newSearch( transpositionTable );
+
+    Search_initializeReductions();
+
+    // There can't be more lines than there are moves to start them with
+    MoveList moveList;
+    moveList.count = 0;
+    Board_generateMoves( board, &moveList );
+
+    // With few enough pieces, the tablebases say which moves keep the best result there is, with the fifty move
+    // rule in mind. Only those are searched, and unless the search still has to find how to win, the tables
+    // aren't probed within it as it can't do better
+    int probeLimit = options->syzygyProbeLimit < tablebases->largest ? options->syzygyProbeLimit : tablebases->largest;
+    unsigned long long rootTbHits = 0;
+
+    if ( probeLimit > 0 &&
+         Board_castlingRights( board ) == 0 &&
+         (int) __popcnt64( board->whitePieces.bbAll | board->blackPieces.bbAll ) <= probeLimit )
+    {
+        // Moves are made and taken back on a copy, so that the position is left exactly as it was
+        Board rootBoard;
+        Board_copy( board, &rootBoard );
+
+        const unsigned int rootMoveCount = moveList.count;
+        bool keepProbing;
+
+        if ( Syzygy_filterRootMoves( tablebases, &rootBoard, Board_isRepetition( board, keyHistory ), &moveList, &keepProbing ) )
+        {
+            LOG_DEBUG( "Tablebases leave %u of %u root moves", moveList.count, rootMoveCount );
+
+            probeLimit = keepProbing ? probeLimit : 0;
+            rootTbHits = rootMoveCount;
+        }
+    }
+
+    unsigned int lineCount = options->multiPv < SEARCH_MAXIMUM_MULTI_PV ? options->multiPv : SEARCH_MAXIMUM_MULTI_PV;
+    if ( lineCount > moveList.count )
+    {
+        lineCount = moveList.count;
+    }
+
+    // Every thread gets its own copy of the position to make moves on
+    for ( unsigned int loop = 0; loop < shared.threadCount; loop++ )
+    {
+        Search* search = &shared.threads[ loop ];
+
+        Board_copy( board, &search->board );
+
+        // Nothing is in the accumulator yet, so it is worked out from scratch when first needed
+        Board_clearPieceChanges( &search->board );
+
+        memcpy( &search->keyHistory, keyHistory, sizeof( KeyHistory ) );
+        search->runtimeSetup = runtimeSetup;
+        search->limits = limits;
+        search->options = options;
+        search->transpositionTable = transpositionTable;
+        search->pawnTable = pawnTable;
+        search->materialTable = materialTable;
+        search->network = network;
+        search->tablebases = tablebases;
+        search->probeLimit = probeLimit;
+        search->rootMoves = moveList;
+        search->shared = &shared;
+        search->threadIndex = loop;
+        atomic_init( &search->nodes, 0 );
+        atomic_init( &search->tbHits, loop == 0 ? rootTbHits : 0 );
+        search->startTime = startTime;
+        search->clockStartTime = startTime;
+        search->pondering = atomic_load_explicit( &limits->ponder, memory_order_relaxed );
+        search->timeManager = timeManager;
+        search->stopped = false;
+        search->nullMoveMinimumPly = 0;
+
+        // The helpers are only there to fill the transposition table for the main thread, so the best line
+        // is all they need to look for
+        search->lineCount = loop == 0 && lineCount > 1 ? lineCount : 1;
+        for ( unsigned int line = 0; line < search->lineCount; line++ )
+        {
+            search->lines[ line ].score = 0;
+            search->lines[ line ].length = 0;
+        }
+
+        memset( search->killers, 0, sizeof( search->killers ) );
+        MoveHistory_clear( &search->history );
+    }
+
+    thrd_t* helpers = NULL;
+    unsigned int started = 0;
+
+    if ( shared.threadCount > 1 )
+    {
+        helpers = malloc( ( shared.threadCount - 1 ) * sizeof( thrd_t ) );
+
+        if ( helpers != NULL )
+        {
+            for ( ; started < shared.threadCount - 1; started++ )
+            {
+                if ( thrd_create( &helpers[ started ], Search_worker, &shared.threads[ started + 1 ] ) != thrd_success )
+                {
+                    LOG_WARN( "Only able to start %u of %u search threads", started + 1, shared.threadCount );
+                    break;
+                }
+            }
+        }
+
+        // Leave out any that didn't start when adding up the nodes
+        shared.threadCount = started + 1;
+    }
+
+    // The calling thread is the main thread, that decides when to stop and reports the result
+    Search_iterate( &shared.threads[ 0 ] );
+
+    // While pondering, or searching without limits, the GUI has the last word, so even with nothing left to
+    // search the result has to wait until we are told to stop or the pondered move is played
+    while ( ( atomic_load_explicit( &limits->ponder, memory_order_relaxed ) || limits->infinite ) && !atomic_load_explicit( shared.stop, memory_order_relaxed ) )
+    {
+        thrd_sleep( &( struct timespec ) { .tv_nsec = PONDER_WAIT_NANOSECONDS }, NULL );
+    }
+
+    atomic_store_explicit( shared.stop, true, memory_order_relaxed );
+
+    for ( unsigned int loop = 0; loop < started; loop++ )
+    {
+        thrd_join( helpers[ loop ], NULL );
+    }
+
+    free( helpers );
+
+    Search* mainThread = &shared.threads[ 0 ];
+    Move bestMove = mainThread->lines[ 0 ].length > 0 ? mainThread->lines[ 0 ].moves[ 0 ] : NO_MOVE;
+    Move ponderMove = mainThread->lines[ 0 ].length > 1 ? mainThread->lines[ 0 ].moves[ 1 ] : NO_MOVE;
+
+    free( shared.threads );
+
+    // Stopped before even the first iteration finished, so play anything legal rather than nothing
+    if ( bestMove == NO_MOVE && moveList.count > 0 )
+    {
+        bestMove = moveList.moves[ 0 ];
+    }
+
+    if ( bestMove == NO_MOVE )
+    {
+        UCI_broadcast( runtimeSetup, "bestmove 0000" );
+    }
+    else
+    {
+        char moveString[ 10 ];
+        Board_exportMove( bestMove, moveString );
+
+        // Suggest the reply from the best line for the GUI to ponder on
+        if ( ponderMove != NO_MOVE )
+        {
+            char ponderString[ 10 ];
+            Board_exportMove( ponderMove, ponderString );
+            UCI_broadcast( runtimeSetup, "bestmove %s ponder %s", moveString, ponderString );
+        }
+        else
+        {
+            UCI_broadcast( runtimeSetup, "bestmove %s", moveString );
+        }
+    }
+
+    return bestMove;
+}
+
+void Search_iterate( Search* self )
+{
+    const int maxDepth = self->limits->depth > 0 && self->limits->depth < MAX_PLY ? self->limits->depth : MAX_PLY - 1;
+
+    for ( int depth = 1; depth <= maxDepth; depth++ )
+    {
+        if ( self->threadIndex > 0 )
+        {
+            const int pattern = ( self->threadIndex - 1 ) % SKIP_PATTERNS;
+
+            if ( ( ( depth + skipPhase[ pattern ] ) / skipSize[ pattern ] ) % 2 != 0 )
+            {
+                continue;
+            }
+        }
+
+        const unsigned long long iterationStartNodes = atomic_load_explicit( &self->nodes, memory_order_relaxed );
+        self->bestMoveNodes = 0;
+
+        // Each line after the first is the best of the moves not already starting a line. They all share the
+        // transposition table and move ordering, so each costs about as much as a search for the best move
+        for ( self->lineIndex = 0; self->lineIndex < self->lineCount; self->lineIndex++ )
+        {
+            struct SearchLine* line = &self->lines[ self->lineIndex ];
+
+            // Expect the score to be close to the last one, and search with a narrow window around it as
+            // that cuts off much more. Mate scores can jump about, so get the full window
+            int delta = ASPIRATION_WINDOW;
+            int alpha = -INFINITE_SCORE;
+            int beta = INFINITE_SCORE;
+            int score = line->score;
+
+            if ( depth >= ASPIRATION_DEPTH && line->length > 0 && score > -MATE_BOUND && score < MATE_BOUND )
+            {
+                alpha = score - delta;
+                beta = score + delta;
+            }
+
+            while ( true )
+            {
+                self->followPv = line->length > 0;
+
+                score = Search_negamax( self, depth, 0, alpha, beta );
+
+                if ( self->stopped || ( score > alpha && score < beta ) )
+                {
+                    break;
+                }
+
+                // Outside the window, so all we know is which side of it the score is. Widen that side and
+                // search again
+                if ( score <= alpha )
+                {
+                    if ( self->threadIndex == 0 )
+                    {
+                        Search_reportIteration( self, depth, self->lineIndex, score, BOUND_UPPER );
+                    }
+
+                    beta = ( alpha + beta ) / 2;
+                    alpha = score - delta > -INFINITE_SCORE ? score - delta : -INFINITE_SCORE;
+                }
+                else
+                {
+                    // The move that failed high is better than the one we had, so keep it in case we run
+                    // out of time before the search of the wider window finishes
+                    Search_keepLine( self, score );
+
+                    if ( self->threadIndex == 0 )
+                    {
+                        Search_reportIteration( self, depth, self->lineIndex, score, BOUND_LOWER );
+                    }
+
+                    beta = score + delta < INFINITE_SCORE ? score + delta : INFINITE_SCORE;
+                }
+
+                delta += delta / 2;
+            }
+
+            // An unfinished search may not have looked at the best move yet, so its result is not trusted
+            if ( self->stopped )
+            {
+                break;
+            }
+
+            Search_keepLine( self, score );
+        }
+
+        if ( self->stopped )
+        {
+            break;
+        }
+
+        // Only the main thread reports, or decides when to stop
+        if ( self->threadIndex > 0 )
+        {
+            continue;
+        }
+
+        Search_sortLines( self );
+
+        for ( unsigned int loop = 0; loop < self->lineCount; loop++ )
+        {
+            Search_reportIteration( self, depth, loop, self->lines[ loop ].score, BOUND_EXACT );
+        }
+
+        // With no legal moves at the root there is no line, and its first move was never written
+        const Move bestMove = self->lines[ 0 ].length > 0 ? self->lines[ 0 ].moves[ 0 ] : NO_MOVE;
+
+        TimeManager_update( &self->timeManager, bestMove, self->lines[ 0 ].score, self->bestMoveNodes, atomic_load_explicit( &self->nodes, memory_order_relaxed ) - iterationStartNodes );
+
+        if ( !self->pondering && TimeManager_isSoftLimitReached( &self->timeManager, wallClockMilliseconds() - self->clockStartTime ) )
+        {
+            break;
+        }
+    }
+}
+
+int Search_worker( void* argument )
+{
+    Search_iterate( (Search*) argument );
+
+    return 0;
+}
+
+unsigned long long Search_totalNodes( Search* self )
+{
+    unsigned long long nodes = 0;
+
+    for ( unsigned int loop = 0; loop < self->shared->threadCount; loop++ )
+    {
+        nodes += atomic_load_explicit( &self->shared->threads[ loop ].nodes, memory_order_relaxed );
+    }
+
+    return nodes;
+}
+
+unsigned long long Search_totalTbHits( Search* self )
+{
+    unsigned long long tbHits = 0;
+
+    for ( unsigned int loop = 0; loop < self->shared->threadCount; loop++ )
+    {
+        tbHits += atomic_load_explicit( &self->shared->threads[ loop ].tbHits, memory_order_relaxed );
+    }
+
+    return tbHits;
+}
+
+int Search_negamax( Search* self, int depth, int ply, int alpha, int beta )
+{
+    // Carry on with captures only until the position is quiet enough to trust the evaluation. Reductions
+    // can take the depth below zero
+    if ( depth <= 0 )
+    {
+        return Search_quiescence( self, ply, alpha, beta );
+    }
+
+    self->pvLength[ ply ] = ply;
+    Search_countNode( self );
+
+    if ( Search_checkLimits( self ) )
+    {
+        return 0;
+    }
+
+    // Going round in circles, or for too long without progress, is a draw and there is nothing more to search.
+    // So is a position where neither side has enough left to mate. Not at the root though, where we need a move
+    if ( ply > 0 && ( self->board.halfmoveClock >= FIFTY_MOVE_PLIES ||
+                      Board_isRepetition( &self->board, &self->keyHistory ) ||
+                      MaterialTable_isDeadDraw( self->materialTable, &self->board ) ) )
+    {
+        return 0;
+    }
+
+    if ( ply >= MAX_PLY - 1 )
+    {
+        return Search_evaluate( self );
+    }
+
+    // A result from an earlier search of this position may be enough to decide this one without searching
+    // again. Not at the root though, where we need the move along with the line that follows it
+    const unsigned long long key = self->board.key;
+    Move hashMove = NO_MOVE;
+
+    TranspositionData entry;
+    if ( TranspositionTable_probe( self->transpositionTable, key, &entry ) )
+    {
+        hashMove = entry.move;
+
+        if ( ply > 0 && entry.depth >= depth )
+        {
+            const int score = Search_scoreFromTable( entry.score, ply );
+
+            if ( entry.bound == BOUND_EXACT ||
+                 ( entry.bound == BOUND_LOWER && score >= beta ) ||
+                 ( entry.bound == BOUND_UPPER && score <= alpha ) )
+            {
+                return score;
+            }
+        }
+    }
+
+    // Within the tablebases the result is known, and unless it leaves the bounds open there is nothing to search
+    int tablebaseScore;
+    if ( ply > 0 && Search_probeTablebases( self, depth, ply, alpha, beta, &tablebaseScore ) )
+    {
+        return tablebaseScore;
+    }
+
+    const bool inCheck = Board_isInCheck( &self->board );
+
+    // Walking down the previous iteration's best line, search its move first at each ply so that the
+    // rest of the tree is searched with good bounds. Elsewhere, the best move from the hash table
+    // serves the same purpose
+    Move pvMove = NO_MOVE;
+    if ( self->followPv )
+    {
+        self->followPv = false;
+
+        if ( ply < self->lines[ self->lineIndex ].length )
+        {
+            pvMove = self->lines[ self->lineIndex ].moves[ ply ];
+        }
+    }
+
+    // A window with no room between alpha and beta only asks whether the score is above or below it, which
+    // is where the selective parts of the search are safe to use. Anything wider is after an exact score
+    const struct SearchOptions* options = self->options;
+    const bool pvNode = beta - alpha > 1;
+    const int staticEval = inCheck ? -INFINITE_SCORE : Search_evaluate( self );
+
+    if ( !pvNode && !inCheck && ply > 0 )
+    {
+        // So far above beta that nothing found in the few plies left is likely to bring it back down
+        if ( options->reverseFutilityPruning &&
+             depth <= REVERSE_FUTILITY_DEPTH &&
+             beta > -MATE_BOUND && beta < MATE_BOUND &&
+             staticEval - REVERSE_FUTILITY_MARGIN * depth >= beta )
+        {
+            return staticEval;
+        }
+
+        // If the opponent can't get back to beta even when given two moves in a row, a real move will
+        // almost certainly do at least as well. Not twice in a row, which would search the same position
+        const int nonPawnMaterial = Search_nonPawnMaterial( &self->board );
+
+        if ( options->nullMovePruning &&
+             depth >= NULL_MOVE_MINIMUM_DEPTH &&
+             ply >= self->nullMoveMinimumPly &&
+             staticEval >= beta &&
+             nonPawnMaterial > 0 &&
+             self->moveStack[ ply - 1 ] != NO_MOVE )
+        {
+            const int nullDepth = depth - 1 - NULL_MOVE_REDUCTION - depth / 6;
+            Undo nullUndo;
+
+            self->moveStack[ ply ] = NO_MOVE;
+            KeyHistory_push( &self->keyHistory, key );
+
+            Board_makeNullMove( &self->board, &nullUndo );
+            int score = -Search_negamax( self, nullDepth, ply + 1, -beta, -beta + 1 );
+            Board_unmakeNullMove( &self->board, &nullUndo );
+
+            KeyHistory_pop( &self->keyHistory );
+
+            if ( self->stopped )
+            {
+                return 0;
+            }
+
+            if ( score >= beta )
+            {
+                // A mate found after passing isn't a real one
+                if ( score >= MATE_BOUND )
+                {
+                    score = beta;
+                }
+
+                if ( nonPawnMaterial >= NULL_MOVE_VERIFICATION_MATERIAL )
+                {
+                    return score;
+                }
+
+                // Search this position again to the same depth without passing, and with no null moves
+                // for the first part of the subtree either, to see if there is a real move that holds beta
+                const int savedMinimumPly = self->nullMoveMinimumPly;
+                self->nullMoveMinimumPly = ply + 3 * nullDepth / 4 + 1;
+
+                const int verification = Search_negamax( self, nullDepth, ply, beta - 1, beta );
+
+                self->nullMoveMinimumPly = savedMinimumPly;
+
+                if ( self->stopped )
+                {
+                    return 0;
+                }
+
+                if ( verification >= beta )
+                {
+                    return score;
+                }
+            }
+        }
+    }
+
+    // Near the leaves, quiet moves can't make up a big enough deficit to be worth searching
+    const bool futile = options->futilityPruning &&
+                        !pvNode &&
+                        !inCheck &&
+                        depth <= FUTILITY_DEPTH &&
+                        alpha > -MATE_BOUND && alpha < MATE_BOUND &&
+                        staticEval + FUTILITY_MARGIN * depth <= alpha;
+
+    // The quiet move that refuted the last move made elsewhere in the tree may well do so again here
+    Move counterMove = NO_MOVE;
+    if ( ply > 0 && self->moveStack[ ply - 1 ] != NO_MOVE )
+    {
+        const unsigned long previousTo = Move_to( self->moveStack[ ply - 1 ] );
+        counterMove = self->history.counterMoves[ self->board.squares[ previousTo ] ][ previousTo ];
+    }
+
+    MovePicker movePicker;
+    MovePicker_initialize( &movePicker, &self->board, pvMove != NO_MOVE ? pvMove : hashMove, self->killers[ ply ], counterMove, &self->history, inCheck );
+
+    const int originalAlpha = alpha;
+    int bestScore = -INFINITE_SCORE;
+    Move bestMove = NO_MOVE;
+    unsigned int movesSearched = 0;
+    Move quietsTried[ MAX_QUIETS_TRIED ];
+    unsigned int quietCount = 0;
+    Undo undo;
+
+    Move move;
+    while ( ( move = MovePicker_next( &movePicker ) ) != NO_MOVE )
+    {
+        // Moves at the root that already have a line of their own are left for the next best, and those that the
+        // tablebases have ruled out aren't searched at all
+        if ( ply == 0 && ( ( self->lineIndex > 0 && Search_isEarlierLine( self, move ) ) || !Search_isRootMove( self, move ) ) )
+        {
+            continue;
+        }
+
+        const bool quiet = Board_isQuiet( &self->board, move );
+        const int history = self->history.butterfly[ self->board.whiteToMove ? 0 : 1 ][ Move_from( move ) ][ Move_to( move ) ];
+
+        // Moves are ordered best first, so the quiet moves left once plenty have been tried are unlikely
+        // to be any good. There must be one move searched, so as not to mistake this for mate
+        const bool prunable = quiet && !pvNode && !inCheck && movesSearched > 0 && bestScore > -MATE_BOUND;
+
+        if ( prunable &&
+             options->lateMovePruning &&
+             depth <= LATE_MOVE_PRUNING_DEPTH &&
+             quietCount >= (unsigned int) ( LATE_MOVE_PRUNING_BASE + depth * depth ) )
+        {
+            continue;
+        }
+
+        // Still on the best line only if this is its move, which will be the first move if legal
+        self->followPv = pvMove != NO_MOVE && move == pvMove;
+
+        self->moveStack[ ply ] = move;
+        KeyHistory_push( &self->keyHistory, key );
+
+        const unsigned long long nodesBefore = atomic_load_explicit( &self->nodes, memory_order_relaxed );
+
+        Board_makeMove( &self->board, move, &undo );
+
+        // A move that gives check can change things too much to be pruned or reduced
+        const bool givesCheck = Board_isInCheck( &self->board );
+
+        if ( prunable && futile && !givesCheck )
+        {
+            Board_unmakeMove( &self->board, move, &undo );
+            KeyHistory_pop( &self->keyHistory );
+
+            // The move might have scored up to the margin, so don't claim the node is any worse than that
+            if ( staticEval + FUTILITY_MARGIN * depth > bestScore )
+            {
+                bestScore = staticEval + FUTILITY_MARGIN * depth;
+            }
+            continue;
+        }
+
+        // Search moves late in the ordering to less depth, on the grounds that they probably won't beat
+        // alpha. Should one do so after all, search it again to the full depth
+        int reduction = 0;
+        if ( options->lateMoveReductions &&
+             depth >= LATE_MOVE_REDUCTION_DEPTH &&
+             movesSearched >= LATE_MOVE_REDUCTION_MOVES &&
+             quiet &&
+             !inCheck &&
+             !givesCheck )
+        {
+            reduction = reductions[ depth < MAX_PLY ? depth : MAX_PLY - 1 ][ movesSearched < REDUCTION_MOVES ? movesSearched : REDUCTION_MOVES - 1 ];
+            reduction -= history / LATE_MOVE_REDUCTION_HISTORY;
+
+            if ( pvNode )
+            {
+                reduction--;
+            }
+
+            // Always leave at least one ply before the quiescence search
+            if ( reduction > depth - 2 )
+            {
+                reduction = depth - 2;
+            }
+        }
+
+        // Principal variation search. With good move ordering the first move is the best, so only that one
+        // gets a full window. The rest are searched with a window around alpha, which is cheaper and enough
+        // to show that they are worse. Any that turn out to be better are searched again with the full window
+        int score;
+
+        if ( movesSearched == 0 )
+        {
+            score = -Search_negamax( self, depth - 1, ply + 1, -beta, -alpha );
+        }
+        else
+        {
+            bool fullDepth = true;
+
+            if ( reduction > 0 )
+            {
+                score = -Search_negamax( self, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha );
+                fullDepth = score > alpha;
+            }
+
+            if ( fullDepth )
+            {
+                score = -Search_negamax( self, depth - 1, ply + 1, -alpha - 1, -alpha );
+            }
+
+            if ( pvNode && score > alpha && score < beta )
+            {
+                score = -Search_negamax( self, depth - 1, ply + 1, -beta, -alpha );
+            }
+        }
+
+        Board_unmakeMove( &self->board, move, &undo );
+        KeyHistory_pop( &self->keyHistory );
+
+        self->followPv = false;
+        movesSearched++;
+
+        if ( self->stopped )
+        {
+            return 0;
+        }
+
+        if ( score > bestScore )
+        {
+            bestScore = score;
+            bestMove = move;
+
+            // For the time manager, which wants to know how much of the effort went on the best move
+            if ( ply == 0 && self->lineIndex == 0 )
+            {
+                self->bestMoveNodes = atomic_load_explicit( &self->nodes, memory_order_relaxed ) - nodesBefore;
+            }
+
+            if ( score > alpha )
+            {
+                alpha = score;
+                Search_updatePv( self, ply, move );
+
+                if ( alpha >= beta )
+                {
+                    if ( quiet )
+                    {
+                        Search_updateQuietHistory( self, depth, ply, move, quietsTried, quietCount );
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        if ( quiet && quietCount < MAX_QUIETS_TRIED )
+        {
+            quietsTried[ quietCount++ ] = move;
+        }
+    }
+
+    if ( movesSearched == 0 )
+    {
+        // Checkmate, scored so as to prefer the quickest mate, or stalemate
+        return inCheck ? -MATE_SCORE + ply : 0;
+    }
+
+    // The root of a search for a line other than the first left out the best moves, so its result is not
+    // one for the position
+    if ( ply > 0 || self->lineIndex == 0 )
+    {
+        const enum Bound bound = bestScore >= beta ? BOUND_LOWER : bestScore > originalAlpha ? BOUND_EXACT : BOUND_UPPER;
+        TranspositionTable_store( self->transpositionTable, key, bestMove, Search_scoreToTable( bestScore, ply ), depth, bound );
+    }
+
+    return bestScore;
+}
+
+bool Search_isEarlierLine( Search* self, Move move )
+{
+    for ( unsigned int loop = 0; loop < self->lineIndex; loop++ )
+    {
+        if ( self->lines[ loop ].moves[ 0 ] == move )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool Search_isRootMove( Search* self, Move move )
+{
+    for ( unsigned int loop = 0; loop < self->rootMoves.count; loop++ )
+    {
+        if ( self->rootMoves.moves[ loop ] == move )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool Search_probeTablebases( Search* self, int depth, int ply, int alpha, int beta, int* score )
+{
+    // The tables only hold positions without castling rights, and say nothing about how close the fifty move rule
+    // is, so they are only asked right after a capture or pawn move. Those with as many pieces as the largest
+    // tables in use are the slowest to look up, so are left alone close to the leaves
+    const int pieceCount = (int) __popcnt64( self->board.whitePieces.bbAll | self->board.blackPieces.bbAll );
+
+    if ( self->probeLimit == 0 ||
+         self->board.halfmoveClock != 0 ||
+         Board_castlingRights( &self->board ) != 0 ||
+         pieceCount > self->probeLimit ||
+         ( pieceCount == self->probeLimit && depth < self->options->syzygyProbeDepth ) )
+    {
+        return false;
+    }
+
+    bool success;
+    const int wdl = Syzygy_probeWdl( self->tablebases, &self->board, &success );
+
+    if ( !success )
+    {
+        return false;
+    }
+
+    atomic_store_explicit( &self->tbHits, atomic_load_explicit( &self->tbHits, memory_order_relaxed ) + 1, memory_order_relaxed );
+
+    // A win is scored like a mate that is further away than any the search can find. Results that the fifty move
+    // rule turns into draws are scored just either side of one, so that the search still makes the most of them
+    const int tablebaseScore = wdl == SYZYGY_WIN ? TB_WIN_SCORE - ply : wdl == SYZYGY_LOSS ? -TB_WIN_SCORE + ply : wdl;
+    const enum Bound bound = wdl == SYZYGY_WIN ? BOUND_LOWER : wdl == SYZYGY_LOSS ? BOUND_UPPER : BOUND_EXACT;
+
+    if ( bound == BOUND_EXACT ||
+         ( bound == BOUND_LOWER && tablebaseScore >= beta ) ||
+         ( bound == BOUND_UPPER && tablebaseScore <= alpha ) )
+    {
+        const int tableDepth = depth + TABLEBASE_DEPTH_BONUS < MAX_PLY - 1 ? depth + TABLEBASE_DEPTH_BONUS : MAX_PLY - 1;
+
+        TranspositionTable_store( self->transpositionTable, self->board.key, NO_MOVE, Search_scoreToTable( tablebaseScore, ply ), tableDepth, bound );
+
+        *score = tablebaseScore;
+        return true;
+    }
+
+    return false;
+}
+
+void Search_updateQuietHistory( Search* self, int depth, int ply, Move move, const Move* quietsTried, unsigned int quietCount )
+{
+    // A quiet move good enough to cut off here may well do the same in sibling positions
+    if ( self->killers[ ply ][ 0 ] != move )
+    {
+        self->killers[ ply ][ 1 ] = self->killers[ ply ][ 0 ];
+        self->killers[ ply ][ 0 ] = move;
+    }
+
+    // Cutoffs found by deeper searches say more, and are rarer, so count for more. The quiet moves
+    // tried before this one wasted the effort of searching them, and are marked down by as much
+    const int bonus = depth * depth < HISTORY_BONUS_LIMIT ? depth * depth : HISTORY_BONUS_LIMIT;
+    const bool whiteToMove = self->board.whiteToMove;
+
+    MoveHistory_update( &self->history, whiteToMove, move, bonus );
+
+    for ( unsigned int loop = 0; loop < quietCount; loop++ )
+    {
+        MoveHistory_update( &self->history, whiteToMove, quietsTried[ loop ], -bonus );
+    }
+
+    if ( ply > 0 && self->moveStack[ ply - 1 ] != NO_MOVE )
+    {
+        const unsigned long previousTo = Move_to( self->moveStack[ ply - 1 ] );
+        self->history.counterMoves[ self->board.squares[ previousTo ] ][ previousTo ] = move;
+    }
+}
+
+int Search_quiescence( Search* self, int ply, int alpha, int beta )
+{
+    self->pvLength[ ply ] = ply;
+    Search_countNode( self );
+
+    if ( Search_checkLimits( self ) )
+    {
+        return 0;
+    }
+
+    if ( ply >= MAX_PLY - 1 )
+    {
+        return Search_evaluate( self );
+    }
+
+    const bool inCheck = Board_isInCheck( &self->board );
+
+    // In check, standing pat is not an option and every evasion has to be looked at, quiet or not.
+    // Otherwise, assume that the side to move can do at least as well as the evaluation by declining
+    // to capture
+    int bestScore = -INFINITE_SCORE;
+
+    if ( !inCheck )
+    {
+        bestScore = Search_evaluate( self );
+
+        if ( bestScore >= beta )
+        {
+            return bestScore;
+        }
+
+        if ( bestScore > alpha )
+        {
+            alpha = bestScore;
+        }
+    }
+
+    MovePicker movePicker;
+    MovePicker_initializeQuiescence( &movePicker, &self->board, inCheck );
+
+    unsigned int movesSearched = 0;
+    Undo undo;
+
+    Move move;
+    while ( ( move = MovePicker_next( &movePicker ) ) != NO_MOVE )
+    {
+        Board_makeMove( &self->board, move, &undo );
+        const int score = -Search_quiescence( self, ply + 1, -beta, -alpha );
+        Board_unmakeMove( &self->board, move, &undo );
+
+        movesSearched++;
+
+        if ( self->stopped )
+        {
+            return 0;
+        }
+
+        if ( score > bestScore )
+        {
+            bestScore = score;
+
+            if ( score > alpha )
+            {
+                alpha = score;
+                Search_updatePv( self, ply, move );
+
+                if ( alpha >= beta )
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    if ( inCheck && movesSearched == 0 )
+    {
+        return -MATE_SCORE + ply;
+    }
+
+    return bestScore;
+}
+
+void Search_updatePv( Search* self, int ply, Move move )
+{
+    // This move, followed by the best line from the position after it
+    self->pvTable[ ply ][ ply ] = move;
+    for ( int next = ply + 1; next < self->pvLength[ ply + 1 ]; next++ )
+    {
+        self->pvTable[ ply ][ next ] = self->pvTable[ ply + 1 ][ next ];
+    }
+    self->pvLength[ ply ] = self->pvLength[ ply + 1 ];
+}
+
+int Search_evaluate( Search* self )
+{
+    if ( self->network != NULL && self->network->loaded )
+    {
+        return Nnue_evaluate( self->network, &self->board, &self->accumulator );
+    }
+
+    return Evaluation_evaluate( &self->board, self->pawnTable, self->materialTable );
+}
+
+int Search_nonPawnMaterial( Board* board )
+{
+    const PieceList* pieces = board->whiteToMove ? &board->whitePieces : &board->blackPieces;
+
+    return pieceValues[ KNIGHT ] * (int) __popcnt64( pieces->bbKnight ) +
+           pieceValues[ BISHOP ] * (int) __popcnt64( pieces->bbBishop ) +
+           pieceValues[ ROOK ] * (int) __popcnt64( pieces->bbRook ) +
+           pieceValues[ QUEEN ] * (int) __popcnt64( pieces->bbQueen );
+}
+
+void Search_initializeReductions()
+{
+    if ( reductionsInitialized )
+    {
+        return;
+    }
+
+    // Grows slowly with both the depth and how far down the move list we are
+    for ( int depth = 0; depth < MAX_PLY; depth++ )
+    {
+        for ( int moves = 0; moves < REDUCTION_MOVES; moves++ )
+        {
+            reductions[ depth ][ moves ] = depth > 0 && moves > 0 ? (int) ( 0.75 + log( depth ) * log( moves ) / 2.25 ) : 0;
+        }
+    }
+
+    reductionsInitialized = true;
+}
+
+int Search_scoreToTable( int score, int ply )
+{
+    // Mate scores, and tablebase wins that count down in the same way, are relative to the root but the table
+    // needs them relative to the position stored, as the same position can be reached at different plies
+    if ( score > TB_WIN_BOUND )
+    {
+        return score + ply;
+    }
+    else if ( score < -TB_WIN_BOUND )
+    {
+        return score - ply;
+    }
+
+    return score;
+}
+
+int Search_scoreFromTable( int score, int ply )
+{
+    if ( score > TB_WIN_BOUND )
+    {
+        return score - ply;
+    }
+    else if ( score < -TB_WIN_BOUND )
+    {
+        return score + ply;
+    }
+
+    return score;
+}
+
+void Search_countNode( Search* self )
+{
+    // Only this thread writes the count, so it needs no locked increment, just a store that others can read whole
+    atomic_store_explicit( &self->nodes, atomic_load_explicit( &self->nodes, memory_order_relaxed ) + 1, memory_order_relaxed );
+}
+
+bool Search_checkLimits( Search* self )
+{
+    if ( self->stopped )
+    {
+        return true;
+    }
+
+    if ( atomic_load_explicit( self->shared->stop, memory_order_relaxed ) )
+    {
+        self->stopped = true;
+        return true;
+    }
+
+    // The limits are the main thread's business. The helpers stop when it tells them to
+    if ( self->threadIndex > 0 )
+    {
+        return false;
+    }
+
+    // Pondering is on the opponent's time, so there are no limits until ponderhit, when our clock starts
+    if ( self->pondering )
+    {
+        if ( atomic_load_explicit( &self->limits->ponder, memory_order_relaxed ) )
+        {
+            return false;
+        }
+
+        self->pondering = false;
+        self->clockStartTime = wallClockMilliseconds();
+    }
+
+    const unsigned long long nodes = atomic_load_explicit( &self->nodes, memory_order_relaxed );
+
+    if ( self->limits->nodes > 0 )
+    {
+        // Exact when searching alone, otherwise added up across the threads now and again
+        if ( self->shared->threadCount == 1 )
+        {
+            self->stopped = nodes >= self->limits->nodes;
+        }
+        else if ( ( nodes & ( TIME_CHECK_INTERVAL - 1 ) ) == 0 )
+        {
+            self->stopped = Search_totalNodes( self ) >= self->limits->nodes;
+        }
+    }
+
+    if ( !self->stopped && ( nodes & ( TIME_CHECK_INTERVAL - 1 ) ) == 0 )
+    {
+        self->stopped = TimeManager_isHardLimitReached( &self->timeManager, wallClockMilliseconds() - self->clockStartTime );
+    }
+
+    if ( self->stopped )
+    {
+        atomic_store_explicit( self->shared->stop, true, memory_order_relaxed );
+    }
+
+    return self->stopped;
+}
+
+void Search_keepLine( Search* self, int score )
+{
+    struct SearchLine* line = &self->lines[ self->lineIndex ];
+
+    line->score = score;
+    line->length = self->pvLength[ 0 ];
+    memcpy( line->moves, self->pvTable[ 0 ], line->length * sizeof( Move ) );
+}
+
+void Search_sortLines( Search* self )
+{
+    // A line can come out better than those before it when the search of those missed something. Keep
+    // lines with equal scores in the order they were found
+    for ( unsigned int loop = 1; loop < self->lineCount; loop++ )
+    {
+        struct SearchLine line = self->lines[ loop ];
+        unsigned int index = loop;
+
+        while ( index > 0 && self->lines[ index - 1 ].score < line.score )
+        {
+            self->lines[ index ] = self->lines[ index - 1 ];
+            index--;
+        }
+
+        self->lines[ index ] = line;
+    }
+}
+
+void Search_reportIteration( Search* self, int depth, unsigned int lineIndex, int score, enum Bound bound )
+{
+    const unsigned long long elapsed = wallClockMilliseconds() - self->startTime;
+    const unsigned long long nodes = Search_totalNodes( self );
+    const unsigned long long nps = elapsed > 0 ? nodes * 1000 / elapsed : 0;
+
+    char scoreString[ 40 ];
+    if ( score > MATE_BOUND )
+    {
+        sprintf_s( scoreString, sizeof( scoreString ), "mate %d", ( MATE_SCORE - score + 1 ) / 2 );
+    }
+    else if ( score < -MATE_BOUND )
+    {
+        sprintf_s( scoreString, sizeof( scoreString ), "mate %d", -( MATE_SCORE + score ) / 2 );
+    }
+    else
+    {
+        sprintf_s( scoreString, sizeof( scoreString ), "cp %d", score );
+    }
+
+    if ( bound == BOUND_LOWER )
+    {
+        strcat_s( scoreString, sizeof( scoreString ), " lowerbound" );
+    }
+    else if ( bound == BOUND_UPPER )
+    {
+        strcat_s( scoreString, sizeof( scoreString ), " upperbound" );
+    }
+
+    // A search that failed low found no move to put in its line, so this is the one it is re-searching
+    const Move* line = self->lines[ lineIndex ].moves;
+    const int lineLength = self->lines[ lineIndex ].length;
+
+    char pvString[ MAX_PLY * 6 + 1 ] = "";
+    char moveString[ 10 ];
+    for ( int loop = 0; loop < lineLength; loop++ )
+    {
+        Board_exportMove( line[ loop ], moveString );
+        if ( loop > 0 )
+        {
+            strcat_s( pvString, sizeof( pvString ), " " );
+        }
+        strcat_s( pvString, sizeof( pvString ), moveString );
+    }
+
+    UCI_broadcast( self->runtimeSetup, "info depth %d multipv %u score %s nodes %llu nps %llu hashfull %d tbhits %llu time %llu pv %s",
+                   depth,
+                   lineIndex + 1,
+                   scoreString,
+                   nodes,
+                   nps,
+                   TranspositionTable_hashfull( self->transpositionTable ),
+                   Search_totalTbHits( self ),
+                   elapsed,
+                   pvString );
+}
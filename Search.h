@@ -0,0 +1,233 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "Board.h"
+#include "MaterialTable.h"
+#include "MovePicker.h"
+#include "Nnue.h"
+#include "PawnTable.h"
+#include "RuntimeSetup.h"
+#include "Syzygy.h"
+#include "TimeManager.h"
+#include "TranspositionTable.h"
+
+// The deepest the search can go, and so the size of the principal variation table
+#define MAX_PLY 128
+
+// Scores are in centipawns from the point of view of the side to move. Mate scores count down from
+// MATE_SCORE by the number of plies to the mate so that shorter mates are preferred
+#define INFINITE_SCORE 32000
+#define MATE_SCORE 31000
+#define MATE_BOUND ( MATE_SCORE - MAX_PLY )
+
+// Positions won according to the tablebases score below any mate, counting down by ply in the same way, so
+// that a known mate is still preferred and a win is converted by the quickest way into the tables
+#define TB_WIN_SCORE ( MATE_BOUND - 1 )
+#define TB_WIN_BOUND ( TB_WIN_SCORE - MAX_PLY )
+
+// Limits for the Threads option
+#define SEARCH_DEFAULT_THREADS 1
+#define SEARCH_MAXIMUM_THREADS 256
+
+// Limits for the MultiPV option
+#define SEARCH_DEFAULT_MULTI_PV 1
+#define SEARCH_MAXIMUM_MULTI_PV 64
+
+/// <summary>
+/// The limits passed with the go command. Zero means no limit
+/// </summary>
+struct SearchLimits
+{
+    int depth;
+    unsigned long long nodes;
+    unsigned long long movetime;
+    unsigned long long wtime;
+    unsigned long long btime;
+    unsigned long long winc;
+    unsigned long long binc;
+    int movestogo;
+    bool infinite;
+
+    // Searching the position after the move we expect the opponent to make, on their time. The search
+    // has no limits until ponderhit clears this, while it runs, to say that the move was made
+    atomic_bool ponder;
+};
+
+/// <summary>
+/// Settings for the search that come from UCI options and so last from one go to the next
+/// </summary>
+struct SearchOptions
+{
+    // How many threads to search with. All but the first are Lazy SMP helpers, searching the same
+    // position and sharing what they find through the transposition table
+    unsigned int threads;
+
+    // How many of the best moves to find a line and score for, rather than just the best
+    unsigned int multiPv;
+
+    // Milliseconds lost to communication with the GUI on each move, to be kept back from the clock
+    unsigned long long moveOverhead;
+
+    // The selective parts of the search, each of which can be turned off to measure what it is worth
+    bool nullMovePruning;
+    bool lateMoveReductions;
+    bool reverseFutilityPruning;
+    bool futilityPruning;
+    bool lateMovePruning;
+
+    // Tablebases are probed in the search for positions with no more than syzygyProbeLimit pieces, and for those
+    // with exactly that many only this far from the leaves or more
+    int syzygyProbeDepth;
+    int syzygyProbeLimit;
+};
+
+/// <summary>
+/// One of the lines found from the root, with its score
+/// </summary>
+struct SearchLine
+{
+    int score;
+    int length;
+    Move moves[ MAX_PLY ];
+};
+
+struct SearchShared;
+
+/// <summary>
+/// The state of one thread's search in progress
+/// </summary>
+typedef struct
+{
+    Board board;
+
+    // The positions before the one on the board, from the game and then the search
+    KeyHistory keyHistory;
+
+    struct RuntimeSetup* runtimeSetup;
+    const struct SearchLimits* limits;
+    const struct SearchOptions* options;
+    struct TranspositionTable* transpositionTable;
+    struct PawnTable* pawnTable;
+    struct MaterialTable* materialTable;
+
+    // Evaluates in place of the hand written evaluation when loaded. The accumulator follows this thread's board
+    const struct Nnue* network;
+    NnueAccumulator accumulator;
+
+    // The endgame tablebases, and the most pieces a position can have for them to be probed. Zero once the root
+    // moves have been chosen from them, as the search can then only find the same result, unless it still has to
+    // find the way to a win
+    const struct Syzygy* tablebases;
+    int probeLimit;
+
+    // The root moves to search, which the tablebases may have narrowed down
+    MoveList rootMoves;
+
+    // What this thread has in common with the others searching alongside it
+    struct SearchShared* shared;
+    unsigned int threadIndex;
+
+    // Read by the main thread while this thread writes it, when adding up the node count. Only this thread
+    // writes them, so they are counted up with a relaxed load and store rather than a locked increment
+    atomic_ullong nodes;
+    atomic_ullong tbHits;
+    unsigned long long startTime;
+
+    // When our clock started, which is later than the start of the search if it began by pondering
+    unsigned long long clockStartTime;
+    bool pondering;
+
+    // How long to spend on this move. Only the main thread keeps time
+    struct TimeManager timeManager;
+
+    // The nodes spent on the current best move at the root in this iteration
+    unsigned long long bestMoveNodes;
+
+    bool stopped;
+
+    // The best lines from the root, best first, with the best move being the first move of lines[ 0 ]. Each
+    // iteration searches lineCount of them, one after another, leaving out the first moves of those already
+    // found. Until a line is replaced by the current iteration's, it holds the last iteration's
+    struct SearchLine lines[ SEARCH_MAXIMUM_MULTI_PV ];
+    unsigned int lineCount;
+    unsigned int lineIndex;
+
+    // While true, the first moves searched are those from the line being searched
+    bool followPv;
+
+    // Quiet moves that most recently caused a cutoff at each ply
+    Move killers[ MAX_PLY ][ KILLER_MOVES ];
+
+    // Which quiet moves have been causing cutoffs anywhere in the tree, and in reply to what
+    MoveHistory history;
+
+    // The move made at each ply on the way to the position being searched, with NO_MOVE for a null move
+    Move moveStack[ MAX_PLY ];
+
+    // No null moves before this ply, while verifying a null move cutoff
+    int nullMoveMinimumPly;
+
+    // Triangular table of principal variations. Row [ply] holds the best line found from that ply,
+    // from pvTable[ ply ][ ply ] to pvTable[ ply ][ pvLength[ ply ] - 1 ]
+    int pvLength[ MAX_PLY ];
+    Move pvTable[ MAX_PLY ][ MAX_PLY ];
+} Search;
+
+/// <summary>
+/// The threads taking part in one search
+/// </summary>
+struct SearchShared
+{
+    Search* threads;
+    unsigned int threadCount;
+
+    // Set by the main thread to tell the helpers to finish, or from outside the search to tell them all
+    atomic_bool* stop;
+};
+
+// Public methods
+
+void SearchLimits_initialize( struct SearchLimits* limits );
+void SearchOptions_initialize( struct SearchOptions* options );
+
+/// <summary>
+/// Search the position to the given limits, reporting progress with info lines and finishing with bestmove
+/// </summary>
+/// <param name="runtimeSetup">for output</param>
+/// <param name="board">the position to search, which is not modified</param>
+/// <param name="keyHistory">the positions of the game before this one, for spotting repetitions</param>
+/// <param name="limits">when to stop</param>
+/// <param name="options">how to search</param>
+/// <param name="transpositionTable">the table to use, and to keep results in for later searches</param>
+/// <param name="pawnTable">the table of pawn structure evaluations, kept in the same way</param>
+/// <param name="materialTable">the table of material balances, also kept</param>
+/// <param name="network">the network to evaluate with, if it is loaded</param>
+/// <param name="tablebases">the endgame tablebases, which may have none loaded</param>
+/// <param name="stop">set this from another thread to finish the search early. Must be false to begin with</param>
+/// <returns>the best move found, or NO_MOVE if there are no legal moves</returns>
+Move Search_start( struct RuntimeSetup* runtimeSetup, Board* board, const KeyHistory* keyHistory, const struct SearchLimits* limits, const struct SearchOptions* options, struct TranspositionTable* transpositionTable, struct PawnTable* pawnTable, struct MaterialTable* materialTable, const struct Nnue* network, const struct Syzygy* tablebases, atomic_bool* stop );
+
+// Internal methods
+
+void Search_iterate( Search* self );
+int Search_worker( void* argument );
+unsigned long long Search_totalNodes( Search* self );
+unsigned long long Search_totalTbHits( Search* self );
+int Search_negamax( Search* self, int depth, int ply, int alpha, int beta );
+bool Search_isEarlierLine( Search* self, Move move );
+bool Search_isRootMove( Search* self, Move move );
+bool Search_probeTablebases( Search* self, int depth, int ply, int alpha, int beta, int* score );
+int Search_quiescence( Search* self, int ply, int alpha, int beta );
+int Search_evaluate( Search* self );
+int Search_nonPawnMaterial( Board* board );
+void Search_initializeReductions();
+void Search_updatePv( Search* self, int ply, Move move );
+void Search_updateQuietHistory( Search* self, int depth, int ply, Move move, const Move* quietsTried, unsigned int quietCount );
+int Search_scoreToTable( int score, int ply );
+int Search_scoreFromTable( int score, int ply );
+void Search_countNode( Search* self );
+bool Search_checkLimits( Search* self );
+void Search_keepLine( Search* self, int score );
+void Search_sortLines( Search* self );
+void Search_reportIteration( Search* self, int depth, unsigned int lineIndex, int score, enum Bound bound );
@@ -0,0 +1,1673 @@
+#include <io.h>
+#include <ctype.h>
+#include <errno.h>
+#include <intrin.h>
+#include <memory.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+// Only the file mapping and folder listing functions are needed
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define NOGDI
+#include <windows.h>
+
+#include "Syzygy.h"
+
+#define LOG_INFO( ... ) { RuntimeSetup_log( runtimeSetup, INFO, __VA_ARGS__ ); }
+#define LOG_WARN( ... ) { RuntimeSetup_log( runtimeSetup, WARN, __VA_ARGS__ ); }
+#define LOG_ERROR( ... ) { RuntimeSetup_log( runtimeSetup, ERROR, __VA_ARGS__ ); }
+
+// The first four bytes of each kind of file
+static const unsigned char wdlMagic[ 4 ] = { 0x71, 0xe8, 0x23, 0x5d };
+static const unsigned char dtzMagic[ 4 ] = { 0xd7, 0x66, 0x0c, 0xa5 };
+
+// Flags at the start of a file
+#define FILE_SPLIT 1
+#define FILE_HAS_PAWNS 2
+
+// Flags for each SyzygyPairs
+#define PAIRS_SIDE_TO_MOVE 1
+#define PAIRS_MAPPED 2
+#define PAIRS_WIN_PLIES 4
+#define PAIRS_LOSS_PLIES 8
+#define PAIRS_WIDE 16
+#define PAIRS_SINGLE_VALUE 128
+
+// Each entry of the sparse index is a 32 bit block and a 16 bit offset into it, and each node of the symbol tree is
+// two 12 bit symbols
+#define SPARSE_ENTRY_SIZE 6
+#define TREE_NODE_SIZE 3
+#define NO_SYMBOL 0xfff
+
+// The ways that the kings can stand, leaving out those that are mirror images of others, and the same for three
+// pieces of different types
+#define KING_PAIRS 462
+#define UNIQUE_TRIPLES 31332
+
+// Table files are a multiple of 64 bytes plus the 16 that pad out the last block
+#define FILE_SIZE_ALIGNMENT 64
+#define FILE_SIZE_REMAINDER 16
+
+// Where the values for each result are in a DTZ table's map, indexed by SyzygyWdl + 2
+static const int dtzMapOrder[ 5 ] = { 1, 3, 0, 2, 0 };
+
+// Root moves are ranked from this for the quickest sure win down to its negation for the quickest loss
+#define SYZYGY_MAXIMUM_RANK 1000
+
+// Piece characters of file names, indexed by ColorlessPiece
+static const char pieceNames[] = " PNBRQK";
+
+// Positions whose results are known, for checking a set of tables with the test command. Each DTZ is exact, as
+// the best move either mates or resets the count at once, other than the KPvK pair where the pawn can only move
+// once the king has. DTZ tables hold one side to move, so one of that pair is found by looking a move ahead
+static const struct
+{
+    const char* fen;
+    int wdl;
+    int dtz;
+} knownPositions[] =
+{
+    { "8/8/8/4k3/8/8/8/4K3 w - - 0 1", SYZYGY_DRAW, 0 },                 // Bare kings
+    { "k7/7Q/1K6/8/8/8/8/8 w - - 0 1", SYZYGY_WIN, 1 },                  // KQvK, Qb7 mates
+    { "k7/8/1K6/8/8/8/8/7R w - - 0 1", SYZYGY_WIN, 1 },                  // KRvK, Rh8 mates
+    { "8/4P3/8/8/8/8/k7/4K3 w - - 0 1", SYZYGY_WIN, 1 },                 // KPvK, e8=Q is safe
+    { "4k3/4P3/4K3/8/8/8/8/8 b - - 0 1", SYZYGY_DRAW, 0 },               // KPvK, stalemate
+    { "4k3/8/4K3/4P3/8/8/8/8 w - - 0 1", SYZYGY_WIN, 3 },                // KPvK, the king on the sixth wins
+    { "4k3/8/4K3/4P3/8/8/8/8 b - - 0 1", SYZYGY_LOSS, -4 },              // KPvK, whoever is to move
+    { "8/8/8/4k3/8/8/8/1NN1K3 w - - 0 1", SYZYGY_DRAW, 0 },              // KNNvK
+    { "n3k3/8/8/8/8/8/8/R3K3 w - - 0 1", SYZYGY_WIN, 1 },                // KRvKN, Rxa8 leaves KRvK
+    { "r3k3/8/8/8/8/8/8/Q3K3 w - - 0 1", SYZYGY_WIN, 1 },                // KQvKR, Qxa8 leaves KQvK
+    { "r3k3/8/8/8/8/8/8/R3K2R w - - 0 1", SYZYGY_WIN, 1 },               // KRRvKR, Rxa8 leaves KRRvK
+    { "4k3/8/8/1n6/8/3B4/8/4K1n1 w - - 0 1", SYZYGY_DRAW, 0 },           // KBvKNN, Bxb5 leaves KBvKN
+};
+
+// Tables for working out the index of a position, filled in on first use. Each maps squares to where they are counted
+// from when pieces are placed in turn, leaving out squares that mirror images make unnecessary
+static int mapPawns[ 64 ];
+static int mapB1H1H7[ 64 ];
+static int mapA1D1D4[ 64 ];
+static int mapKK[ 10 ][ 64 ];
+static unsigned long long binomial[ SYZYGY_MAX_PIECES ][ 64 ];
+static unsigned long long leadPawnIndex[ SYZYGY_MAX_PIECES ][ 64 ];
+static unsigned long long leadPawnsSize[ SYZYGY_MAX_PIECES ][ 4 ];
+static bool indexTablesInitialized = false;
+
+void Syzygy_initialize( struct Syzygy* self )
+{
+    Syzygy_initializeIndexTables();
+
+    self->tables = NULL;
+    self->tableCount = 0;
+    self->largest = 0;
+
+    memset( self->index, 0, sizeof( self->index ) );
+}
+
+void Syzygy_destroy( struct Syzygy* self )
+{
+    for ( unsigned int loop = 0; loop < self->tableCount; loop++ )
+    {
+        SyzygyTable* table = &self->tables[ loop ];
+
+        for ( int file = 0; file < 4; file++ )
+        {
+            free( table->wdl[ 0 ][ file ].symbolLengths );
+            free( table->wdl[ 1 ][ file ].symbolLengths );
+            free( table->dtz[ file ].symbolLengths );
+        }
+
+        Syzygy_unmap( table->wdlFile, table->wdlMapping, table->wdlView );
+        Syzygy_unmap( table->dtzFile, table->dtzMapping, table->dtzView );
+    }
+
+    free( self->tables );
+
+    self->tables = NULL;
+    self->tableCount = 0;
+    self->largest = 0;
+
+    memset( self->index, 0, sizeof( self->index ) );
+}
+
+unsigned int Syzygy_load( struct Syzygy* self, const char* path )
+{
+    Syzygy_destroy( self );
+
+    char* folders = _strdup( path );
+    if ( folders == NULL )
+    {
+        return 0;
+    }
+
+    char* context = NULL;
+    for ( char* folder = strtok_s( folders, ";", &context ); folder != NULL; folder = strtok_s( NULL, ";", &context ) )
+    {
+        char pattern[ MAX_PATH ];
+        sprintf_s( pattern, sizeof( pattern ), "%s\\*.rtbw", folder );
+
+        WIN32_FIND_DATAA found;
+        HANDLE find = FindFirstFileA( pattern, &found );
+        if ( find == INVALID_HANDLE_VALUE )
+        {
+            continue;
+        }
+
+        do
+        {
+            Syzygy_addTable( self, folder, found.cFileName );
+        }
+        while ( FindNextFileA( find, &found ) );
+
+        FindClose( find );
+    }
+
+    free( folders );
+
+    return self->tableCount;
+}
+
+int Syzygy_probeWdl( const struct Syzygy* self, Board* board, bool* success )
+{
+    enum SyzygyState state = SYZYGY_OK;
+    const int wdl = Syzygy_search( self, board, false, &state );
+
+    *success = state != SYZYGY_FAIL;
+
+    return wdl;
+}
+
+int Syzygy_probeDtz( const struct Syzygy* self, Board* board, bool* success )
+{
+    enum SyzygyState state = SYZYGY_OK;
+    const int dtz = Syzygy_probeDtzState( self, board, &state );
+
+    *success = state != SYZYGY_FAIL;
+
+    return dtz;
+}
+
+bool Syzygy_filterRootMoves( const struct Syzygy* self, Board* board, bool repeated, MoveList* moveList, bool* keepProbing )
+{
+    *keepProbing = false;
+
+    if ( self->tableCount == 0 || moveList->count == 0 || Board_castlingRights( board ) != 0 ||
+         (int) __popcnt64( board->whitePieces.bbAll | board->blackPieces.bbAll ) > self->largest )
+    {
+        return false;
+    }
+
+    // The DTZ tables can tell apart the moves that keep a win by how soon they make progress. Without them, the WDL
+    // tables can at least say which moves keep the result
+    int ranks[ 256 ];
+    bool dtz = true;
+
+    if ( !Syzygy_rankByDtz( self, board, repeated, moveList, ranks ) )
+    {
+        dtz = false;
+
+        if ( !Syzygy_rankByWdl( self, board, moveList, ranks ) )
+        {
+            return false;
+        }
+    }
+
+    int bestRank = ranks[ 0 ];
+    for ( unsigned int loop = 1; loop < moveList->count; loop++ )
+    {
+        if ( ranks[ loop ] > bestRank )
+        {
+            bestRank = ranks[ loop ];
+        }
+    }
+
+    unsigned char kept = 0;
+    for ( unsigned int loop = 0; loop < moveList->count; loop++ )
+    {
+        if ( ranks[ loop ] == bestRank )
+        {
+            moveList->moves[ kept++ ] = moveList->moves[ loop ];
+        }
+    }
+
+    moveList->count = kept;
+
+    // Any of the winning moves left keeps the win, but only the search can find the way to convert it. Reaching
+    // smaller tables on the way helps it, so it keeps on probing
+    *keepProbing = !dtz && bestRank > 0;
+
+    return true;
+}
+
+void Syzygy_test( const struct Syzygy* self, struct RuntimeSetup* runtimeSetup )
+{
+    int passed = 0;
+    int failed = 0;
+    int skipped = 0;
+
+    for ( unsigned int loop = 0; loop < sizeof( knownPositions ) / sizeof( knownPositions[ 0 ] ); loop++ )
+    {
+        Board board;
+        Board_create( &board, knownPositions[ loop ].fen );
+
+        bool wdlSuccess;
+        bool dtzSuccess;
+        const int wdl = Syzygy_probeWdl( self, &board, &wdlSuccess );
+        const int dtz = Syzygy_probeDtz( self, &board, &dtzSuccess );
+
+        if ( !wdlSuccess )
+        {
+            LOG_WARN( "Skipped: no tables for %s", knownPositions[ loop ].fen );
+            skipped++;
+            continue;
+        }
+
+        // A DTZ table may give a win or loss as one ply sooner than it is, where that can't cross the fifty move limit
+        const int expectedDtz = knownPositions[ loop ].dtz;
+        const bool dtzMatches = dtz == expectedDtz || ( abs( expectedDtz ) > 1 && dtz == expectedDtz - ( expectedDtz > 0 ? 1 : -1 ) );
+
+        if ( wdl != knownPositions[ loop ].wdl || ( dtzSuccess && !dtzMatches ) )
+        {
+            LOG_ERROR( "Failed: %s gave WDL %d DTZ %d, expected WDL %d DTZ %d", knownPositions[ loop ].fen, wdl, dtz, knownPositions[ loop ].wdl, expectedDtz );
+            failed++;
+        }
+        else if ( dtzSuccess )
+        {
+            LOG_INFO( "Success: %s gave WDL %d DTZ %d", knownPositions[ loop ].fen, wdl, dtz );
+            passed++;
+        }
+        else
+        {
+            LOG_INFO( "Success: %s gave WDL %d, no DTZ table", knownPositions[ loop ].fen, wdl );
+            passed++;
+        }
+    }
+
+    LOG_INFO( "Tablebase test: %d passed, %d failed, %d skipped", passed, failed, skipped );
+}
+
+void Syzygy_initializeIndexTables()
+{
+    if ( indexTablesInitialized )
+    {
+        return;
+    }
+
+    // The squares below the a1-h8 diagonal, as 0 to 27
+    int code = 0;
+    for ( unsigned long square = 0; square < 64; square++ )
+    {
+        if ( Syzygy_offDiagonal( square ) < 0 )
+        {
+            mapB1H1H7[ square ] = code++;
+        }
+    }
+
+    // The squares of the a1-d1-d4 triangle as 0 to 9, with those below the diagonal first
+    unsigned long diagonal[ 4 ];
+    int diagonalCount = 0;
+
+    code = 0;
+    for ( unsigned long square = A1; square <= D4; square++ )
+    {
+        if ( Syzygy_offDiagonal( square ) < 0 && Board_fileFromIndex( square ) <= 3 )
+        {
+            mapA1D1D4[ square ] = code++;
+        }
+        else if ( Syzygy_offDiagonal( square ) == 0 && Board_fileFromIndex( square ) <= 3 )
+        {
+            diagonal[ diagonalCount++ ] = square;
+        }
+    }
+
+    for ( int loop = 0; loop < diagonalCount; loop++ )
+    {
+        mapA1D1D4[ diagonal[ loop ] ] = code++;
+    }
+
+    // The legal placings of two kings with the first in the a1-d1-d4 triangle. With the first king on the diagonal, the
+    // second can't be above it. Those with both on the diagonal come last
+    int bothOnDiagonal[ 64 ][ 2 ];
+    int bothCount = 0;
+
+    code = 0;
+    for ( int index = 0; index < 10; index++ )
+    {
+        for ( unsigned long first = A1; first <= D4; first++ )
+        {
+            // Squares outside the triangle are left mapped to zero, which belongs to b1
+            if ( mapA1D1D4[ first ] != index || ( index == 0 && first != B1 ) )
+            {
+                continue;
+            }
+
+            for ( unsigned long second = 0; second < 64; second++ )
+            {
+                const int rankDistance = abs( (int) Board_rankFromIndex( first ) - (int) Board_rankFromIndex( second ) );
+                const int fileDistance = abs( (int) Board_fileFromIndex( first ) - (int) Board_fileFromIndex( second ) );
+
+                if ( rankDistance <= 1 && fileDistance <= 1 )
+                {
+                    continue;
+                }
+                else if ( Syzygy_offDiagonal( first ) == 0 && Syzygy_offDiagonal( second ) > 0 )
+                {
+                    continue;
+                }
+                else if ( Syzygy_offDiagonal( first ) == 0 && Syzygy_offDiagonal( second ) == 0 )
+                {
+                    bothOnDiagonal[ bothCount ][ 0 ] = index;
+                    bothOnDiagonal[ bothCount ][ 1 ] = second;
+                    bothCount++;
+                }
+                else
+                {
+                    mapKK[ index ][ second ] = code++;
+                }
+            }
+        }
+    }
+
+    for ( int loop = 0; loop < bothCount; loop++ )
+    {
+        mapKK[ bothOnDiagonal[ loop ][ 0 ] ][ bothOnDiagonal[ loop ][ 1 ] ] = code++;
+    }
+
+    // The ways to choose k things from n, by Pascal's rule
+    binomial[ 0 ][ 0 ] = 1;
+
+    for ( int n = 1; n < 64; n++ )
+    {
+        for ( int k = 0; k < SYZYGY_MAX_PIECES && k <= n; k++ )
+        {
+            binomial[ k ][ n ] = ( k > 0 ? binomial[ k - 1 ][ n - 1 ] : 0 ) + ( k < n ? binomial[ k ][ n - 1 ] : 0 );
+        }
+    }
+
+    // The squares a2 to h7 as 47 down to 0, in order of file and then rank from the edges in, so that the pawn with
+    // the highest number is the leading pawn. It is also how many squares are left for the other pawns with the
+    // leading pawn on that square. Then the index of the leading pawns for each file of the leading pawn, with the
+    // leading pawn on each rank
+    int availableSquares = 47;
+
+    for ( int leadPawnCount = 1; leadPawnCount <= SYZYGY_MAX_PIECES - 2; leadPawnCount++ )
+    {
+        for ( unsigned long file = 0; file < 4; file++ )
+        {
+            unsigned long long index = 0;
+
+            for ( unsigned long rank = 1; rank <= 6; rank++ )
+            {
+                const unsigned long square = rank * 8 + file;
+
+                if ( leadPawnCount == 1 )
+                {
+                    mapPawns[ square ] = availableSquares--;
+                    mapPawns[ square ^ 7 ] = availableSquares--;
+                }
+
+                leadPawnIndex[ leadPawnCount ][ square ] = index;
+                index += binomial[ leadPawnCount - 1 ][ mapPawns[ square ] ];
+            }
+
+            leadPawnsSize[ leadPawnCount ][ file ] = index;
+        }
+    }
+
+    indexTablesInitialized = true;
+}
+
+void Syzygy_addTable( struct Syzygy* self, const char* folder, const char* name )
+{
+    int counts[ 2 ][ 7 ];
+    if ( !Syzygy_parseName( name, counts ) )
+    {
+        return;
+    }
+
+    // The same table in more than one folder is only opened once
+    const unsigned long long key = Syzygy_materialKey( counts );
+    if ( Syzygy_find( self, key ) != NULL )
+    {
+        return;
+    }
+
+    SyzygyTable* tables = realloc( self->tables, ( self->tableCount + 1 ) * sizeof( SyzygyTable ) );
+    if ( tables == NULL )
+    {
+        return;
+    }
+
+    self->tables = tables;
+
+    SyzygyTable* table = &self->tables[ self->tableCount ];
+    memset( table, 0, sizeof( SyzygyTable ) );
+
+    int swapped[ 2 ][ 7 ];
+    memcpy( swapped[ 0 ], counts[ 1 ], sizeof( counts[ 1 ] ) );
+    memcpy( swapped[ 1 ], counts[ 0 ], sizeof( counts[ 0 ] ) );
+
+    table->key = key;
+    table->swappedKey = Syzygy_materialKey( swapped );
+
+    for ( int piece = PAWN; piece <= KING; piece++ )
+    {
+        table->pieceCount += counts[ 0 ][ piece ] + counts[ 1 ][ piece ];
+
+        if ( piece != KING && ( counts[ 0 ][ piece ] == 1 || counts[ 1 ][ piece ] == 1 ) )
+        {
+            table->hasUniquePieces = true;
+        }
+    }
+
+    table->hasPawns = counts[ 0 ][ PAWN ] + counts[ 1 ][ PAWN ] > 0;
+
+    // The side with fewer pawns leads, as that compresses better
+    const int leading = counts[ 1 ][ PAWN ] == 0 || ( counts[ 0 ][ PAWN ] > 0 && counts[ 1 ][ PAWN ] >= counts[ 0 ][ PAWN ] ) ? 0 : 1;
+    table->pawnCount[ 0 ] = counts[ leading ][ PAWN ];
+    table->pawnCount[ 1 ] = counts[ 1 - leading ][ PAWN ];
+
+    // Names are only made of letters, so anything more than the length of the folder fits with ease
+    char fileName[ MAX_PATH ];
+    unsigned long long size;
+
+    sprintf_s( fileName, sizeof( fileName ), "%s\\%s", folder, name );
+    table->wdlView = Syzygy_map( fileName, wdlMagic, &table->wdlFile, &table->wdlMapping, &size );
+
+    if ( table->wdlView == NULL || !Syzygy_setup( table, table->wdlView + sizeof( wdlMagic ), table->wdlView + size, false ) )
+    {
+        for ( int file = 0; file < 4; file++ )
+        {
+            free( table->wdl[ 0 ][ file ].symbolLengths );
+            free( table->wdl[ 1 ][ file ].symbolLengths );
+        }
+
+        Syzygy_unmap( table->wdlFile, table->wdlMapping, table->wdlView );
+        return;
+    }
+
+    // The DTZ table is optional, and is only needed at the root
+    fileName[ strlen( fileName ) - 1 ] = 'z';
+    table->dtzView = Syzygy_map( fileName, dtzMagic, &table->dtzFile, &table->dtzMapping, &size );
+
+    table->hasDtz = table->dtzView != NULL && Syzygy_setup( table, table->dtzView + sizeof( dtzMagic ), table->dtzView + size, true );
+
+    if ( !table->hasDtz )
+    {
+        for ( int file = 0; file < 4; file++ )
+        {
+            free( table->dtz[ file ].symbolLengths );
+            table->dtz[ file ].symbolLengths = NULL;
+        }
+
+        Syzygy_unmap( table->dtzFile, table->dtzMapping, table->dtzView );
+
+        table->dtzFile = NULL;
+        table->dtzMapping = NULL;
+        table->dtzView = NULL;
+    }
+
+    self->tableCount++;
+
+    if ( table->pieceCount > self->largest )
+    {
+        self->largest = table->pieceCount;
+    }
+
+    // Either key finds the table. The index is big enough never to fill up
+    const unsigned long long keys[ 2 ] = { table->key, table->swappedKey };
+
+    for ( int loop = 0; loop < 2; loop++ )
+    {
+        unsigned int slot = (unsigned int) ( ( keys[ loop ] * 0x9e3779b97f4a7c15ull ) >> 51 ) & ( SYZYGY_INDEX_SIZE - 1 );
+
+        while ( self->index[ slot ] != 0 && self->tables[ self->index[ slot ] - 1 ].key != keys[ loop ] && self->tables[ self->index[ slot ] - 1 ].swappedKey != keys[ loop ] )
+        {
+            slot = ( slot + 1 ) & ( SYZYGY_INDEX_SIZE - 1 );
+        }
+
+        self->index[ slot ] = (unsigned short) self->tableCount;
+    }
+}
+
+bool Syzygy_parseName( const char* name, int counts[ 2 ][ 7 ] )
+{
+    // Such as KRPvKR.rtbw, with white's pieces first
+    memset( counts, 0, 2 * 7 * sizeof( int ) );
+
+    int side = 0;
+    int pieces = 0;
+    const char* character;
+
+    for ( character = name; *character != '\0' && *character != '.'; character++ )
+    {
+        if ( *character == 'v' && side == 0 )
+        {
+            side = 1;
+            continue;
+        }
+
+        const char* piece = *character == ' ' ? NULL : strchr( pieceNames, *character );
+        if ( piece == NULL )
+        {
+            return false;
+        }
+
+        counts[ side ][ piece - pieceNames ]++;
+        pieces++;
+    }
+
+    return _stricmp( character, ".rtbw" ) == 0 &&
+           side == 1 &&
+           counts[ 0 ][ KING ] == 1 &&
+           counts[ 1 ][ KING ] == 1 &&
+           pieces <= SYZYGY_MAX_PIECES;
+}
+
+const unsigned char* Syzygy_map( const char* fileName, const unsigned char* magic, void** file, void** mapping, unsigned long long* size )
+{
+    *file = NULL;
+    *mapping = NULL;
+
+    HANDLE handle = CreateFileA( fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if ( handle == INVALID_HANDLE_VALUE )
+    {
+        return NULL;
+    }
+
+    *file = handle;
+
+    LARGE_INTEGER fileSize;
+    if ( !GetFileSizeEx( handle, &fileSize ) || fileSize.QuadPart % FILE_SIZE_ALIGNMENT != FILE_SIZE_REMAINDER )
+    {
+        Syzygy_unmap( *file, NULL, NULL );
+        *file = NULL;
+        return NULL;
+    }
+
+    *size = fileSize.QuadPart;
+
+    // Nothing is read until it is touched, and the pages are shared with anything else that has the file open
+    *mapping = CreateFileMappingA( handle, NULL, PAGE_READONLY, 0, 0, NULL );
+
+    const unsigned char* view = *mapping != NULL ? MapViewOfFile( *mapping, FILE_MAP_READ, 0, 0, 0 ) : NULL;
+
+    if ( view == NULL || memcmp( view, magic, 4 ) != 0 )
+    {
+        Syzygy_unmap( *file, *mapping, view );
+        *file = NULL;
+        *mapping = NULL;
+        return NULL;
+    }
+
+    return view;
+}
+
+void Syzygy_unmap( void* file, void* mapping, const unsigned char* view )
+{
+    if ( view != NULL )
+    {
+        UnmapViewOfFile( view );
+    }
+
+    if ( mapping != NULL )
+    {
+        CloseHandle( mapping );
+    }
+
+    if ( file != NULL )
+    {
+        CloseHandle( file );
+    }
+}
+
+bool Syzygy_setup( SyzygyTable* table, const unsigned char* data, const unsigned char* end, bool dtz )
+{
+    const unsigned char flags = *data++;
+
+    if ( ( ( flags & FILE_HAS_PAWNS ) != 0 ) != table->hasPawns )
+    {
+        return false;
+    }
+
+    // DTZ tables only hold one side to move. WDL tables hold both, unless both sides have the same pieces
+    const int sides = !dtz && table->key != table->swappedKey ? 2 : 1;
+    const int maxFile = table->hasPawns ? 3 : 0;
+    const bool pawnsBothSides = table->hasPawns && table->pawnCount[ 1 ] > 0;
+
+    // The order of the groups and of the pieces, for each file and side
+    for ( int file = 0; file <= maxFile; file++ )
+    {
+        const int order[ 2 ][ 2 ] =
+        {
+            { data[ 0 ] & 0x0f, pawnsBothSides ? data[ 1 ] & 0x0f : 0x0f },
+            { data[ 0 ] >> 4, pawnsBothSides ? data[ 1 ] >> 4 : 0x0f },
+        };
+
+        data += pawnsBothSides ? 2 : 1;
+
+        for ( int piece = 0; piece < table->pieceCount; piece++, data++ )
+        {
+            for ( int side = 0; side < sides; side++ )
+            {
+                SyzygyPairs* pairs = dtz ? &table->dtz[ file ] : &table->wdl[ side ][ file ];
+                pairs->pieces[ piece ] = side == 0 ? data[ 0 ] & 0x0f : data[ 0 ] >> 4;
+            }
+        }
+
+        for ( int side = 0; side < sides; side++ )
+        {
+            if ( order[ side ][ 0 ] >= table->pieceCount || ( pawnsBothSides && order[ side ][ 1 ] >= table->pieceCount ) )
+            {
+                return false;
+            }
+
+            Syzygy_setGroups( table, dtz ? &table->dtz[ file ] : &table->wdl[ side ][ file ], order[ side ], file );
+        }
+    }
+
+    data += (uintptr_t) data & 1;
+
+    for ( int file = 0; file <= maxFile; file++ )
+    {
+        for ( int side = 0; side < sides; side++ )
+        {
+            data = Syzygy_setSizes( dtz ? &table->dtz[ file ] : &table->wdl[ side ][ file ], data );
+
+            if ( data == NULL || data > end )
+            {
+                return false;
+            }
+        }
+    }
+
+    if ( dtz )
+    {
+        data = Syzygy_setDtzMap( table, data, maxFile );
+    }
+
+    for ( int file = 0; file <= maxFile; file++ )
+    {
+        for ( int side = 0; side < sides; side++ )
+        {
+            SyzygyPairs* pairs = dtz ? &table->dtz[ file ] : &table->wdl[ side ][ file ];
+
+            pairs->sparseIndex = data;
+            data += pairs->sparseIndexCount * SPARSE_ENTRY_SIZE;
+        }
+    }
+
+    for ( int file = 0; file <= maxFile; file++ )
+    {
+        for ( int side = 0; side < sides; side++ )
+        {
+            SyzygyPairs* pairs = dtz ? &table->dtz[ file ] : &table->wdl[ side ][ file ];
+
+            pairs->blockLengths = data;
+            data += pairs->blockLengthCount * sizeof( unsigned short );
+        }
+    }
+
+    // Each part's blocks start on a cache line
+    for ( int file = 0; file <= maxFile; file++ )
+    {
+        for ( int side = 0; side < sides; side++ )
+        {
+            SyzygyPairs* pairs = dtz ? &table->dtz[ file ] : &table->wdl[ side ][ file ];
+
+            data = (const unsigned char*) ( ( (uintptr_t) data + 0x3f ) & ~(uintptr_t) 0x3f );
+            pairs->data = data;
+            data += pairs->blockCount * pairs->blockSize;
+        }
+    }
+
+    return data <= end;
+}
+
+void Syzygy_setGroups( const SyzygyTable* table, SyzygyPairs* pairs, const int order[ 2 ], int file )
+{
+    // Runs of the same piece make up a group. Without pawns, the first group is the kings and, if there is a piece
+    // of which there is only one, that piece too. With pawns, it is the leading pawns
+    int groups = 0;
+    int firstLength = table->hasPawns ? 0 : table->hasUniquePieces ? 3 : 2;
+
+    pairs->groupLength[ groups ] = 1;
+
+    for ( int piece = 1; piece < table->pieceCount; piece++ )
+    {
+        if ( --firstLength > 0 || pairs->pieces[ piece ] == pairs->pieces[ piece - 1 ] )
+        {
+            pairs->groupLength[ groups ]++;
+        }
+        else
+        {
+            pairs->groupLength[ ++groups ] = 1;
+        }
+    }
+
+    pairs->groupLength[ ++groups ] = 0;
+
+    // The index is made up of each group's index times the number of ways the groups after it can be placed, with the
+    // groups in the order given by the table. The leading group and any pawns of the other side are placed first
+    // whatever their order, so the squares left for the other groups don't depend on it
+    const bool pawnsBothSides = table->hasPawns && table->pawnCount[ 1 ] > 0;
+    int next = pawnsBothSides ? 2 : 1;
+    int freeSquares = 64 - pairs->groupLength[ 0 ] - ( pawnsBothSides ? pairs->groupLength[ 1 ] : 0 );
+    unsigned long long index = 1;
+
+    for ( int loop = 0; next < groups || loop == order[ 0 ] || loop == order[ 1 ]; loop++ )
+    {
+        if ( loop == order[ 0 ] )
+        {
+            pairs->groupIndex[ 0 ] = index;
+            index *= table->hasPawns ? leadPawnsSize[ pairs->groupLength[ 0 ] ][ file ] : table->hasUniquePieces ? UNIQUE_TRIPLES : KING_PAIRS;
+        }
+        else if ( loop == order[ 1 ] )
+        {
+            pairs->groupIndex[ 1 ] = index;
+            index *= binomial[ pairs->groupLength[ 1 ] ][ 48 - pairs->groupLength[ 0 ] ];
+        }
+        else
+        {
+            pairs->groupIndex[ next ] = index;
+            index *= binomial[ pairs->groupLength[ next ] ][ freeSquares ];
+            freeSquares -= pairs->groupLength[ next++ ];
+        }
+    }
+
+    // The last is the size of the table
+    pairs->groupIndex[ groups ] = index;
+}
+
+const unsigned char* Syzygy_setSizes( SyzygyPairs* pairs, const unsigned char* data )
+{
+    pairs->flags = *data++;
+
+    if ( pairs->flags & PAIRS_SINGLE_VALUE )
+    {
+        pairs->minimumSymbolLength = *data++;
+        return data;
+    }
+
+    int groups = 0;
+    while ( groups < SYZYGY_MAX_PIECES && pairs->groupLength[ groups ] != 0 )
+    {
+        groups++;
+    }
+
+    const unsigned long long tableSize = pairs->groupIndex[ groups ];
+
+    pairs->blockSize = 1ull << data[ 0 ];
+    pairs->span = 1ull << data[ 1 ];
+    pairs->sparseIndexCount = ( tableSize + pairs->span - 1 ) / pairs->span;
+
+    // The block lengths are padded so that the sparse index never points past them
+    const unsigned char padding = data[ 2 ];
+    memcpy( &pairs->blockCount, data + 3, sizeof( unsigned int ) );
+    pairs->blockLengthCount = pairs->blockCount + padding;
+
+    pairs->maximumSymbolLength = data[ 7 ];
+    pairs->minimumSymbolLength = data[ 8 ];
+    data += 9;
+
+    const int lengths = pairs->maximumSymbolLength - pairs->minimumSymbolLength + 1;
+    if ( pairs->minimumSymbolLength == 0 || lengths < 1 || lengths > SYZYGY_MAX_SYMBOL_LENGTHS )
+    {
+        return NULL;
+    }
+
+    // The Huffman code is canonical, with longer codes having lower values, so the lowest symbol of each length is
+    // enough to work out the lowest code of each length
+    pairs->lowestSymbols = data;
+    pairs->base[ lengths - 1 ] = 0;
+
+    for ( int length = lengths - 2; length >= 0; length-- )
+    {
+        unsigned short lowest;
+        unsigned short lowestLonger;
+        memcpy( &lowest, data + length * sizeof( unsigned short ), sizeof( unsigned short ) );
+        memcpy( &lowestLonger, data + ( length + 1 ) * sizeof( unsigned short ), sizeof( unsigned short ) );
+
+        pairs->base[ length ] = ( pairs->base[ length + 1 ] + lowest - lowestLonger ) / 2;
+    }
+
+    for ( int length = 0; length < lengths; length++ )
+    {
+        pairs->base[ length ] <<= 64 - length - pairs->minimumSymbolLength;
+    }
+
+    data += lengths * sizeof( unsigned short );
+
+    unsigned short symbolCount;
+    memcpy( &symbolCount, data, sizeof( unsigned short ) );
+    data += sizeof( unsigned short );
+
+    pairs->symbolCount = symbolCount;
+    pairs->symbolTree = data;
+    pairs->symbolLengths = malloc( symbolCount + 1 );
+
+    bool* visited = calloc( symbolCount + 1, sizeof( bool ) );
+
+    if ( pairs->symbolLengths == NULL || visited == NULL )
+    {
+        free( visited );
+        return NULL;
+    }
+
+    for ( unsigned int symbol = 0; symbol < symbolCount; symbol++ )
+    {
+        if ( !visited[ symbol ] )
+        {
+            pairs->symbolLengths[ symbol ] = Syzygy_setSymbolLength( pairs, symbol, visited );
+        }
+    }
+
+    free( visited );
+
+    // Padded to an even length
+    return data + symbolCount * TREE_NODE_SIZE + ( symbolCount & 1 );
+}
+
+unsigned char Syzygy_setSymbolLength( SyzygyPairs* pairs, unsigned int symbol, bool* visited )
+{
+    // Each symbol is either a value, or stands for a pair of symbols each standing for a run of values. The tree has no
+    // cycles, so a symbol can be marked as visited before its pair is looked at
+    visited[ symbol ] = true;
+
+    const unsigned char* node = pairs->symbolTree + symbol * TREE_NODE_SIZE;
+    const unsigned int right = ( node[ 2 ] << 4 ) | ( node[ 1 ] >> 4 );
+
+    if ( right == NO_SYMBOL )
+    {
+        return 0;
+    }
+
+    const unsigned int left = ( ( node[ 1 ] & 0x0f ) << 8 ) | node[ 0 ];
+
+    // A broken file could point anywhere
+    if ( left >= pairs->symbolCount || right >= pairs->symbolCount )
+    {
+        return 0;
+    }
+
+    if ( !visited[ left ] )
+    {
+        pairs->symbolLengths[ left ] = Syzygy_setSymbolLength( pairs, left, visited );
+    }
+
+    if ( !visited[ right ] )
+    {
+        pairs->symbolLengths[ right ] = Syzygy_setSymbolLength( pairs, right, visited );
+    }
+
+    return (unsigned char) ( pairs->symbolLengths[ left ] + pairs->symbolLengths[ right ] + 1 );
+}
+
+const unsigned char* Syzygy_setDtzMap( SyzygyTable* table, const unsigned char* data, int maxFile )
+{
+    // DTZ values can be stored as indices into a list of the values actually used for each result, which is shared by
+    // all files
+    table->dtzMap = data;
+
+    for ( int file = 0; file <= maxFile; file++ )
+    {
+        SyzygyPairs* pairs = &table->dtz[ file ];
+
+        if ( ( pairs->flags & PAIRS_MAPPED ) == 0 )
+        {
+            continue;
+        }
+
+        if ( pairs->flags & PAIRS_WIDE )
+        {
+            data += (uintptr_t) data & 1;
+
+            for ( int loop = 0; loop < 4; loop++ )
+            {
+                unsigned short length;
+                memcpy( &length, data, sizeof( unsigned short ) );
+
+                pairs->mapIndex[ loop ] = (unsigned short) ( ( data - table->dtzMap ) / sizeof( unsigned short ) + 1 );
+                data += ( length + 1 ) * sizeof( unsigned short );
+            }
+        }
+        else
+        {
+            for ( int loop = 0; loop < 4; loop++ )
+            {
+                pairs->mapIndex[ loop ] = (unsigned short) ( data - table->dtzMap + 1 );
+                data += *data + 1;
+            }
+        }
+    }
+
+    return data + ( (uintptr_t) data & 1 );
+}
+
+unsigned long long Syzygy_materialKey( const int counts[ 2 ][ 7 ] )
+{
+    // Four bits for how many of each piece other than the king, for each side, which is plenty for seven pieces
+    unsigned long long key = 0;
+
+    for ( int side = 0; side < 2; side++ )
+    {
+        for ( int piece = PAWN; piece < KING; piece++ )
+        {
+            key |= (unsigned long long) counts[ side ][ piece ] << ( side * 20 + ( piece - PAWN ) * 4 );
+        }
+    }
+
+    return key;
+}
+
+unsigned long long Syzygy_boardKey( Board* board )
+{
+    const PieceList* sides[ 2 ] = { &board->whitePieces, &board->blackPieces };
+    int counts[ 2 ][ 7 ];
+
+    for ( int side = 0; side < 2; side++ )
+    {
+        counts[ side ][ PAWN ] = (int) __popcnt64( sides[ side ]->bbPawn );
+        counts[ side ][ KNIGHT ] = (int) __popcnt64( sides[ side ]->bbKnight );
+        counts[ side ][ BISHOP ] = (int) __popcnt64( sides[ side ]->bbBishop );
+        counts[ side ][ ROOK ] = (int) __popcnt64( sides[ side ]->bbRook );
+        counts[ side ][ QUEEN ] = (int) __popcnt64( sides[ side ]->bbQueen );
+    }
+
+    return Syzygy_materialKey( counts );
+}
+
+const SyzygyTable* Syzygy_find( const struct Syzygy* self, unsigned long long key )
+{
+    unsigned int slot = (unsigned int) ( ( key * 0x9e3779b97f4a7c15ull ) >> 51 ) & ( SYZYGY_INDEX_SIZE - 1 );
+
+    while ( self->index[ slot ] != 0 )
+    {
+        const SyzygyTable* table = &self->tables[ self->index[ slot ] - 1 ];
+
+        if ( table->key == key || table->swappedKey == key )
+        {
+            return table;
+        }
+
+        slot = ( slot + 1 ) & ( SYZYGY_INDEX_SIZE - 1 );
+    }
+
+    return NULL;
+}
+
+bool Syzygy_rankByDtz( const struct Syzygy* self, Board* board, bool repeated, const MoveList* moveList, int* ranks )
+{
+    // Ranked so that wins that are sure to come before the fifty move rule are all equal. Any that might not get there
+    // in time, because the count is already high or the position has repeated, are ranked by how soon they reset it.
+    // Losses are ranked the other way round, so that we hold out as long as we can
+    for ( unsigned int loop = 0; loop < moveList->count; loop++ )
+    {
+        const Move move = moveList->moves[ loop ];
+        bool success;
+        int dtz;
+
+        Undo undo;
+        Board_makeMove( board, move, &undo );
+
+        // Counted from the root, so a ply more than from the position after the move. After a capture or pawn move the
+        // count starts again, so the result alone says how far it is
+        if ( board->halfmoveClock == 0 )
+        {
+            dtz = Syzygy_dtzBeforeZeroing( -Syzygy_probeWdl( self, board, &success ) );
+        }
+        else
+        {
+            dtz = -Syzygy_probeDtz( self, board, &success );
+            dtz = dtz > 0 ? dtz + 1 : dtz < 0 ? dtz - 1 : 0;
+        }
+
+        // A mate is as soon as a win can come
+        if ( success && dtz == 2 && Syzygy_isMate( board ) )
+        {
+            dtz = 1;
+        }
+
+        Board_unmakeMove( board, move, &undo );
+
+        if ( !success )
+        {
+            return false;
+        }
+
+        const int count = board->halfmoveClock;
+
+        ranks[ loop ] = dtz > 0 ? ( dtz + count <= 99 && !repeated ? SYZYGY_MAXIMUM_RANK : SYZYGY_MAXIMUM_RANK - ( dtz + count ) )
+                      : dtz < 0 ? ( -dtz * 2 + count < 100 ? -SYZYGY_MAXIMUM_RANK : -SYZYGY_MAXIMUM_RANK + ( -dtz + count ) )
+                      : 0;
+    }
+
+    return true;
+}
+
+bool Syzygy_rankByWdl( const struct Syzygy* self, Board* board, const MoveList* moveList, int* ranks )
+{
+    // Results that the fifty move rule decides rank below any that the DTZ tables could rank as a sure win or loss
+    static const int wdlRanks[ 5 ] = { -SYZYGY_MAXIMUM_RANK, -SYZYGY_MAXIMUM_RANK + 101, 0, SYZYGY_MAXIMUM_RANK - 101, SYZYGY_MAXIMUM_RANK };
+
+    for ( unsigned int loop = 0; loop < moveList->count; loop++ )
+    {
+        const Move move = moveList->moves[ loop ];
+        bool success;
+
+        Undo undo;
+        Board_makeMove( board, move, &undo );
+        const int wdl = -Syzygy_probeWdl( self, board, &success );
+        Board_unmakeMove( board, move, &undo );
+
+        if ( !success )
+        {
+            return false;
+        }
+
+        ranks[ loop ] = wdlRanks[ wdl + 2 ];
+    }
+
+    return true;
+}
+
+int Syzygy_search( const struct Syzygy* self, Board* board, bool zeroingMoves, enum SyzygyState* state )
+{
+    // The tables don't hold the results of positions where the side to move has a winning capture, as the search has
+    // to look at the captures anyway, and store whatever compresses best instead. Where a capture draws, a loss may be
+    // stored in the same way. So the best of the captures and the table is the result. DTZ tables also leave out
+    // positions with a winning pawn move, and have no idea of en passant
+    int bestValue = SYZYGY_LOSS;
+    unsigned int moveCount = 0;
+
+    MoveList moveList;
+    moveList.count = 0;
+    Board_generateMoves( board, &moveList );
+
+    for ( unsigned int loop = 0; loop < moveList.count; loop++ )
+    {
+        const Move move = moveList.moves[ loop ];
+
+        if ( !Syzygy_isCapture( board, move ) && ( !zeroingMoves || !Board_isPawn( board->squares[ Move_from( move ) ] ) ) )
+        {
+            continue;
+        }
+
+        moveCount++;
+
+        Undo undo;
+        Board_makeMove( board, move, &undo );
+        const int value = -Syzygy_search( self, board, false, state );
+        Board_unmakeMove( board, move, &undo );
+
+        if ( *state == SYZYGY_FAIL )
+        {
+            return SYZYGY_DRAW;
+        }
+
+        if ( value > bestValue )
+        {
+            bestValue = value;
+
+            if ( value >= SYZYGY_WIN )
+            {
+                *state = SYZYGY_ZEROING_BEST_MOVE;
+                return value;
+            }
+        }
+    }
+
+    // Having looked at every move, the table has nothing to add, and could be wrong if the position had en passant
+    const bool noMoreMoves = moveCount > 0 && moveCount == moveList.count;
+    int value;
+
+    if ( noMoreMoves )
+    {
+        value = bestValue;
+    }
+    else
+    {
+        value = Syzygy_probeTable( self, board, false, SYZYGY_DRAW, state );
+
+        if ( *state == SYZYGY_FAIL )
+        {
+            return SYZYGY_DRAW;
+        }
+    }
+
+    if ( bestValue >= value )
+    {
+        *state = bestValue > SYZYGY_DRAW || noMoreMoves ? SYZYGY_ZEROING_BEST_MOVE : SYZYGY_OK;
+        return bestValue;
+    }
+
+    *state = SYZYGY_OK;
+    return value;
+}
+
+int Syzygy_probeDtzState( const struct Syzygy* self, Board* board, enum SyzygyState* state )
+{
+    const int wdl = Syzygy_search( self, board, true, state );
+
+    // Draws aren't stored
+    if ( *state == SYZYGY_FAIL || wdl == SYZYGY_DRAW )
+    {
+        return 0;
+    }
+
+    // The table has nothing useful for a position whose best move resets the count, but then it's known anyway
+    if ( *state == SYZYGY_ZEROING_BEST_MOVE )
+    {
+        return Syzygy_dtzBeforeZeroing( wdl );
+    }
+
+    int dtz = Syzygy_probeTable( self, board, true, wdl, state );
+
+    if ( *state == SYZYGY_FAIL )
+    {
+        return 0;
+    }
+
+    // Wins and losses past the fifty move rule count on from 100
+    if ( *state != SYZYGY_CHANGE_SIDE )
+    {
+        return ( dtz + ( wdl == SYZYGY_BLESSED_LOSS || wdl == SYZYGY_CURSED_WIN ? 100 : 0 ) ) * ( wdl > 0 ? 1 : -1 );
+    }
+
+    // The table is for the other side to move, so look a ply ahead for the move that resets the count soonest
+    int minimumDtz = 0xffff;
+
+    MoveList moveList;
+    moveList.count = 0;
+    Board_generateMoves( board, &moveList );
+
+    for ( unsigned int loop = 0; loop < moveList.count; loop++ )
+    {
+        const Move move = moveList.moves[ loop ];
+        const bool zeroing = Syzygy_isCapture( board, move ) || Board_isPawn( board->squares[ Move_from( move ) ] );
+
+        Undo undo;
+        Board_makeMove( board, move, &undo );
+
+        // After a move that resets the count, what matters is the result, and the count is then from before the move.
+        // Otherwise it's a ply more than the count after the move
+        dtz = zeroing ? -Syzygy_dtzBeforeZeroing( Syzygy_search( self, board, false, state ) ) : -Syzygy_probeDtzState( self, board, state );
+
+        if ( dtz == 1 && Syzygy_isMate( board ) )
+        {
+            minimumDtz = 1;
+        }
+
+        if ( !zeroing )
+        {
+            dtz += dtz > 0 ? 1 : dtz < 0 ? -1 : 0;
+        }
+
+        // Leave out draws, and moves that lose when we could win
+        if ( dtz < minimumDtz && ( dtz > 0 ) == ( wdl > 0 ) && dtz != 0 )
+        {
+            minimumDtz = dtz;
+        }
+
+        Board_unmakeMove( board, move, &undo );
+
+        if ( *state == SYZYGY_FAIL )
+        {
+            return 0;
+        }
+    }
+
+    // No legal moves is mate
+    return minimumDtz == 0xffff ? -1 : minimumDtz;
+}
+
+int Syzygy_probeTable( const struct Syzygy* self, Board* board, bool dtz, int wdl, enum SyzygyState* state )
+{
+    // There is no table for two bare kings
+    if ( __popcnt64( board->whitePieces.bbAll | board->blackPieces.bbAll ) == 2 )
+    {
+        return SYZYGY_DRAW;
+    }
+
+    const SyzygyTable* table = Syzygy_find( self, Syzygy_boardKey( board ) );
+
+    if ( table == NULL || ( dtz && !table->hasDtz ) )
+    {
+        *state = SYZYGY_FAIL;
+        return 0;
+    }
+
+    return Syzygy_probePosition( table, board, dtz, wdl, state );
+}
+
+int Syzygy_probePosition( const SyzygyTable* table, Board* board, bool dtz, int wdl, enum SyzygyState* state )
+{
+    unsigned long squares[ SYZYGY_MAX_PIECES ];
+    unsigned char pieces[ SYZYGY_MAX_PIECES ];
+    int size = 0;
+    int leadPawnCount = 0;
+    unsigned long long leadPawns = 0;
+    int tableFile = 0;
+
+    // Tables are for white as the stronger side, and for white to move when both sides have the same pieces. Anything
+    // else is looked up with the board turned round and the colors swapped
+    const int sideToMove = board->whiteToMove ? 0 : 1;
+    const bool flip = ( table->key == table->swappedKey && sideToMove == 1 ) || Syzygy_boardKey( board ) != table->key;
+    const unsigned char flipColor = flip ? COLOR_BIT : 0;
+    const unsigned long flipSquares = flip ? 56 : 0;
+    const int side = ( flip ? 1 : 0 ) ^ sideToMove;
+
+    // With pawns there is a part of the table for each file of the leading pawn, the one nearest the edge and then
+    // the furthest back, from a to d with the board mirrored if need be
+    if ( table->hasPawns )
+    {
+        const unsigned char pawn = ( dtz ? table->dtz[ 0 ].pieces[ 0 ] : table->wdl[ 0 ][ 0 ].pieces[ 0 ] ) ^ flipColor;
+        leadPawns = ( pawn & COLOR_BIT ) == 0 ? board->whitePieces.bbPawn : board->blackPieces.bbPawn;
+
+        unsigned long long bitboard = leadPawns;
+        unsigned long square;
+
+        while ( _BitScanForward64( &square, bitboard ) )
+        {
+            bitboard &= bitboard - 1;
+            squares[ size++ ] = square ^ flipSquares;
+        }
+
+        leadPawnCount = size;
+
+        int lead = 0;
+        for ( int loop = 1; loop < leadPawnCount; loop++ )
+        {
+            if ( mapPawns[ squares[ loop ] ] > mapPawns[ squares[ lead ] ] )
+            {
+                lead = loop;
+            }
+        }
+
+        const unsigned long leadSquare = squares[ lead ];
+        squares[ lead ] = squares[ 0 ];
+        squares[ 0 ] = leadSquare;
+
+        tableFile = (int) Board_fileFromIndex( leadSquare );
+        if ( tableFile > 3 )
+        {
+            tableFile = 7 - tableFile;
+        }
+    }
+
+    const SyzygyPairs* pairs = dtz ? &table->dtz[ tableFile ] : &table->wdl[ side ][ tableFile ];
+
+    // A DTZ table for the other side to move is no use. Unless both sides have the same pieces and there are no pawns,
+    // when either side will do
+    if ( dtz && ( pairs->flags & PAIRS_SIDE_TO_MOVE ) != side && !( table->key == table->swappedKey && !table->hasPawns ) )
+    {
+        *state = SYZYGY_CHANGE_SIDE;
+        return 0;
+    }
+
+    unsigned long long bitboard = ( board->whitePieces.bbAll | board->blackPieces.bbAll ) ^ leadPawns;
+    unsigned long square;
+
+    while ( _BitScanForward64( &square, bitboard ) )
+    {
+        bitboard &= bitboard - 1;
+        squares[ size ] = square ^ flipSquares;
+        pieces[ size++ ] = board->squares[ square ] ^ flipColor;
+    }
+
+    // Put the pieces in the order that the table has them in
+    for ( int loop = leadPawnCount; loop < size - 1; loop++ )
+    {
+        for ( int other = loop + 1; other < size; other++ )
+        {
+            if ( pairs->pieces[ loop ] == pieces[ other ] )
+            {
+                const unsigned char piece = pieces[ loop ];
+                pieces[ loop ] = pieces[ other ];
+                pieces[ other ] = piece;
+
+                const unsigned long otherSquare = squares[ loop ];
+                squares[ loop ] = squares[ other ];
+                squares[ other ] = otherSquare;
+                break;
+            }
+        }
+    }
+
+    // Mirror the board left to right to get the first piece on files a to d
+    if ( Board_fileFromIndex( squares[ 0 ] ) > 3 )
+    {
+        for ( int loop = 0; loop < size; loop++ )
+        {
+            squares[ loop ] ^= 7;
+        }
+    }
+
+    unsigned long long index;
+
+    if ( table->hasPawns )
+    {
+        // The leading pawn, then the others of its group in order
+        index = leadPawnIndex[ leadPawnCount ][ squares[ 0 ] ];
+
+        for ( int loop = 2; loop < leadPawnCount; loop++ )
+        {
+            const unsigned long pawnSquare = squares[ loop ];
+            int position = loop;
+
+            while ( position > 1 && mapPawns[ squares[ position - 1 ] ] > mapPawns[ pawnSquare ] )
+            {
+                squares[ position ] = squares[ position - 1 ];
+                position--;
+            }
+
+            squares[ position ] = pawnSquare;
+        }
+
+        for ( int loop = 1; loop < leadPawnCount; loop++ )
+        {
+            index += binomial[ loop ][ mapPawns[ squares[ loop ] ] ];
+        }
+    }
+    else
+    {
+        // Without pawns the board can also be mirrored top to bottom, to get the first piece on ranks 1 to 4
+        if ( Board_rankFromIndex( squares[ 0 ] ) > 3 )
+        {
+            for ( int loop = 0; loop < size; loop++ )
+            {
+                squares[ loop ] ^= 56;
+            }
+        }
+
+        // And about the a1-h8 diagonal, to get the first piece of the leading group not on it below it
+        for ( int loop = 0; loop < pairs->groupLength[ 0 ]; loop++ )
+        {
+            if ( Syzygy_offDiagonal( squares[ loop ] ) == 0 )
+            {
+                continue;
+            }
+
+            if ( Syzygy_offDiagonal( squares[ loop ] ) > 0 )
+            {
+                for ( int other = loop; other < size; other++ )
+                {
+                    squares[ other ] = ( ( squares[ other ] >> 3 ) | ( squares[ other ] << 3 ) ) & 63;
+                }
+            }
+            break;
+        }
+
+        // Three different pieces, such as the kings and a rook, are placed together. Each square after the first
+        // leaves out those already taken. Otherwise the kings alone are placed together
+        if ( table->hasUniquePieces )
+        {
+            const unsigned long adjust1 = squares[ 1 ] > squares[ 0 ] ? 1 : 0;
+            const unsigned long adjust2 = ( squares[ 2 ] > squares[ 0 ] ? 1 : 0 ) + ( squares[ 2 ] > squares[ 1 ] ? 1 : 0 );
+
+            if ( Syzygy_offDiagonal( squares[ 0 ] ) != 0 )
+            {
+                index = ( mapA1D1D4[ squares[ 0 ] ] * 63ull + ( squares[ 1 ] - adjust1 ) ) * 62 + squares[ 2 ] - adjust2;
+            }
+            else if ( Syzygy_offDiagonal( squares[ 1 ] ) != 0 )
+            {
+                index = ( 6 * 63ull + Board_rankFromIndex( squares[ 0 ] ) * 28 + mapB1H1H7[ squares[ 1 ] ] ) * 62 + squares[ 2 ] - adjust2;
+            }
+            else if ( Syzygy_offDiagonal( squares[ 2 ] ) != 0 )
+            {
+                index = 6 * 63ull * 62 + 4 * 28 * 62 +
+                        Board_rankFromIndex( squares[ 0 ] ) * 7 * 28 +
+                        ( Board_rankFromIndex( squares[ 1 ] ) - adjust1 ) * 28 +
+                        mapB1H1H7[ squares[ 2 ] ];
+            }
+            else
+            {
+                index = 6 * 63ull * 62 + 4 * 28 * 62 + 4 * 7 * 28 +
+                        Board_rankFromIndex( squares[ 0 ] ) * 7 * 6 +
+                        ( Board_rankFromIndex( squares[ 1 ] ) - adjust1 ) * 6 +
+                        ( Board_rankFromIndex( squares[ 2 ] ) - adjust2 );
+            }
+        }
+        else
+        {
+            index = mapKK[ mapA1D1D4[ squares[ 0 ] ] ][ squares[ 1 ] ];
+        }
+    }
+
+    index *= pairs->groupIndex[ 0 ];
+
+    // Then each of the other groups, with the squares of each in order and each leaving out the squares taken by the
+    // groups before it. The other side's pawns, if any, come first and can't be on the first rank
+    unsigned long* groupSquares = squares + pairs->groupLength[ 0 ];
+    bool remainingPawns = table->hasPawns && table->pawnCount[ 1 ] > 0;
+
+    for ( int group = 1; pairs->groupLength[ group ] != 0; group++ )
+    {
+        const int length = pairs->groupLength[ group ];
+
+        for ( int loop = 1; loop < length; loop++ )
+        {
+            const unsigned long groupSquare = groupSquares[ loop ];
+            int position = loop;
+
+            while ( position > 0 && groupSquares[ position - 1 ] > groupSquare )
+            {
+                groupSquares[ position ] = groupSquares[ position - 1 ];
+                position--;
+            }
+
+            groupSquares[ position ] = groupSquare;
+        }
+
+        unsigned long long groupIndex = 0;
+
+        for ( int loop = 0; loop < length; loop++ )
+        {
+            unsigned long adjust = 0;
+            for ( const unsigned long* earlier = squares; earlier < groupSquares; earlier++ )
+            {
+                adjust += groupSquares[ loop ] > *earlier ? 1 : 0;
+            }
+
+            groupIndex += binomial[ loop + 1 ][ groupSquares[ loop ] - adjust - ( remainingPawns ? 8 : 0 ) ];
+        }
+
+        remainingPawns = false;
+        index += groupIndex * pairs->groupIndex[ group ];
+        groupSquares += length;
+    }
+
+    const int value = Syzygy_decompress( pairs, index );
+
+    if ( !dtz )
+    {
+        return value - 2;
+    }
+
+    // DTZ values may be indices into the map. They are in moves rather than plies unless the flags say otherwise,
+    // and always in moves for results decided by the fifty move rule
+    const SyzygyPairs* first = &table->dtz[ tableFile ];
+    int dtzValue = value;
+
+    if ( first->flags & PAIRS_MAPPED )
+    {
+        const unsigned int mapIndex = first->mapIndex[ dtzMapOrder[ wdl + 2 ] ] + value;
+
+        if ( first->flags & PAIRS_WIDE )
+        {
+            unsigned short wide;
+            memcpy( &wide, table->dtzMap + mapIndex * sizeof( unsigned short ), sizeof( unsigned short ) );
+            dtzValue = wide;
+        }
+        else
+        {
+            dtzValue = table->dtzMap[ mapIndex ];
+        }
+    }
+
+    if ( ( wdl == SYZYGY_WIN && ( first->flags & PAIRS_WIN_PLIES ) == 0 ) ||
+         ( wdl == SYZYGY_LOSS && ( first->flags & PAIRS_LOSS_PLIES ) == 0 ) ||
+         wdl == SYZYGY_CURSED_WIN ||
+         wdl == SYZYGY_BLESSED_LOSS )
+    {
+        dtzValue *= 2;
+    }
+
+    return dtzValue + 1;
+}
+
+int Syzygy_decompress( const SyzygyPairs* pairs, unsigned long long index )
+{
+    if ( pairs->flags & PAIRS_SINGLE_VALUE )
+    {
+        return pairs->minimumSymbolLength;
+    }
+
+    // The sparse index entry nearest to the value gives a block and an offset into it. Entry k is for the value at
+    // k * span + span / 2, so the offset needs moving by how far the value is from there, which can take it into
+    // the blocks either side. Each block holds one more value than its length says
+    const unsigned long long entry = index / pairs->span;
+    const unsigned char* sparse = pairs->sparseIndex + entry * SPARSE_ENTRY_SIZE;
+
+    unsigned int block;
+    unsigned short entryOffset;
+    memcpy( &block, sparse, sizeof( unsigned int ) );
+    memcpy( &entryOffset, sparse + sizeof( unsigned int ), sizeof( unsigned short ) );
+
+    int offset = entryOffset + (int) ( index % pairs->span ) - (int) ( pairs->span / 2 );
+    unsigned short blockLength;
+
+    while ( offset < 0 )
+    {
+        memcpy( &blockLength, pairs->blockLengths + --block * sizeof( unsigned short ), sizeof( unsigned short ) );
+        offset += blockLength + 1;
+    }
+
+    memcpy( &blockLength, pairs->blockLengths + block * sizeof( unsigned short ), sizeof( unsigned short ) );
+
+    while ( offset > blockLength )
+    {
+        offset -= blockLength + 1;
+        memcpy( &blockLength, pairs->blockLengths + ++block * sizeof( unsigned short ), sizeof( unsigned short ) );
+    }
+
+    // The block is a stream of Huffman codes, most significant bit first, each for a symbol that stands for a run of
+    // values. Read codes until we get to the symbol whose run has the value in it
+    const unsigned char* pointer = pairs->data + block * pairs->blockSize;
+
+    unsigned long long buffer;
+    memcpy( &buffer, pointer, sizeof( buffer ) );
+    buffer = _byteswap_uint64( buffer );
+    pointer += sizeof( buffer );
+
+    int bufferBits = 64;
+    unsigned short symbol;
+
+    while ( true )
+    {
+        // Longer codes have lower values, so the length of the code at the top of the buffer is the first whose lowest
+        // code it is not below
+        int length = 0;
+        while ( buffer < pairs->base[ length ] )
+        {
+            length++;
+        }
+
+        unsigned short lowest;
+        memcpy( &lowest, pairs->lowestSymbols + length * sizeof( unsigned short ), sizeof( unsigned short ) );
+
+        symbol = (unsigned short) ( ( buffer - pairs->base[ length ] ) >> ( 64 - length - pairs->minimumSymbolLength ) );
+        symbol += lowest;
+
+        if ( offset < pairs->symbolLengths[ symbol ] + 1 )
+        {
+            break;
+        }
+
+        offset -= pairs->symbolLengths[ symbol ] + 1;
+
+        length += pairs->minimumSymbolLength;
+        buffer <<= length;
+        bufferBits -= length;
+
+        if ( bufferBits <= 32 )
+        {
+            unsigned int more;
+            memcpy( &more, pointer, sizeof( more ) );
+            pointer += sizeof( more );
+
+            bufferBits += 32;
+            buffer |= (unsigned long long) _byteswap_ulong( more ) << ( 64 - bufferBits );
+        }
+    }
+
+    // Then down the symbol's pairs to the value. The values of a pair's first symbol come before those of its second
+    while ( pairs->symbolLengths[ symbol ] != 0 )
+    {
+        const unsigned char* node = pairs->symbolTree + symbol * TREE_NODE_SIZE;
+        const unsigned short left = (unsigned short) ( ( ( node[ 1 ] & 0x0f ) << 8 ) | node[ 0 ] );
+
+        if ( offset < pairs->symbolLengths[ left ] + 1 )
+        {
+            symbol = left;
+        }
+        else
+        {
+            offset -= pairs->symbolLengths[ left ] + 1;
+            symbol = (unsigned short) ( ( node[ 2 ] << 4 ) | ( node[ 1 ] >> 4 ) );
+        }
+    }
+
+    const unsigned char* node = pairs->symbolTree + symbol * TREE_NODE_SIZE;
+
+    return ( ( node[ 1 ] & 0x0f ) << 8 ) | node[ 0 ];
+}
+
+int Syzygy_dtzBeforeZeroing( int wdl )
+{
+    // Just before a move that resets the count, such as a capture, is one ply from it. Results decided by the fifty
+    // move rule count on from 100
+    switch ( wdl )
+    {
+        case SYZYGY_WIN:
+            return 1;
+        case SYZYGY_CURSED_WIN:
+            return 101;
+        case SYZYGY_BLESSED_LOSS:
+            return -101;
+        case SYZYGY_LOSS:
+            return -1;
+        default:
+            return 0;
+    }
+}
+
+bool Syzygy_isCapture( Board* board, Move move )
+{
+    const unsigned long to = Move_to( move );
+
+    return board->squares[ to ] != EMPTY || ( to == board->enPassantSquare && Board_isPawn( board->squares[ Move_from( move ) ] ) );
+}
+
+bool Syzygy_isMate( Board* board )
+{
+    if ( !Board_isInCheck( board ) )
+    {
+        return false;
+    }
+
+    MoveList moveList;
+    moveList.count = 0;
+    Board_generateMoves( board, &moveList );
+
+    return moveList.count == 0;
+}
+
+int Syzygy_offDiagonal( unsigned long square )
+{
+    // Positive above the a1-h8 diagonal, negative below and zero on it
+    return (int) Board_rankFromIndex( square ) - (int) Board_fileFromIndex( square );
+}
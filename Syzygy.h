@@ -0,0 +1,223 @@
+#pragma once
+
+#include "Board.h"
+#include "RuntimeSetup.h"
+
+// The most pieces, kings included, that there are tables for
+#define SYZYGY_MAX_PIECES 7
+
+// Limits for the SyzygyProbeDepth option. Positions with as many pieces as the largest tables are only probed this
+// far from the leaves or more, as those tables are the biggest and the slowest to read
+#define SYZYGY_DEFAULT_PROBE_DEPTH 1
+#define SYZYGY_MINIMUM_PROBE_DEPTH 1
+#define SYZYGY_MAXIMUM_PROBE_DEPTH 100
+
+// Limits for the SyzygyProbeLimit option, which is the most pieces that a position can have and still be probed
+#define SYZYGY_DEFAULT_PROBE_LIMIT SYZYGY_MAX_PIECES
+#define SYZYGY_MINIMUM_PROBE_LIMIT 0
+#define SYZYGY_MAXIMUM_PROBE_LIMIT SYZYGY_MAX_PIECES
+
+// Open addressed, so at least twice as many as the two material keys of every table
+#define SYZYGY_INDEX_SIZE 8192
+
+// Codes are read from a buffer that is topped up whenever 32 bits or fewer are left in it, so can be no longer
+#define SYZYGY_MAX_SYMBOL_LENGTHS 32
+
+/// <summary>
+/// The result of a position with best play, from the side to move's point of view. A cursed win is a win that the
+/// fifty move rule turns into a draw, and a blessed loss is a loss that it saves
+/// </summary>
+enum SyzygyWdl
+{
+    SYZYGY_LOSS = -2,
+    SYZYGY_BLESSED_LOSS = -1,
+    SYZYGY_DRAW = 0,
+    SYZYGY_CURSED_WIN = 1,
+    SYZYGY_WIN = 2,
+};
+
+/// <summary>
+/// How a probe went
+/// </summary>
+enum SyzygyState
+{
+    SYZYGY_FAIL = 0,
+    SYZYGY_OK,
+
+    // A DTZ table holds only one side to move, and this position has the other
+    SYZYGY_CHANGE_SIDE,
+
+    // The best move resets the fifty move count, so the DTZ table may not hold a value for this position
+    SYZYGY_ZEROING_BEST_MOVE,
+};
+
+/// <summary>
+/// The part of a table for one side to move and, with pawns, one file of the leading pawn. The values are compressed
+/// by recursive pairing, in which each symbol stands for a pair of others and so for a run of values, and the symbols
+/// are then Huffman coded in blocks. Everything except the sizes worked out when the table is loaded points into the
+/// file itself
+/// </summary>
+typedef struct
+{
+    unsigned char flags;
+
+    // For a table in which every value is the same, the minimum length holds that value
+    unsigned char minimumSymbolLength;
+    unsigned char maximumSymbolLength;
+
+    unsigned long long blockSize;
+    unsigned int blockCount;
+    unsigned int blockLengthCount;
+
+    // The sparse index has an entry for about every span values, saying which block it is in
+    unsigned long long span;
+    unsigned long long sparseIndexCount;
+
+    const unsigned char* lowestSymbols;
+    const unsigned char* symbolTree;
+    const unsigned char* sparseIndex;
+    const unsigned char* blockLengths;
+    const unsigned char* data;
+
+    // The lowest code of each length, aligned to the top of 64 bits, so that a code can be found by comparison
+    unsigned long long base[ SYZYGY_MAX_SYMBOL_LENGTHS ];
+
+    // How many values less one each symbol stands for
+    unsigned char* symbolLengths;
+    unsigned int symbolCount;
+
+    // The order the pieces are encoded in, and how they are grouped into runs of the same piece
+    unsigned char pieces[ SYZYGY_MAX_PIECES ];
+    unsigned long long groupIndex[ SYZYGY_MAX_PIECES + 1 ];
+    int groupLength[ SYZYGY_MAX_PIECES + 1 ];
+
+    // Where the values for each result start in a DTZ table's map
+    unsigned short mapIndex[ 4 ];
+} SyzygyPairs;
+
+/// <summary>
+/// The WDL table, and the DTZ table if there is one, for one balance of material
+/// </summary>
+typedef struct
+{
+    // The material key with the pieces as named in the file, stronger side first as white, and with the colors swapped.
+    // These are the same when both sides have the same pieces
+    unsigned long long key;
+    unsigned long long swappedKey;
+
+    int pieceCount;
+    bool hasPawns;
+    bool hasUniquePieces;
+
+    // The pawns of the leading side, which is the side with fewer of them, and then of the other
+    int pawnCount[ 2 ];
+
+    void* wdlFile;
+    void* wdlMapping;
+    const unsigned char* wdlView;
+
+    void* dtzFile;
+    void* dtzMapping;
+    const unsigned char* dtzView;
+    bool hasDtz;
+
+    // Indexed by side to move and by file. DTZ tables hold only one side
+    SyzygyPairs wdl[ 2 ][ 4 ];
+    SyzygyPairs dtz[ 4 ];
+    const unsigned char* dtzMap;
+} SyzygyTable;
+
+/// <summary>
+/// The tables found on the SyzygyPath. Everything is set up when the path is set, and only read after that, so the
+/// search threads can all probe at once without locks
+/// </summary>
+struct Syzygy
+{
+    SyzygyTable* tables;
+    unsigned int tableCount;
+
+    // The most pieces in any table found
+    int largest;
+
+    // Each table's position in tables plus one, under both of its material keys, or zero
+    unsigned short index[ SYZYGY_INDEX_SIZE ];
+};
+
+// Public methods
+
+void Syzygy_initialize( struct Syzygy* self );
+void Syzygy_destroy( struct Syzygy* self );
+
+/// <summary>
+/// Open the tables in the given folders, replacing any already open
+/// </summary>
+/// <param name="self">the tables</param>
+/// <param name="path">folders separated by semicolons</param>
+/// <returns>how many tables were found</returns>
+unsigned int Syzygy_load( struct Syzygy* self, const char* path );
+
+/// <summary>
+/// Look up whether the position is won, drawn or lost. Must only be used without castling rights
+/// </summary>
+/// <param name="self">the tables</param>
+/// <param name="board">the position, which is used to make moves on and put back as it was</param>
+/// <param name="success">set to false if the tables don't cover the position</param>
+/// <returns>the SyzygyWdl result</returns>
+int Syzygy_probeWdl( const struct Syzygy* self, Board* board, bool* success );
+
+/// <summary>
+/// Look up how many plies it takes with best play before the fifty move count is reset by a capture or pawn move,
+/// positive for a win and negative for a loss, or 0 for a draw. Must only be used without castling rights
+/// </summary>
+/// <param name="self">the tables</param>
+/// <param name="board">the position, which is used to make moves on and put back as it was</param>
+/// <param name="success">set to false if the tables don't cover the position</param>
+int Syzygy_probeDtz( const struct Syzygy* self, Board* board, bool* success );
+
+/// <summary>
+/// Leave only those root moves that keep the best result that can be had with the fifty move rule in mind. With DTZ
+/// tables, wins are all kept while there is time enough to make progress, then only those that make it soonest
+/// </summary>
+/// <param name="self">the tables</param>
+/// <param name="board">the root position</param>
+/// <param name="repeated">whether the root position has been seen before since the fifty move count was reset</param>
+/// <param name="moveList">the legal moves, which are filtered</param>
+/// <param name="keepProbing">set to true if the moves left win but there were no DTZ tables to choose between them,
+/// so that the search still needs the tables to find its way</param>
+/// <returns>false if the tables don't cover the position, in which case the moves are left alone</returns>
+bool Syzygy_filterRootMoves( const struct Syzygy* self, Board* board, bool repeated, MoveList* moveList, bool* keepProbing );
+
+/// <summary>
+/// Probe a handful of positions from three to five pieces whose results are known, and report those that the
+/// tables get wrong. Positions that the loaded tables don't cover are skipped
+/// </summary>
+/// <param name="self">the tables</param>
+/// <param name="runtimeSetup">where to report to</param>
+void Syzygy_test( const struct Syzygy* self, struct RuntimeSetup* runtimeSetup );
+
+// Internal methods
+
+void Syzygy_initializeIndexTables();
+void Syzygy_addTable( struct Syzygy* self, const char* folder, const char* name );
+bool Syzygy_parseName( const char* name, int counts[ 2 ][ 7 ] );
+const unsigned char* Syzygy_map( const char* fileName, const unsigned char* magic, void** file, void** mapping, unsigned long long* size );
+void Syzygy_unmap( void* file, void* mapping, const unsigned char* view );
+bool Syzygy_setup( SyzygyTable* table, const unsigned char* data, const unsigned char* end, bool dtz );
+void Syzygy_setGroups( const SyzygyTable* table, SyzygyPairs* pairs, const int order[ 2 ], int file );
+const unsigned char* Syzygy_setSizes( SyzygyPairs* pairs, const unsigned char* data );
+unsigned char Syzygy_setSymbolLength( SyzygyPairs* pairs, unsigned int symbol, bool* visited );
+const unsigned char* Syzygy_setDtzMap( SyzygyTable* table, const unsigned char* data, int maxFile );
+unsigned long long Syzygy_materialKey( const int counts[ 2 ][ 7 ] );
+unsigned long long Syzygy_boardKey( Board* board );
+const SyzygyTable* Syzygy_find( const struct Syzygy* self, unsigned long long key );
+bool Syzygy_rankByDtz( const struct Syzygy* self, Board* board, bool repeated, const MoveList* moveList, int* ranks );
+bool Syzygy_rankByWdl( const struct Syzygy* self, Board* board, const MoveList* moveList, int* ranks );
+int Syzygy_search( const struct Syzygy* self, Board* board, bool zeroingMoves, enum SyzygyState* state );
+int Syzygy_probeDtzState( const struct Syzygy* self, Board* board, enum SyzygyState* state );
+int Syzygy_probeTable( const struct Syzygy* self, Board* board, bool dtz, int wdl, enum SyzygyState* state );
+int Syzygy_probePosition( const SyzygyTable* table, Board* board, bool dtz, int wdl, enum SyzygyState* state );
+int Syzygy_decompress( const SyzygyPairs* pairs, unsigned long long index );
+int Syzygy_dtzBeforeZeroing( int wdl );
+bool Syzygy_isCapture( Board* board, Move move );
+bool Syzygy_isMate( Board* board );
+int Syzygy_offDiagonal( unsigned long square );
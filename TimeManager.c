@@ -0,0 +1,155 @@
+#include <io.h>
+#include <ctype.h>
+#include <errno.h>
+#include <intrin.h>
+#include <memory.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "TimeManager.h"
+
+// When the number of moves to the next time control is not known, plan for this many
+#define DEFAULT_MOVES_TO_GO 30
+
+// No plan covers more moves than this, however far away the next time control is
+#define MAXIMUM_MOVES_TO_GO 50
+
+// The maximum time is at most this many times the optimum, and this share of what is left on the clock
+#define MAXIMUM_TIME_RATIO 5
+#define MAXIMUM_TIME_PERCENT 80
+
+// How the optimum time is scaled, in percent, by the number of iterations the best move has lasted
+static const int stabilityPercent[ 5 ] = { 160, 120, 100, 85, 70 };
+
+// The optimum time grows by one percent for each centipawn the score has fallen, up to this much
+#define SCORE_DROP_PERCENT_LIMIT 100
+
+// When the best move took at least this share of the nodes, it stood out clearly enough to need less time
+#define EFFORT_PERCENT 90
+#define EFFORT_SCALE_PERCENT 70
+
+void TimeManager_initialize( struct TimeManager* self, unsigned long long moveTime, unsigned long long time, unsigned long long increment, int movesToGo, unsigned long long moveOverhead )
+{
+    self->previousBestMove = NO_MOVE;
+    self->previousScore = 0;
+    self->stableIterations = 0;
+
+    if ( moveTime > 0 )
+    {
+        self->optimumTime = moveTime > moveOverhead ? moveTime - moveOverhead : 1;
+        self->maximumTime = self->optimumTime;
+        self->softLimit = self->optimumTime;
+        self->adjustable = false;
+        return;
+    }
+
+    self->adjustable = time > 0;
+
+    if ( time == 0 )
+    {
+        self->optimumTime = 0;
+        self->maximumTime = 0;
+        self->softLimit = 0;
+        return;
+    }
+
+    if ( movesToGo <= 0 )
+    {
+        movesToGo = DEFAULT_MOVES_TO_GO;
+    }
+    else if ( movesToGo > MAXIMUM_MOVES_TO_GO )
+    {
+        movesToGo = MAXIMUM_MOVES_TO_GO;
+    }
+
+    // Share out what will be on the clock over the moves planned for, including the increments to come,
+    // after putting aside the overhead for each of them
+    long long timeLeft = (long long) time + (long long) increment * ( movesToGo - 1 ) - (long long) moveOverhead * ( movesToGo + 1 );
+    if ( timeLeft < 1 )
+    {
+        timeLeft = 1;
+    }
+
+    unsigned long long optimum = (unsigned long long) timeLeft / movesToGo;
+
+    // Whatever happens, leave something on the clock
+    unsigned long long maximum = time > moveOverhead ? ( time - moveOverhead ) * MAXIMUM_TIME_PERCENT / 100 : 1;
+    if ( maximum > optimum * MAXIMUM_TIME_RATIO )
+    {
+        maximum = optimum * MAXIMUM_TIME_RATIO;
+    }
+
+    if ( maximum < 1 )
+    {
+        maximum = 1;
+    }
+
+    if ( optimum > maximum )
+    {
+        optimum = maximum;
+    }
+    else if ( optimum < 1 )
+    {
+        optimum = 1;
+    }
+
+    self->optimumTime = optimum;
+    self->maximumTime = maximum;
+    self->softLimit = self->optimumTime;
+}
+
+void TimeManager_update( struct TimeManager* self, Move bestMove, int score, unsigned long long bestMoveNodes, unsigned long long totalNodes )
+{
+    if ( bestMove == self->previousBestMove )
+    {
+        self->stableIterations++;
+    }
+    else
+    {
+        self->stableIterations = 0;
+    }
+
+    const int scoreDrop = self->previousBestMove != NO_MOVE ? self->previousScore - score : 0;
+
+    self->previousBestMove = bestMove;
+    self->previousScore = score;
+
+    if ( !self->adjustable )
+    {
+        return;
+    }
+
+    unsigned long long softLimit = self->optimumTime * stabilityPercent[ self->stableIterations < 4 ? self->stableIterations : 4 ] / 100;
+
+    if ( scoreDrop > 0 )
+    {
+        softLimit = softLimit * ( 100 + ( scoreDrop < SCORE_DROP_PERCENT_LIMIT ? scoreDrop : SCORE_DROP_PERCENT_LIMIT ) ) / 100;
+    }
+
+    if ( totalNodes > 0 && bestMoveNodes * 100 >= totalNodes * EFFORT_PERCENT )
+    {
+        softLimit = softLimit * EFFORT_SCALE_PERCENT / 100;
+    }
+
+    self->softLimit = softLimit < self->maximumTime ? softLimit : self->maximumTime;
+}
+
+bool TimeManager_isSoftLimitReached( struct TimeManager* self, unsigned long long elapsed )
+{
+    // The next iteration will take several times as long as the last one. For a fixed time per move, carry
+    // on until the time is up, as it is already spent
+    if ( self->softLimit == 0 || !self->adjustable )
+    {
+        return false;
+    }
+
+    return elapsed >= self->softLimit / 2;
+}
+
+bool TimeManager_isHardLimitReached( struct TimeManager* self, unsigned long long elapsed )
+{
+    return self->maximumTime > 0 && elapsed >= self->maximumTime;
+}
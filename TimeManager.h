@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Move.h"
+
+// Limits for the Move Overhead option, in milliseconds
+#define TM_DEFAULT_MOVE_OVERHEAD 30
+#define TM_MINIMUM_MOVE_OVERHEAD 0
+#define TM_MAXIMUM_MOVE_OVERHEAD 5000
+
+/// <summary>
+/// Decides how long to spend on a move. An optimum time is worked out from the clock at the start, then
+/// adjusted after each iteration by how settled the search looks. The maximum time is never exceeded
+/// </summary>
+struct TimeManager
+{
+    // In milliseconds, with 0 for no limit
+    unsigned long long optimumTime;
+    unsigned long long maximumTime;
+
+    // The optimum time as adjusted by the last iteration
+    unsigned long long softLimit;
+
+    // False for a fixed time per move, which is to be used in full
+    bool adjustable;
+
+    // The last iteration's best move and score, and how many iterations in a row the best move has not changed
+    Move previousBestMove;
+    int previousScore;
+    int stableIterations;
+};
+
+// Public methods
+
+/// <summary>
+/// Work out the time to spend on this move
+/// </summary>
+/// <param name="self">the time manager</param>
+/// <param name="moveTime">the fixed time for this move, or 0 to use the clock</param>
+/// <param name="time">the time left on our clock, or 0 for no limit</param>
+/// <param name="increment">the time added to our clock after each move</param>
+/// <param name="movesToGo">the number of moves to the next time control, or 0 if there are no more</param>
+/// <param name="moveOverhead">the time lost to communication on each move</param>
+void TimeManager_initialize( struct TimeManager* self, unsigned long long moveTime, unsigned long long time, unsigned long long increment, int movesToGo, unsigned long long moveOverhead );
+
+/// <summary>
+/// Adjust the time to spend after an iteration. A best move that keeps changing or a falling score calls for
+/// more time, while a best move that has held for several iterations and took most of the effort needs less
+/// </summary>
+/// <param name="self">the time manager</param>
+/// <param name="bestMove">the best move found by the iteration</param>
+/// <param name="score">its score</param>
+/// <param name="bestMoveNodes">the nodes the iteration spent on the best move</param>
+/// <param name="totalNodes">the nodes the iteration spent on all moves</param>
+void TimeManager_update( struct TimeManager* self, Move bestMove, int score, unsigned long long bestMoveNodes, unsigned long long totalNodes );
+
+/// <summary>
+/// Whether it is time to stop after an iteration, rather than start one that can't be expected to finish
+/// </summary>
+/// <param name="self">the time manager</param>
+/// <param name="elapsed">the time used so far, in milliseconds</param>
+bool TimeManager_isSoftLimitReached( struct TimeManager* self, unsigned long long elapsed );
+
+/// <summary>
+/// Whether the search must stop now, part way through an iteration or not
+/// </summary>
+/// <param name="self">the time manager</param>
+/// <param name="elapsed">the time used so far, in milliseconds</param>
+bool TimeManager_isHardLimitReached( struct TimeManager* self, unsigned long long elapsed );
@@ -0,0 +1,192 @@
+#include <io.h>
+#include <ctype.h>
+#include <errno.h>
+#include <intrin.h>
+#include <malloc.h>
+#include <memory.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "TranspositionTable.h"
+
+// Buckets are aligned to cache lines so that a probe touches exactly one line
+#define CACHE_LINE_SIZE 64
+
+// Ages are held in 6 bits and wrap around
+#define AGE_MASK 0x3f
+
+// Where the key bits are kept in an entry
+#define KEY_SHIFT 48
+
+// How many buckets to look at when estimating hashfull. Must not be more than the smallest table holds
+#define HASHFULL_SAMPLE_BUCKETS ( 1000 / TT_BUCKET_SIZE )
+
+void TranspositionTable_initialize( struct TranspositionTable* self )
+{
+    self->buckets = NULL;
+    self->bucketMask = 0;
+    self->age = 0;
+}
+
+void TranspositionTable_destroy( struct TranspositionTable* self )
+{
+    _aligned_free( self->buckets );
+
+    self->buckets = NULL;
+    self->bucketMask = 0;
+}
+
+bool TranspositionTable_resize( struct TranspositionTable* self, unsigned long long megabytes )
+{
+    // Largest power of two number of buckets that fits, so that a mask can be used in place of modulo
+    unsigned long long buckets = 1;
+    while ( buckets * 2 * sizeof( TranspositionBucket ) <= megabytes * 1024 * 1024 )
+    {
+        buckets *= 2;
+    }
+
+    // Only let go of the old table once the new one is there, so that a failure leaves a table to use
+    TranspositionBucket* allocated = _aligned_malloc( buckets * sizeof( TranspositionBucket ), CACHE_LINE_SIZE );
+    if ( allocated == NULL )
+    {
+        return false;
+    }
+
+    TranspositionTable_destroy( self );
+
+    self->buckets = allocated;
+    self->bucketMask = buckets - 1;
+
+    TranspositionTable_clear( self );
+
+    return true;
+}
+
+void TranspositionTable_clear( struct TranspositionTable* self )
+{
+    // Zeroed memory reads back as no entry at all, as BOUND_NONE is never stored
+    if ( self->buckets != NULL )
+    {
+        memset( self->buckets, 0, ( self->bucketMask + 1 ) * sizeof( TranspositionBucket ) );
+    }
+
+    self->age = 0;
+}
+
+void TranspositionTable_newSearch( struct TranspositionTable* self )
+{
+    self->age = ( self->age + 1 ) & AGE_MASK;
+}
+
+bool TranspositionTable_probe( struct TranspositionTable* self, unsigned long long key, TranspositionData* data )
+{
+    TranspositionEntry* entries = self->buckets[ key & self->bucketMask ].entries;
+    const unsigned long long keyBits = key >> KEY_SHIFT;
+
+    for ( unsigned short loop = 0; loop < TT_BUCKET_SIZE; loop++ )
+    {
+        // Read the entry once - another thread may be writing it as we look at it
+        const TranspositionEntry entry = entries[ loop ];
+
+        if ( ( entry >> KEY_SHIFT ) == keyBits && entry != 0 )
+        {
+            TranspositionTable_unpack( entry, data );
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TranspositionTable_store( struct TranspositionTable* self, unsigned long long key, Move move, int score, int depth, enum Bound bound )
+{
+    TranspositionEntry* entries = self->buckets[ key & self->bucketMask ].entries;
+    const unsigned long long keyBits = key >> KEY_SHIFT;
+
+    TranspositionEntry* replace = NULL;
+    int replaceWorth = INT_MAX;
+
+    for ( unsigned short loop = 0; loop < TT_BUCKET_SIZE; loop++ )
+    {
+        const TranspositionEntry entry = entries[ loop ];
+
+        // Same position. A deeper search of it from this search says more than a shallower bound does, so
+        // is kept. Otherwise keep its move if we haven't found a better one
+        if ( ( entry >> KEY_SHIFT ) == keyBits && entry != 0 )
+        {
+            const int entryDepth = (int) ( ( entry >> 32 ) & 0xff );
+            const unsigned char entryAge = ( entry >> 42 ) & AGE_MASK;
+
+            if ( bound != BOUND_EXACT && entryDepth > depth && entryAge == self->age )
+            {
+                return;
+            }
+
+            if ( move == NO_MOVE )
+            {
+                move = (Move) ( entry & 0xffff );
+            }
+
+            replace = &entries[ loop ];
+            break;
+        }
+
+        // Otherwise, prefer to replace the shallowest entry, treating each search it has aged through
+        // as costing a few plies of depth. Empty entries have no worth at all
+        int worth = -1;
+        if ( entry != 0 )
+        {
+            const unsigned char age = ( entry >> 42 ) & AGE_MASK;
+            worth = (int) ( ( entry >> 32 ) & 0xff ) - 4 * ( ( self->age - age ) & AGE_MASK );
+        }
+
+        if ( worth < replaceWorth )
+        {
+            replace = &entries[ loop ];
+            replaceWorth = worth;
+        }
+    }
+
+    *replace = TranspositionTable_pack( key, move, score, depth, bound, self->age );
+}
+
+int TranspositionTable_hashfull( struct TranspositionTable* self )
+{
+    int count = 0;
+
+    for ( unsigned int bucket = 0; bucket < HASHFULL_SAMPLE_BUCKETS; bucket++ )
+    {
+        for ( unsigned short loop = 0; loop < TT_BUCKET_SIZE; loop++ )
+        {
+            const TranspositionEntry entry = self->buckets[ bucket ].entries[ loop ];
+
+            if ( entry != 0 && ( ( entry >> 42 ) & AGE_MASK ) == self->age )
+            {
+                count++;
+            }
+        }
+    }
+
+    return count * 1000 / ( HASHFULL_SAMPLE_BUCKETS * TT_BUCKET_SIZE );
+}
+
+TranspositionEntry TranspositionTable_pack( unsigned long long key, Move move, int score, int depth, enum Bound bound, unsigned char age )
+{
+    return ( key >> KEY_SHIFT << KEY_SHIFT ) |
+           (unsigned long long) ( move & 0xffff ) |
+           ( (unsigned long long) (unsigned short) (short) score << 16 ) |
+           ( (unsigned long long) ( depth & 0xff ) << 32 ) |
+           ( (unsigned long long) ( bound & 0x03 ) << 40 ) |
+           ( (unsigned long long) ( age & AGE_MASK ) << 42 );
+}
+
+void TranspositionTable_unpack( TranspositionEntry entry, TranspositionData* unpacked )
+{
+    unpacked->move = (Move) ( entry & 0xffff );
+    unpacked->score = (short) ( ( entry >> 16 ) & 0xffff );
+    unpacked->depth = (int) ( ( entry >> 32 ) & 0xff );
+    unpacked->bound = (enum Bound) ( ( entry >> 40 ) & 0x03 );
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Move.h"
+
+// Size limits for the Hash option, in megabytes
+#define TT_DEFAULT_MEGABYTES 16
+#define TT_MINIMUM_MEGABYTES 1
+#define TT_MAXIMUM_MEGABYTES 131072
+
+/// <summary>
+/// What a stored score says about the true score of the position
+/// </summary>
+enum Bound
+{
+    BOUND_NONE = 0,
+    BOUND_UPPER = 1,
+    BOUND_LOWER = 2,
+    BOUND_EXACT = 3,
+};
+
+/// <summary>
+/// One transposition table entry, 8 bytes so that eight fit a 64 byte cache line. It packs the move
+/// (bits 0-15), score (16-31), depth (32-39), bound (40-41), age (42-47) and the top 16 bits of the key
+/// (48-63). The low bits of the key choose the bucket, so the top bits are enough to tell positions in
+/// the same bucket apart nearly every time. The entry is read and written as one word, so threads share
+/// it without locks and never see half of one write and half of another
+/// </summary>
+typedef unsigned long long TranspositionEntry;
+
+#define TT_BUCKET_SIZE 8
+
+/// <summary>
+/// The entries that a key can be stored in, all on one cache line
+/// </summary>
+typedef struct
+{
+    TranspositionEntry entries[ TT_BUCKET_SIZE ];
+} TranspositionBucket;
+
+/// <summary>
+/// The unpacked contents of an entry
+/// </summary>
+typedef struct
+{
+    Move move;
+    int score;
+    int depth;
+    enum Bound bound;
+} TranspositionData;
+
+struct TranspositionTable
+{
+    TranspositionBucket* buckets;
+    unsigned long long bucketMask;
+
+    // Increased at the start of each search so that entries left from earlier searches are replaced first
+    unsigned char age;
+};
+
+// Public methods
+
+void TranspositionTable_initialize( struct TranspositionTable* self );
+void TranspositionTable_destroy( struct TranspositionTable* self );
+
+/// <summary>
+/// Replace the table with an empty one of about the given size, rounded down to a power of two number of buckets
+/// </summary>
+/// <param name="self">the table</param>
+/// <param name="megabytes">the size</param>
+/// <returns>false if the memory could not be allocated, in which case the existing table is kept</returns>
+bool TranspositionTable_resize( struct TranspositionTable* self, unsigned long long megabytes );
+
+void TranspositionTable_clear( struct TranspositionTable* self );
+void TranspositionTable_newSearch( struct TranspositionTable* self );
+
+/// <summary>
+/// Look up a position
+/// </summary>
+/// <param name="self">the table</param>
+/// <param name="key">the Zobrist key of the position</param>
+/// <param name="data">set to the stored data when found</param>
+/// <returns>true if the position was found</returns>
+bool TranspositionTable_probe( struct TranspositionTable* self, unsigned long long key, TranspositionData* data );
+
+/// <summary>
+/// Store the result of searching a position, replacing the least useful entry in its bucket. An entry for
+/// the same position is kept instead if it was searched deeper, unless the new result is exact
+/// </summary>
+/// <param name="self">the table</param>
+/// <param name="key">the Zobrist key of the position</param>
+/// <param name="move">the best move, or NO_MOVE if none is known</param>
+/// <param name="score">the score, which must fit in 16 bits</param>
+/// <param name="depth">the depth searched</param>
+/// <param name="bound">what the score says about the true score</param>
+void TranspositionTable_store( struct TranspositionTable* self, unsigned long long key, Move move, int score, int depth, enum Bound bound );
+
+/// <summary>
+/// Estimate how full the table is with entries from the current search, from a sample of its entries
+/// </summary>
+/// <returns>the fullness in permill, as the UCI hashfull info expects</returns>
+int TranspositionTable_hashfull( struct TranspositionTable* self );
+
+// Internal methods
+
+TranspositionEntry TranspositionTable_pack( unsigned long long key, Move move, int score, int depth, enum Bound bound, unsigned char age );
+void TranspositionTable_unpack( TranspositionEntry entry, TranspositionData* unpacked );
@@ -4,12 +4,15 @@
 #include <intrin.h>
 #include <memory.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <threads.h>
 
 #include "Perft.h"
+#include "Search.h"
 #include "UCI.h"
 
 // Internal methods
@@ -21,14 +24,30 @@
 
 static const char* STARTPOS = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 
+// Large enough for an info line with a full length principal variation
+#define BROADCAST_BUFFER_SIZE 4096
+
 void UCI_broadcast( struct RuntimeSetup* runtimeSetup, const char* format, ... )
 {
+    // Both the input loop and the worker write output, so each line goes out in one write that
+    // can't be interleaved with the other's
+    char buffer[ BROADCAST_BUFFER_SIZE ];
+
     va_list args;
     va_start( args, format );
-    vfprintf( runtimeSetup->output, format, args );
-    fprintf( runtimeSetup->output, "\n" );
-    fflush( runtimeSetup->output );
+    int length = vsnprintf( buffer, BROADCAST_BUFFER_SIZE - 1, format, args );
     va_end( args );
+
+    if ( length < 0 || length > BROADCAST_BUFFER_SIZE - 2 )
+    {
+        length = BROADCAST_BUFFER_SIZE - 2;
+    }
+
+    buffer[ length ] = '\n';
+    buffer[ length + 1 ] = '\0';
+
+    fputs( buffer, runtimeSetup->output );
+    fflush( runtimeSetup->output );
 }
 
 // Control methods
@@ -41,6 +60,27 @@ struct UCIConfiguration* UCI_createUCIConfiguration()
     {
         // Starting position
         uci->fen = STARTPOS;
+        Board_create( &uci->board, uci->fen );
+        KeyHistory_clear( &uci->keyHistory );
+
+        TranspositionTable_initialize( &uci->transpositionTable );
+        TranspositionTable_resize( &uci->transpositionTable, TT_DEFAULT_MEGABYTES );
+
+        PawnTable_initialize( &uci->pawnTable );
+        PawnTable_resize( &uci->pawnTable, PAWN_DEFAULT_MEGABYTES );
+
+        MaterialTable_clear( &uci->materialTable );
+
+        Nnue_initialize( &uci->network );
+
+        Syzygy_initialize( &uci->tablebases );
+
+        SearchOptions_initialize( &uci->searchOptions );
+
+        uci->workerRunning = false;
+        uci->workerRuntimeSetup = NULL;
+        atomic_init( &uci->stop, false );
+        uci->perftArguments = NULL;
     }
 
     return uci;
@@ -50,6 +90,15 @@ void UCI_destroy( struct UCIConfiguration* self )
 {
     if ( self != NULL )
     {
+        // Reached at the end of the input as well as after quit, so that the result of any work still running
+        // comes out
+        UCI_finishWorker( self );
+
+        TranspositionTable_destroy( &self->transpositionTable );
+        PawnTable_destroy( &self->pawnTable );
+        Nnue_destroy( &self->network );
+        Syzygy_destroy( &self->tablebases );
+
         free( self );
     }
 }
@@ -95,6 +144,23 @@ bool UCI_uci( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup,
 
     UCI_broadcast( runtimeSetup, "id name %s", "CChess" );
     UCI_broadcast( runtimeSetup, "id author %s", "Motivesoft" );
+
+    UCI_broadcast( runtimeSetup, "option name Hash type spin default %d min %d max %d", TT_DEFAULT_MEGABYTES, TT_MINIMUM_MEGABYTES, TT_MAXIMUM_MEGABYTES );
+    UCI_broadcast( runtimeSetup, "option name PawnHash type spin default %d min %d max %d", PAWN_DEFAULT_MEGABYTES, PAWN_MINIMUM_MEGABYTES, PAWN_MAXIMUM_MEGABYTES );
+    UCI_broadcast( runtimeSetup, "option name Threads type spin default %d min 1 max %d", SEARCH_DEFAULT_THREADS, SEARCH_MAXIMUM_THREADS );
+    UCI_broadcast( runtimeSetup, "option name Ponder type check default false" );
+    UCI_broadcast( runtimeSetup, "option name EvalFile type string default <empty>" );
+    UCI_broadcast( runtimeSetup, "option name SyzygyPath type string default <empty>" );
+    UCI_broadcast( runtimeSetup, "option name SyzygyProbeDepth type spin default %d min %d max %d", SYZYGY_DEFAULT_PROBE_DEPTH, SYZYGY_MINIMUM_PROBE_DEPTH, SYZYGY_MAXIMUM_PROBE_DEPTH );
+    UCI_broadcast( runtimeSetup, "option name SyzygyProbeLimit type spin default %d min %d max %d", SYZYGY_DEFAULT_PROBE_LIMIT, SYZYGY_MINIMUM_PROBE_LIMIT, SYZYGY_MAXIMUM_PROBE_LIMIT );
+    UCI_broadcast( runtimeSetup, "option name MultiPV type spin default %d min 1 max %d", SEARCH_DEFAULT_MULTI_PV, SEARCH_MAXIMUM_MULTI_PV );
+    UCI_broadcast( runtimeSetup, "option name Move Overhead type spin default %d min %d max %d", TM_DEFAULT_MOVE_OVERHEAD, TM_MINIMUM_MOVE_OVERHEAD, TM_MAXIMUM_MOVE_OVERHEAD );
+    UCI_broadcast( runtimeSetup, "option name NullMovePruning type check default true" );
+    UCI_broadcast( runtimeSetup, "option name LateMoveReductions type check default true" );
+    UCI_broadcast( runtimeSetup, "option name ReverseFutilityPruning type check default true" );
+    UCI_broadcast( runtimeSetup, "option name FutilityPruning type check default true" );
+    UCI_broadcast( runtimeSetup, "option name LateMovePruning type check default true" );
+
     UCI_broadcast( runtimeSetup, "uciok" );
 
     return true;
@@ -134,6 +200,9 @@ bool UCI_isready( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSet
 {
     LOG_DEBUG( "Processing isready command" );
 
+    // Answered straight away, even while searching
+    UCI_broadcast( runtimeSetup, "readyok" );
+
     return true;
 }
 
@@ -141,9 +210,200 @@ bool UCI_setoption( struct UCIConfiguration* self, struct RuntimeSetup* runtimeS
 {
     LOG_DEBUG( "Processing setoption command" );
 
+    // Syntax:
+    //  setoption name <id> [value <x>]
+    //
+    // where <id> may contain spaces
+
+    // Options such as Hash can't be changed under a running search
+    UCI_finishWorker( self );
+
+    char* keyword;
+    char* name;
+    spliterate( arguments, &keyword, &name );
+
+    if ( strcmp( keyword, "name" ) != 0 )
+    {
+        LOG_ERROR( "Illegal setoption argument: %s", keyword );
+        return true;
+    }
+
+    char* value = strstr( name, " value " );
+    if ( value != NULL )
+    {
+        *value = '\0';
+        value += strlen( " value " );
+    }
+    else
+    {
+        value = name + strlen( name );
+    }
+
+    // Option names are not case sensitive
+    if ( _stricmp( name, "Hash" ) == 0 )
+    {
+        long long megabytes = atoll( value );
+        if ( megabytes < TT_MINIMUM_MEGABYTES || megabytes > TT_MAXIMUM_MEGABYTES )
+        {
+            LOG_ERROR( "Illegal Hash value: %s", value );
+        }
+        else if ( !TranspositionTable_resize( &self->transpositionTable, megabytes ) )
+        {
+            LOG_ERROR( "Failed to allocate %lld MB for the hash table", megabytes );
+        }
+    }
+    else if ( _stricmp( name, "PawnHash" ) == 0 )
+    {
+        long long megabytes = atoll( value );
+        if ( megabytes < PAWN_MINIMUM_MEGABYTES || megabytes > PAWN_MAXIMUM_MEGABYTES )
+        {
+            LOG_ERROR( "Illegal PawnHash value: %s", value );
+        }
+        else if ( !PawnTable_resize( &self->pawnTable, megabytes ) )
+        {
+            LOG_ERROR( "Failed to allocate %lld MB for the pawn hash table", megabytes );
+        }
+    }
+    else if ( _stricmp( name, "Threads" ) == 0 )
+    {
+        int threads = atoi( value );
+        if ( threads < 1 || threads > SEARCH_MAXIMUM_THREADS )
+        {
+            LOG_ERROR( "Illegal Threads value: %s", value );
+        }
+        else
+        {
+            self->searchOptions.threads = threads;
+        }
+    }
+    else if ( _stricmp( name, "MultiPV" ) == 0 )
+    {
+        int multiPv = atoi( value );
+        if ( multiPv < 1 || multiPv > SEARCH_MAXIMUM_MULTI_PV )
+        {
+            LOG_ERROR( "Illegal MultiPV value: %s", value );
+        }
+        else
+        {
+            self->searchOptions.multiPv = multiPv;
+        }
+    }
+    else if ( _stricmp( name, "Move Overhead" ) == 0 )
+    {
+        long long moveOverhead = atoll( value );
+        if ( moveOverhead < TM_MINIMUM_MOVE_OVERHEAD || moveOverhead > TM_MAXIMUM_MOVE_OVERHEAD )
+        {
+            LOG_ERROR( "Illegal Move Overhead value: %s", value );
+        }
+        else
+        {
+            self->searchOptions.moveOverhead = moveOverhead;
+        }
+    }
+    else if ( _stricmp( name, "Ponder" ) == 0 )
+    {
+        // Only tells us that the GUI may send go ponder, which needs no preparation
+    }
+    else if ( _stricmp( name, "EvalFile" ) == 0 )
+    {
+        // Without a network, the hand written evaluation is used
+        if ( strlen( value ) == 0 || strcmp( value, "<empty>" ) == 0 )
+        {
+            Nnue_destroy( &self->network );
+        }
+        else if ( !Nnue_load( &self->network, value ) )
+        {
+            LOG_ERROR( "Failed to load a network from %s", value );
+        }
+        else
+        {
+            LOG_INFO( "Loaded network from %s", value );
+        }
+    }
+    else if ( _stricmp( name, "SyzygyPath" ) == 0 )
+    {
+        // Folders separated by semicolons. Without any, the tablebases are closed
+        if ( strlen( value ) == 0 || strcmp( value, "<empty>" ) == 0 )
+        {
+            Syzygy_destroy( &self->tablebases );
+        }
+        else if ( Syzygy_load( &self->tablebases, value ) == 0 )
+        {
+            LOG_ERROR( "Failed to find any tablebases in %s", value );
+        }
+        else
+        {
+            LOG_INFO( "Found %u tablebases of up to %d pieces in %s", self->tablebases.tableCount, self->tablebases.largest, value );
+        }
+    }
+    else if ( _stricmp( name, "SyzygyProbeDepth" ) == 0 )
+    {
+        int probeDepth = atoi( value );
+        if ( probeDepth < SYZYGY_MINIMUM_PROBE_DEPTH || probeDepth > SYZYGY_MAXIMUM_PROBE_DEPTH )
+        {
+            LOG_ERROR( "Illegal SyzygyProbeDepth value: %s", value );
+        }
+        else
+        {
+            self->searchOptions.syzygyProbeDepth = probeDepth;
+        }
+    }
+    else if ( _stricmp( name, "SyzygyProbeLimit" ) == 0 )
+    {
+        int probeLimit = atoi( value );
+        if ( probeLimit < SYZYGY_MINIMUM_PROBE_LIMIT || probeLimit > SYZYGY_MAXIMUM_PROBE_LIMIT )
+        {
+            LOG_ERROR( "Illegal SyzygyProbeLimit value: %s", value );
+        }
+        else
+        {
+            self->searchOptions.syzygyProbeLimit = probeLimit;
+        }
+    }
+    else if ( _stricmp( name, "NullMovePruning" ) == 0 )
+    {
+        UCI_setCheckOption( runtimeSetup, name, value, &self->searchOptions.nullMovePruning );
+    }
+    else if ( _stricmp( name, "LateMoveReductions" ) == 0 )
+    {
+        UCI_setCheckOption( runtimeSetup, name, value, &self->searchOptions.lateMoveReductions );
+    }
+    else if ( _stricmp( name, "ReverseFutilityPruning" ) == 0 )
+    {
+        UCI_setCheckOption( runtimeSetup, name, value, &self->searchOptions.reverseFutilityPruning );
+    }
+    else if ( _stricmp( name, "FutilityPruning" ) == 0 )
+    {
+        UCI_setCheckOption( runtimeSetup, name, value, &self->searchOptions.futilityPruning );
+    }
+    else if ( _stricmp( name, "LateMovePruning" ) == 0 )
+    {
+        UCI_setCheckOption( runtimeSetup, name, value, &self->searchOptions.lateMovePruning );
+    }
+    else
+    {
+        LOG_WARN( "Unrecognised option: %s", name );
+    }
+
     return true;
 }
 
+void UCI_setCheckOption( struct RuntimeSetup* runtimeSetup, const char* name, const char* value, bool* option )
+{
+    if ( _stricmp( value, "true" ) == 0 )
+    {
+        *option = true;
+    }
+    else if ( _stricmp( value, "false" ) == 0 )
+    {
+        *option = false;
+    }
+    else
+    {
+        LOG_ERROR( "Illegal %s value: %s", name, value );
+    }
+}
+
 bool UCI_register( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup, char* arguments )
 {
     LOG_DEBUG( "Processing register command" );
@@ -155,6 +415,18 @@ bool UCI_ucinewgame( struct UCIConfiguration* self, struct RuntimeSetup* runtime
 {
     LOG_DEBUG( "Processing ucinewgame command" );
 
+    UCI_finishWorker( self );
+
+    // A GUI should follow this with a position command, but don't leave the last game's position
+    // behind if it doesn't
+    self->fen = STARTPOS;
+    Board_create( &self->board, self->fen );
+    KeyHistory_clear( &self->keyHistory );
+
+    // Results from the last game would only mislead the search, and waste space
+    TranspositionTable_clear( &self->transpositionTable );
+    PawnTable_clear( &self->pawnTable );
+
     return true;
 }
 
@@ -162,6 +434,72 @@ bool UCI_position( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSe
 {
     LOG_DEBUG( "Processing position command" );
 
+    // Syntax:
+    //  position startpos [moves <move1> ... <movei>]
+    //  position fen <fenstring> [moves <move1> ... <movei>]
+
+    char* keyword;
+    char* remainder;
+    spliterate( arguments, &keyword, &remainder );
+
+    // Separate the moves, if any, from the rest so that the FEN is all that remains
+    char* moves = strstr( remainder, "moves" );
+    if ( moves != NULL )
+    {
+        *moves = '\0';
+        moves += strlen( "moves" );
+    }
+
+    Board board;
+    KeyHistory keyHistory;
+    KeyHistory_clear( &keyHistory );
+
+    if ( strcmp( keyword, "startpos" ) == 0 )
+    {
+        Board_create( &board, STARTPOS );
+    }
+    else if ( strcmp( keyword, "fen" ) == 0 )
+    {
+        if ( strlen( trim( remainder ) ) == 0 )
+        {
+            LOG_ERROR( "Missing FEN string" );
+            return true;
+        }
+
+        Board_create( &board, remainder );
+    }
+    else
+    {
+        LOG_ERROR( "Illegal position argument: %s", keyword );
+        return true;
+    }
+
+    if ( moves != NULL )
+    {
+        char* move;
+        spliterate( moves, &move, &moves );
+
+        Undo undo;
+        while ( strlen( move ) > 0 )
+        {
+            Move legalMove = Board_parseMove( &board, move );
+            if ( legalMove == NO_MOVE )
+            {
+                // Keep the position as it was before the bad move rather than discard the whole command
+                LOG_ERROR( "Illegal move in position command: %s", move );
+                break;
+            }
+
+            KeyHistory_push( &keyHistory, board.key );
+            Board_makeMove( &board, legalMove, &undo );
+
+            spliterate( moves, &move, &moves );
+        }
+    }
+
+    Board_copy( &board, &self->board );
+    memcpy( &self->keyHistory, &keyHistory, sizeof( KeyHistory ) );
+
     return true;
 }
 
@@ -169,6 +507,82 @@ bool UCI_go( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup, c
 {
     LOG_DEBUG( "Processing go command" );
 
+    // Syntax:
+    //  go [depth <d>] [nodes <n>] [movetime <ms>] [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <m>] [infinite]
+
+    // Finish any search in progress before changing what the worker reads
+    UCI_finishWorker( self );
+
+    struct SearchLimits limits;
+    SearchLimits_initialize( &limits );
+
+    char* keyword;
+    char* remainder;
+    spliterate( arguments, &keyword, &remainder );
+
+    while ( strlen( keyword ) > 0 )
+    {
+        if ( strcmp( keyword, "infinite" ) == 0 )
+        {
+            limits.infinite = true;
+        }
+        else if ( strcmp( keyword, "ponder" ) == 0 )
+        {
+            limits.ponder = true;
+        }
+        else
+        {
+            char* value;
+            spliterate( remainder, &value, &remainder );
+
+            if ( strcmp( keyword, "depth" ) == 0 )
+            {
+                limits.depth = atoi( value );
+            }
+            else if ( strcmp( keyword, "nodes" ) == 0 )
+            {
+                limits.nodes = strtoull( value, NULL, 10 );
+            }
+            else if ( strcmp( keyword, "movetime" ) == 0 )
+            {
+                limits.movetime = strtoull( value, NULL, 10 );
+            }
+            else if ( strcmp( keyword, "wtime" ) == 0 )
+            {
+                // Clock times can go negative if a GUI is slow to notice a loss on time
+                limits.wtime = atoll( value ) > 0 ? atoll( value ) : 1;
+            }
+            else if ( strcmp( keyword, "btime" ) == 0 )
+            {
+                limits.btime = atoll( value ) > 0 ? atoll( value ) : 1;
+            }
+            else if ( strcmp( keyword, "winc" ) == 0 )
+            {
+                limits.winc = strtoull( value, NULL, 10 );
+            }
+            else if ( strcmp( keyword, "binc" ) == 0 )
+            {
+                limits.binc = strtoull( value, NULL, 10 );
+            }
+            else if ( strcmp( keyword, "movestogo" ) == 0 )
+            {
+                limits.movestogo = atoi( value );
+            }
+            else
+            {
+                LOG_WARN( "Unsupported go argument ignored: %s", keyword );
+            }
+        }
+
+        spliterate( remainder, &keyword, &remainder );
+    }
+
+    Board_copy( &self->board, &self->searchBoard );
+    memcpy( &self->searchKeyHistory, &self->keyHistory, sizeof( KeyHistory ) );
+    self->searchLimits = limits;
+
+    UCI_startWorker( self, runtimeSetup, UCI_searchWorker );
+
     return true;
 }
 
@@ -176,6 +590,9 @@ bool UCI_stop( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup,
 {
     LOG_DEBUG( "Processing stop command" );
 
+    // The search sends bestmove as it finishes
+    UCI_stopWorker( self );
+
     return true;
 }
 
@@ -183,6 +600,13 @@ bool UCI_ponderhit( struct UCIConfiguration* self, struct RuntimeSetup* runtimeS
 {
     LOG_DEBUG( "Processing ponderhit command" );
 
+    // The opponent played the move we were pondering on, so carry on with the same search, now on our own
+    // clock. It will notice and start keeping time
+    if ( self->workerRunning )
+    {
+        atomic_store_explicit( &self->searchLimits.ponder, false, memory_order_relaxed );
+    }
+
     return true;
 }
 
@@ -190,7 +614,7 @@ bool UCI_quit( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup,
 {
     LOG_DEBUG( "Processing quit command" );
 
-    // TODO stop any current activity and threads as quickly as possible
+    UCI_stopWorker( self );
 
     return false;
 }
@@ -199,36 +623,184 @@ bool UCI_perft( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup
 {
     LOG_DEBUG( "Processing perft command" );
 
+    // Let any perft already running finish, so that scripted runs count every line
+    UCI_finishWorker( self );
+
+    // The arguments are in the input buffer, which will be reused for the next command while the worker runs
+    self->perftArguments = _strdup( arguments );
+    if ( self->perftArguments == NULL )
+    {
+        LOG_ERROR( "Failed to allocate memory for perft" );
+        return true;
+    }
+
+    UCI_startWorker( self, runtimeSetup, UCI_perftWorker );
+
+    return true;
+}
+
+bool UCI_test( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup, char* arguments )
+{
+    LOG_DEBUG( "Processing test command" );
+
+    // Syntax:
+    //  test syzygy                  - probe positions with known results in the tables found on SyzygyPath
+
+    char* keyword;
+    char* remainder;
+    spliterate( arguments, &keyword, &remainder );
+
+    if ( strcmp( keyword, "syzygy" ) == 0 )
+    {
+        Syzygy_test( &self->tablebases, runtimeSetup );
+    }
+    else
+    {
+        LOG_ERROR( "Unrecognised test: %s", keyword );
+    }
+
+    return true;
+}
+
+// Worker methods
+
+void UCI_startWorker( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup, thrd_start_t function )
+{
+    atomic_store_explicit( &self->stop, false, memory_order_relaxed );
+    self->workerRuntimeSetup = runtimeSetup;
+
+    if ( thrd_create( &self->worker, function, self ) == thrd_success )
+    {
+        self->workerRunning = true;
+    }
+    else
+    {
+        LOG_WARN( "Failed to start worker thread, running on the input thread instead" );
+        function( self );
+    }
+}
+
+void UCI_stopWorker( struct UCIConfiguration* self )
+{
+    if ( self->workerRunning )
+    {
+        atomic_store_explicit( &self->stop, true, memory_order_relaxed );
+    }
+
+    UCI_waitForWorker( self );
+}
+
+void UCI_finishWorker( struct UCIConfiguration* self )
+{
+    // A ponder or infinite search only ends when told to, so would be waited on for ever
+    if ( self->workerRunning && self->perftArguments == NULL && ( atomic_load_explicit( &self->searchLimits.ponder, memory_order_relaxed ) || self->searchLimits.infinite ) )
+    {
+        atomic_store_explicit( &self->stop, true, memory_order_relaxed );
+    }
+
+    UCI_waitForWorker( self );
+}
+
+void UCI_waitForWorker( struct UCIConfiguration* self )
+{
+    if ( self->workerRunning )
+    {
+        thrd_join( self->worker, NULL );
+        self->workerRunning = false;
+    }
+
+    free( self->perftArguments );
+    self->perftArguments = NULL;
+}
+
+int UCI_searchWorker( void* argument )
+{
+    struct UCIConfiguration* self = argument;
+
+    Search_start( self->workerRuntimeSetup, &self->searchBoard, &self->searchKeyHistory, &self->searchLimits, &self->searchOptions, &self->transpositionTable, &self->pawnTable, &self->materialTable, &self->network, &self->tablebases, &self->stop );
+
+    return 0;
+}
+
+int UCI_perftWorker( void* argument )
+{
+    struct UCIConfiguration* self = argument;
+
+    UCI_runPerft( self, self->workerRuntimeSetup, self->perftArguments );
+
+    return 0;
+}
+
+void UCI_runPerft( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup, char* arguments )
+{
     // Syntax:
     //  perft [n] <fen>              - moves to depth [n] from <fen>, if supplied, or startpos otherwise
     //  perft fen [fen-with-results] - moves based on expected results provided at the end of the [fen-with-results] string
     //  perft file [filename]        - read mutliple [fen-with-results] lines from a text file and process one by one
+    //
+    // Any of these may be preceded by options:
+    //  threads [t]                  - count using [t] threads
+    //  split [s]                    - give the threads one task per position [s] plies below the root (default 1)
+    //  hash [mb]                    - keep subtree counts in a hash table of [mb] megabytes, shared by all threads (0 for none)
+
+    struct PerftOptions options;
+    PerftOptions_initialize( &options );
+    options.stop = &self->stop;
 
     // Which are we dealing with?
     char* keyword;
     char* remainder;
     spliterate( arguments, &keyword, &remainder );
 
+    unsigned long long hashSize = 0;
+
+    while ( strcmp( keyword, "threads" ) == 0 || strcmp( keyword, "split" ) == 0 || strcmp( keyword, "hash" ) == 0 )
+    {
+        char* value;
+        spliterate( remainder, &value, &remainder );
+
+        // A hash of 0 megabytes is the same as leaving it out, and counts without a table
+        if ( atoi( value ) < ( strcmp( keyword, "hash" ) == 0 ? 0 : 1 ) )
+        {
+            LOG_ERROR( "Illegal perft %s value: %s", keyword, value );
+            return;
+        }
+
+        if ( strcmp( keyword, "threads" ) == 0 )
+        {
+            options.threads = atoi( value );
+        }
+        else if ( strcmp( keyword, "split" ) == 0 )
+        {
+            options.splitDepth = atoi( value );
+        }
+        else
+        {
+            hashSize = atoll( value );
+        }
+
+        spliterate( remainder, &keyword, &remainder );
+    }
+
+    if ( !PerftOptions_setHashSize( &options, hashSize ) )
+    {
+        LOG_ERROR( "Failed to allocate %llu MB for the perft hash table", hashSize );
+        return;
+    }
+
     if ( strcmp( keyword, "file" ) == 0 )
     {
-        Perft_file( runtimeSetup, remainder );
+        Perft_file( runtimeSetup, &options, remainder );
     }
     else if ( strcmp( keyword, "fen" ) == 0 )
     {
-        Perft_fen( runtimeSetup, remainder );
+        Perft_fen( runtimeSetup, &options, remainder );
     }
     else // Assume depth and optional fen
     {
         int depth = atoi( keyword );
-        Perft_depth( runtimeSetup, depth, strlen( remainder ) > 0 ? remainder : STARTPOS, runtimeSetup->debug );
+        Perft_depth( runtimeSetup, &options, depth, strlen( remainder ) > 0 ? remainder : STARTPOS, runtimeSetup->debug );
     }
 
-    return true;
-}
-
-bool UCI_test( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup, char* arguments )
-{
-    LOG_DEBUG( "Processing test command" );
-
-    return true;
+    PerftOptions_destroy( &options );
 }
@@ -1,11 +1,58 @@
 #pragma once
 
+#include <stdatomic.h>
+#include <threads.h>
+
+#include "Board.h"
+#include "MaterialTable.h"
+#include "Nnue.h"
+#include "PawnTable.h"
 #include "RuntimeSetup.h"
+#include "Search.h"
+#include "Syzygy.h"
+#include "TranspositionTable.h"
 #include "Utility.h"
 
 struct UCIConfiguration
 {
     const char* fen;
+
+    // The position set by the last position command, that go will search from, and those that came before it
+    Board board;
+    KeyHistory keyHistory;
+
+    // Kept between searches, sized by the Hash option
+    struct TranspositionTable transpositionTable;
+
+    // Also kept between searches, sized by the PawnHash option
+    struct PawnTable pawnTable;
+
+    // What each balance of material means never changes, so this is only ever added to
+    struct MaterialTable materialTable;
+
+    // Loaded from the file named by the EvalFile option, if there is one
+    struct Nnue network;
+
+    // Opened from the folders named by the SyzygyPath option, if there are any
+    struct Syzygy tablebases;
+
+    // Set by the remaining options
+    struct SearchOptions searchOptions;
+
+    // The thread that go and perft run on, so that commands such as stop and isready can be answered
+    // while they work. Only one runs at a time
+    thrd_t worker;
+    bool workerRunning;
+    struct RuntimeSetup* workerRuntimeSetup;
+
+    // Polled by the worker, which finishes as soon as it sees this set
+    atomic_bool stop;
+
+    // Copies of what the worker was asked to do, so that later commands can't change them under it
+    Board searchBoard;
+    KeyHistory searchKeyHistory;
+    struct SearchLimits searchLimits;
+    char* perftArguments;
 };
 
 // Control methods
@@ -13,6 +60,15 @@ struct UCIConfiguration
 struct UCIConfiguration* UCI_createUCIConfiguration();
 void UCI_destroy( struct UCIConfiguration* self );
 
+// Output methods
+
+/// <summary>
+/// Write a line to the GUI
+/// </summary>
+/// <param name="runtimeSetup">holds the output stream</param>
+/// <param name="format">printf style format, without a trailing newline</param>
+void UCI_broadcast( struct RuntimeSetup* runtimeSetup, const char* format, ... );
+
 // UCI methods
 
 typedef bool ( *UciCommandHandler )( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup, char* arguments );
@@ -41,3 +97,37 @@ bool UCI_quit( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup,
 
 bool UCI_perft( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup, char* arguments );
 bool UCI_test( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup, char* arguments );
+
+// Worker methods
+
+/// <summary>
+/// Run a function on the worker thread, or on this thread if a thread cannot be started
+/// </summary>
+/// <param name="self">the UCI configuration, which is passed to the function</param>
+/// <param name="runtimeSetup">for output from the worker</param>
+/// <param name="function">what to run</param>
+void UCI_startWorker( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup, thrd_start_t function );
+
+/// <summary>
+/// Tell the worker to finish, and wait for it
+/// </summary>
+void UCI_stopWorker( struct UCIConfiguration* self );
+
+/// <summary>
+/// Wait for the worker to finish, first telling a ponder or infinite search to stop as it never would otherwise
+/// </summary>
+void UCI_finishWorker( struct UCIConfiguration* self );
+
+/// <summary>
+/// Wait for the worker to finish what it is doing in its own time
+/// </summary>
+void UCI_waitForWorker( struct UCIConfiguration* self );
+
+/// <summary>
+/// Set a check type option from its setoption value, which must be true or false
+/// </summary>
+void UCI_setCheckOption( struct RuntimeSetup* runtimeSetup, const char* name, const char* value, bool* option );
+
+int UCI_searchWorker( void* argument );
+int UCI_perftWorker( void* argument );
+void UCI_runPerft( struct UCIConfiguration* self, struct RuntimeSetup* runtimeSetup, char* arguments );
@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include "Utility.h"
 
@@ -103,3 +104,11 @@ void indexToSquare( unsigned char index, char** square )
     *square[ 1 ] = '1' + ( ( index >> 3 ) & 0b00000111 );
     *square[ 2 ] = '\0';
 }
+
+unsigned long long wallClockMilliseconds()
+{
+    struct timespec now;
+    timespec_get( &now, TIME_UTC );
+
+    return ( (unsigned long long) now.tv_sec * 1000 ) + ( now.tv_nsec / 1000000 );
+}
@@ -44,3 +44,10 @@ unsigned char squareToIndex( const char* square );
 /// <param name="index">an index (0-63)</param>
 /// <param name="square">is set to the alphanumeric square (lowercase)</param>
 void indexToSquare( unsigned char index, char** square );
+
+/// <summary>
+/// Returns the wall clock time in milliseconds. Use this, rather than clock(), to time anything that
+/// runs on more than one thread as clock() reports the processor time of all threads added together
+/// </summary>
+/// <returns>milliseconds since an arbitrary point in the past</returns>
+unsigned long long wallClockMilliseconds();